@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "AllanVariance.h"
+#include "SensorRates.h"
+
+// Static noise characterization from the live feed: while running, a worker thread drains new
+// samples from the gyro and accel ring buffers into two AllanVariance engines (one per rate).
+// Keep the device still for the whole capture.
+class AllanCapture {
+public:
+    struct Result {
+        AllanVariance::NoiseParameters gyro[3];
+        AllanVariance::NoiseParameters accel[3];
+        float seconds = 0.0f;
+        uint64_t gyroSamples = 0;
+        uint64_t accelSamples = 0;
+        uint64_t missedSamples = 0;   // Overwritten in the ring buffers before they could be read
+    };
+
+    AllanCapture(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const SensorRates& rates = SensorRates());
+    ~AllanCapture();
+
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+    Result getResult() const;
+
+private:
+    static constexpr int OCTAVES = 16;
+    static constexpr int POLL_MS = 250;
+
+    void run();
+
+    template <std::size_t Capacity>
+    void drain(const ThreadSafeRingBuffer3D<Capacity>& buffer, std::size_t& since, AllanVariance& engine);
+
+    const GyroBuffer& gyroBuffer_;
+    const AccelBuffer& accelBuffer_;
+
+    ThreadPool pool_;
+    AllanVariance gyroEngine_;
+    AllanVariance accelEngine_;
+    std::vector<float> scratch_[3];
+
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    std::size_t gyroSince_ = 0;
+    std::size_t accelSince_ = 0;
+    uint64_t missed_ = 0;
+
+    mutable std::mutex resultMtx_;
+    Result result_;
+};
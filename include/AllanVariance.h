@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util/ThreadPool.h"
+
+// Streaming overlapping Allan deviation over several channels (e.g. gyro x/y/z).
+// Each channel keeps a ring of its cumulative sum long enough for the largest cluster, plus one
+// accumulator per octave-spaced cluster size m = 2^k. Samples are processed in blocks: the
+// cumulative sums are extended per channel, then every (channel, cluster size) pair accumulates
+// its squared second differences independently, so both stages run across the thread pool.
+class AllanVariance {
+public:
+    struct Point {
+        double tau;        // Cluster time (s)
+        double deviation;  // Overlapping Allan deviation
+        uint64_t terms;    // Second differences accumulated
+    };
+
+    // Noise terms read off the Allan deviation curve, in the input units
+    struct NoiseParameters {
+        double randomWalk = 0.0;         // Angle/velocity random walk, value at tau = 1 s of the -1/2 slope
+        double biasInstability = 0.0;    // Curve minimum / 0.664
+        double rateRandomWalk = 0.0;     // Value at tau = 3 s of the +1/2 slope
+    };
+
+    AllanVariance(std::size_t channels, double sampleRate, int octaves, ThreadPool& pool);
+
+    // Append 'count' samples; data[c] points at channel c's samples
+    void addBlock(const float* const* data, std::size_t count);
+    void reset();
+
+    std::size_t channels() const { return channels_; }
+    uint64_t samples() const { return samples_; }
+    double sampleRate() const { return sampleRate_; }
+
+    std::vector<Point> deviation(std::size_t channel) const;
+    static NoiseParameters noiseParameters(const std::vector<Point>& curve);
+
+private:
+    static constexpr std::size_t MIN_CLUSTERS = 9;   // Skip cluster sizes with too few independent clusters
+
+    void processBlock(const float* const* data, std::size_t count);
+
+    std::size_t channels_;
+    double sampleRate_;
+    int octaves_;
+    ThreadPool& pool_;
+
+    std::size_t ringSize_;
+    std::size_t ringMask_;
+    std::vector<std::vector<double>> cumulative_;     // Per channel ring of running sums
+    std::vector<std::vector<double>> sumSquares_;     // [channel][octave]
+    std::vector<std::vector<uint64_t>> terms_;        // [channel][octave]
+    uint64_t samples_ = 0;
+};
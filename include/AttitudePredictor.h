@@ -0,0 +1,36 @@
+#pragma once
+#include "Config.h"
+#include "util/Structs3D.h"
+#include "ComplementaryFilter.h"
+
+using namespace Structs3D;
+
+// Extrapolates the latest fused attitude to the expected display time using the newest
+// gyro rate, so rendering does not lag fast motion by a frame plus ingestion latency.
+class AttitudePredictor {
+public:
+    AttitudePredictor(const QuaternionF& attitude, const GyroBuffer& gyroBuffer, const GyroTimesBuffer& gyroTimesBuffer,
+                      const ComplementaryFilter& filter);
+
+    // Predict the attitude 'lookahead' seconds from now. Call once per frame
+    QuaternionF predict();
+
+    float getAttitudeAge() const { return attitudeAge_; }            // Seconds since the attitude was last updated
+    float getPredictionHorizon() const { return horizon_; }          // Seconds actually extrapolated last frame
+    float getGyroTimestamp() const { return gyroTimestamp_; }        // Sensor time of the gyro sample used
+
+private:
+    const QuaternionF& attitude_;
+    const GyroBuffer& gyroBuffer_;
+    const GyroTimesBuffer& gyroTimesBuffer_;
+    const ComplementaryFilter& filter_;
+
+    bool enabled_ = true;
+    float lookahead_ = predictionLookahead;
+
+    float attitudeAge_ = 0.0f;
+    float horizon_ = 0.0f;
+    float gyroTimestamp_ = 0.0f;
+
+    friend class ImGuiPanel;
+};
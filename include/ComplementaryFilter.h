@@ -1,25 +1,127 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
 #include "Config.h"
 #include "util/Structs3D.h"
 #include "util/Math3D.h"
-#include "ComplementaryFilter.h"
+#include "MagCalibrator.h"
+#include "SensorRates.h"
+#include "util/SensorSample.h"
 
 using namespace Structs3D;
 
 class ComplementaryFilter {
 public:
-    ComplementaryFilter(QuaternionF& attitude, Vector3F& magVector);
-    void updateWithGyro(float gyroX, float gyroY, float gyroZ);
+    struct AlignmentStatus {
+        bool aligned = false;
+        bool gyroBiasEstimated = false;     // Alignment window was stationary
+        bool gyroBiasRestored = false;      // Checkpoint gyro correction kept instead of a window estimate
+        bool attitudeRestored = false;      // Checkpoint attitude kept, the alignment window agreed with it
+        float timeToAlign = 0.0f;           // Sensor seconds from first sample to valid attitude
+        float hostTimeToAlign = 0.0f;       // Wall-clock seconds from first sample to valid attitude
+        int alignments = 0;
+    };
+
+    struct Gains {
+        float kpRollPitch = KpRollPitch;
+        float kiRollPitch = KiRollPitch;
+        float kpYaw = KpYaw;
+        float kiYaw = KiYaw;
+    };
+
+    ComplementaryFilter(QuaternionF& attitude, Vector3F& magVector, const SensorRates& rates = SensorRates());
+    void updateWithGyro(float gyroX, float gyroY, float gyroZ, float timestamp);
     void updateWithAccel(float accelX, float accelY, float accelZ);
     void updateWithMag(float magX, float magY, float magZ);
 
+    // Batch form of the three updates for the samples of one USB batch or reorder release. Each
+    // block is validated in one branch-free pass, the samples are then applied in time order
+    // (mag, accel, gyro on equal timestamps, as the per-sample calls see them from a USB batch)
+    // and the attitude is published once at the end. Same result as the per-sample calls
+    void updateBatch(const SampleBlock& gyro, const SampleBlock& accel, const SampleBlock& mag);
+
+    const SensorRates& getRates() const { return rates_; }
+
+    void setGains(const Gains& gains);
+    Gains getGains() const { return {KpRollPitch_, KiRollPitch_, KpYaw_, KiYaw_}; }
+
+    // Re-enter the alignment phase, e.g. after a reconnect. Integral terms are kept unless a new bias is estimated
+    void startAlignment();
+    const AlignmentStatus& getAlignmentStatus() const { return alignmentStatus_; }
+
+    // Integral correction currently added to raw gyro readings (rad/s), i.e. the negated bias estimate
+    Vector3F getGyroCorrection() const { return Vector3F(ITermRoll_, ITermPitch_, ITermYaw_); }
+    QuaternionF getAttitude() const { return quaternion_; }
+    // Accel magnitude at rest measured by the last alignment, in the device's units (g or m/s^2);
+    // 0 until the first alignment. Safe to read from any thread
+    float getGravityMagnitude() const { return gravityMagnitude_.load(std::memory_order_relaxed); }
+
+    // Warm start from a checkpoint, seeding the next alignment: the gyro correction is kept over
+    // the window estimate, and the attitude is kept when the window agrees with it within
+    // checkpointMaxAttitudeChange (whole attitude with a mag heading, otherwise the tilt)
+    void restoreState(const QuaternionF& attitude, const Vector3F& gyroCorrection);
+    // Drop a restored state the next alignment has not used yet (another device attached)
+    void discardRestoredState() { restored_.valid = false; }
+    // Attitude after every gyro update, indexed by sensor time for attitudeAt(t) queries
+    const AttitudeHistoryBuffer& getAttitudeHistory() const { return attitudeHistory_; }
+    // Host steady_clock time (ns since epoch) of the last gyro update that moved the attitude
+    int64_t getLastAttitudeUpdateNs() const { return lastAttitudeUpdateNs_.load(std::memory_order_relaxed); }
+
+    // Sanity check limits (readings outside are rejected; TriggerCapture uses them for saturation)
+    static constexpr float MAX_GYRO_RATE = 35.0f;      // rad/s (about 2000 deg/s)
+    static constexpr float MAX_ACCEL_MAGNITUDE = 50.0f; // m/s^2 (about 5g)
+    static constexpr float MIN_ACCEL_MAGNITUDE = 0.1f;  // m/s^2 (very small but non-zero)
+    static constexpr float MAX_MAG_MAGNITUDE = 100.0f;  // μT (typical Earth field is ~50μT)
+    static constexpr float MIN_MAG_MAGNITUDE = 10.0f;   // μT (minimum reasonable field)
+
 private: 
-    bool running_;
+    SensorRates rates_;
+    float gyroDeltaT_;       // Fixed integration step, 1 / gyro rate
+    float accelDeltaT_;
+    int alignmentAccelTarget_;
+
+    bool running_ = false;   // False while aligning
+
+    // Initial alignment: average stationary accel/mag/gyro samples, then build the attitude directly
+    struct AlignmentWindow {
+        float gyroSum[3] = {0.0f, 0.0f, 0.0f};
+        float accelSum[3] = {0.0f, 0.0f, 0.0f};
+        float magSum[3] = {0.0f, 0.0f, 0.0f};
+        float accelNormSum = 0.0f;
+        int gyroCount = 0;
+        int accelCount = 0;
+        int magCount = 0;
+        bool stationary = true;
+    };
+    AlignmentWindow alignmentWindow_;
+    AlignmentStatus alignmentStatus_;
+    std::atomic<float> gravityMagnitude_{0.0f};
+
+    // Checkpoint state waiting for the next alignment (restoreState)
+    struct RestoredState {
+        bool valid = false;
+        QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+        Vector3F gyroCorrection = {0.0f, 0.0f, 0.0f};
+    };
+    RestoredState restored_;
+    int alignmentGyroSamples_ = 0;
+    int alignmentAccelSamples_ = 0;
+    std::chrono::steady_clock::time_point alignmentStart_;
+
+    void noteAlignmentSample();
+    float alignmentElapsed() const;
+    void checkAlignment();
+    void finishAlignment();
 
     Vector3F exptectedGravityWorld_ = {0.0f, 0.0f, -1.0f};
     Vector3F exptectedEastWorld_ = {0.0f, 1.0f, 0.0f};
 
     QuaternionF& attitude_;
+    std::atomic<int64_t> lastAttitudeUpdateNs_{0};
+    AttitudeHistoryBuffer attitudeHistory_;
     Vector3F& magVector_;
     QuaternionF quaternion_ = {0.0f, 1.0f, 0.0f, 0.0f};
 
@@ -28,6 +130,10 @@ private:
     float KiRollPitch_ = KiRollPitch;
     float KiYaw_ = KiYaw;
 
+    // Online hard/soft-iron calibration applied to mag readings before fusion
+    MagCalibrator magCalibrator_;
+    std::atomic<bool> magCalibrationEnabled_{MagCalibrationEnabled};   // Set from the UI thread
+
     float PTermRoll_ = 0.0f;
     float PTermPitch_ = 0.0f;
     float PTermYaw_ = 0.0f;
@@ -35,12 +141,30 @@ private:
     float ITermPitch_ = 0.0f;
     float ITermYaw_ = 0.0f;
 
-    // Sanity check limits
-    static constexpr float MAX_GYRO_RATE = 35.0f;      // rad/s (about 2000 deg/s)
-    static constexpr float MAX_ACCEL_MAGNITUDE = 50.0f; // m/s^2 (about 5g)
-    static constexpr float MIN_ACCEL_MAGNITUDE = 0.1f;  // m/s^2 (very small but non-zero)
-    static constexpr float MAX_MAG_MAGNITUDE = 100.0f;  // μT (typical Earth field is ~50μT)
-    static constexpr float MIN_MAG_MAGNITUDE = 10.0f;   // μT (minimum reasonable field)
+    // Gravity, down and east in the body frame for the current attitude
+    struct BodyReferences {
+        Vector3F gravity = {0.0f, 0.0f, 0.0f};
+        Vector3F down = {0.0f, 0.0f, 0.0f};
+        Vector3F east = {0.0f, 0.0f, 0.0f};
+    };
+    BodyReferences bodyReferences() const;
+    Vector3F toBody(const Vector3F& world) const;
+
+    // Steps shared by the per-sample and batch updates, for readings that passed the sanity checks
+    void alignWithGyro(float gyroX, float gyroY, float gyroZ);
+    void alignWithAccel(float accelX, float accelY, float accelZ);
+    void alignWithMag(float magX, float magY, float magZ);
+    void integrateGyro(float gyroX, float gyroY, float gyroZ);
+    void correctWithAccel(const Vector3F& accelVector, const Vector3F& expectedGravityBody);
+    void correctWithMag(const Vector3F& magVector, const BodyReferences& references);
+    void publishAttitude();
+
+    // updateBatch scratch, grown on demand
+    std::vector<uint8_t> gyroValid_;
+    std::vector<uint8_t> accelValid_;
+    std::vector<float> accelNorm_;
+    std::vector<float> historyTimes_;
+    std::vector<QuaternionF> historyAttitudes_;
 
     // Sanity check helper functions
     bool isValidGyroReading(float gyroX, float gyroY, float gyroZ) const;
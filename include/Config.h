@@ -1,18 +1,41 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 
 #include "util/ThreadSafeRingBuffer3D.h"
 #include "util/ThreadSafeRingBuffer.h"
+#include "util/AttitudeHistory.h"
 
 // Screen settings
 const int screenWidth = 1152;
 const int screenHeight = 648;
 const int targetFPS = 60;
 
+// Frame scheduler settings
+const int idleFPS = 10;                          // Frame rate when no data or input has arrived
+const float activeHoldSeconds = 0.5f;            // Stay at targetFPS this long after the last change
+const float attitudeRedrawThresholdDeg = 0.1f;   // Minimum attitude change that re-renders the 3D scene
+
+// Performance panel settings
+const float perfWindowSeconds = 1.0f;    // Interval over which ingestion rates and latency percentiles are computed
+constexpr int perfFrameHistory = 240;    // Frames shown in the frame-time graph
+
 // Communication mode
-const bool UseWebSocket = true;
+enum class CommunicationMode { WebSocket, USB, UDP };
+const CommunicationMode communicationMode = CommunicationMode::WebSocket;
+
+// Session read loops: C++20 coroutines, or the original chained callbacks (kept for comparison)
+enum class ReadLoop { Callback, Coroutine };
+const ReadLoop sessionReadLoop = ReadLoop::Coroutine;
 
-// Sensor frequencies
+// Serial port settings (USB mode)
+const char* const serialPortName = "";       // Empty opens the first USB serial port found (getDefaultSerialPort() if none)
+const char* const serialDeviceSerial = "";   // USB serial number to accept; empty takes the first device and sticks to it
+const unsigned int serialBaudRate = 115200;
+const float serialRetrySeconds = 0.1f;       // Wait before retrying a port that cannot be opened yet; poll interval without inotify
+const bool serialCompactEncoding = false;    // Ask the device for int16 batches (see USBSession.h); only for firmware that supports it
+
+// Default sensor frequencies (runtime rates are passed as SensorRates)
 constexpr int gyroFreq = 100;
 constexpr int accelFreq = 100;
 constexpr int magFreq = 50;
@@ -20,16 +43,92 @@ constexpr float gyroDeltaT = 1.0f / gyroFreq;
 constexpr float accelDeltaT = 1.0f / accelFreq;
 constexpr float magDeltaT = 1.0f / magFreq;
 
+// Ingestion settings
+const float reorderMaxLatency = 0.02f;   // Seconds a sample may be held to restore timestamp order across batches
+
+// UDP transport settings
+constexpr std::size_t udpBatchDatagrams = 64;     // Datagrams taken per recvmmsg call
+constexpr std::size_t udpMaxDatagram = 1500;      // Receive slot size; longer datagrams are dropped as truncated
+const int udpReceiveBufferBytes = 1 << 20;        // Socket receive buffer for bursts from many devices
+const float udpPrimaryTimeout = 2.0f;             // Seconds of silence before another device drives the app
+const float udpDeviceExpiry = 30.0f;              // Seconds of silence before a device is forgotten
+const float udpReportInterval = 5.0f;             // Seconds between per-device loss/reordering reports
+
+// Device clock synchronisation settings (timestamped wire formats)
+const float clockSyncBinSeconds = 0.5f;    // Device time per minimum-delay bin
+constexpr int clockSyncBins = 60;          // Bins in the regression window (30 s)
+constexpr int clockSyncMinBins = 4;        // Completed bins before the skew is estimated
+const float clockSyncSteerSeconds = 2.0f;  // Time constant for steering the mapping toward a new fit
+const float clockSyncMaxSlew = 0.005f;     // Largest steering rate (s/s), keeps mapped times monotonic
+const float clockSyncStepThreshold = 0.1f; // Seconds of disagreement with the fit that are stepped instead of steered
+constexpr int32_t clockSyncReorderMicros = 1000000;  // Smaller backward device time steps are reordering, not a restart
+
+// Filter checkpoint settings (warm start after a restart)
+const char* const checkpointDirectory = "checkpoints";   // One file per device; empty disables checkpoints
+const float checkpointInterval = 10.0f;                  // Seconds between saves while a device is attached
+const float checkpointMaxAge = 900.0f;                   // Older checkpoints restore only the gains
+const float checkpointMaxTemperatureDelta = 5.0f;        // deg C; a larger change since the save distrusts the gyro bias
+const float checkpointMaxAttitudeChange = 0.05f;         // rad (about 3 deg); alignment keeps a restored attitude this close
+
+// Prefilter settings
+constexpr int prefilterSections = 4;   // Biquads per sensor chain, all off (pass-through) until set in the UI
+
 // Complementary filter settings
 const float KpRollPitch = 6.0f;
 const float KiRollPitch = 0.1f;
 const float KpYaw = 4.0f;
 const float KiYaw = 0.05f;
 
+// Error-state Kalman filter settings (IMUFilterBench)
+const float eskfGyroNoiseDensity = 0.0005f;     // rad/s/sqrt(Hz), gyro white noise
+const float eskfGyroBiasWalk = 1e-4f;           // rad/s^2/sqrt(Hz), gyro bias random walk
+const float eskfAccelNoise = 0.02f;             // Std dev of the normalized gravity direction
+const float eskfAccelGate = 0.1f;               // Fraction of gravity; accel magnitudes further off are not fused
+const float eskfHeadingNoise = 0.05f;           // rad, std dev of the mag heading
+const float eskfInitialAttitudeSigma = 0.05f;   // rad, after alignment
+const float eskfInitialBiasSigma = 0.02f;       // rad/s, after alignment
+
+// Initial alignment settings
+const float alignmentAccelSeconds = 0.25f;            // Stationary accel data averaged for the initial attitude
+const float alignmentTimeout = 2.0f;                   // Seconds of sensor time before aligning without a stationary window
+const float alignmentMaxGyroRate = 0.1f;               // rad/s, faster rotation restarts the stationary window
+
+// Magnetometer calibration settings
+const bool MagCalibrationEnabled = true;   // Apply the online hard/soft-iron fit once it converges
+
+// Render-time attitude prediction settings
+const float predictionLookahead = 1.0f / targetFPS;   // Seconds past "now" to extrapolate (about one frame to the display)
+const float maxPredictionHorizon = 0.1f;              // Never extrapolate further than this in total
+const float predictionStaleAfter = 0.25f;             // Stop extrapolating when no gyro sample arrived for this long
+
+// Spectrum analyzer settings
+constexpr std::size_t spectrumFFTSize = 256;   // Samples per segment (power of two)
+const float spectrumOverlap = 0.5f;            // Fraction of each segment shared with the next
+const int spectrumAverages = 8;                // Segments in the running Welch average
+
+// Recording settings (compressed archive of the raw streams)
+const float recordGyroResolution = 1e-4f;       // rad/s, keep at or below the gyro LSB
+const float recordAccelResolution = 1e-4f;      // g
+const float recordMagResolution = 0.01f;        // uT
+const std::size_t recordBlockSamples = 1024;    // Samples per compressed block and sensor
+
+// Trigger capture settings (shock, free-fall and gyro saturation events with the data around them)
+const char* const triggerCaptureDirectory = "captures";   // Empty disables trigger capture
+const float triggerPreSeconds = 1.0f;                     // Before the trigger, at most bufferSeconds
+const float triggerPostSeconds = 1.0f;                    // After the trigger
+const float triggerFreeFallAccel = 0.3f;                  // x gravity at alignment; free fall reads less than this...
+const float triggerFreeFallSeconds = 0.05f;               // ...for at least this long
+const float triggerShockAccel = 4.0f;                     // x gravity at alignment
+const float triggerSaturationFraction = 0.95f;            // Of the filter's MAX_GYRO_RATE, on any axis
+
 // Plot settings
 static constexpr size_t MAX_PLOT_POINTS = 500;  // ImPlot downsampling threshold
 constexpr int bufferSeconds = 3;                // Length of data history to keep
 
+// Buffer storage (BufferArena): the sample histories live in hugepage-aligned chunks, not on the stack
+const PageMode bufferPageMode = PageMode::Transparent;   // Normal, Transparent or Explicit (reserved hugepages)
+const bool bufferPrefault = true;                         // Map every buffer page at startup instead of on first write
+
 // Set buffer sizes for aliases based on sensor frequencies and data history length
 constexpr std::size_t gyroBufferSize = gyroFreq * bufferSeconds;
 constexpr std::size_t accelBufferSize = accelFreq * bufferSeconds;
@@ -39,4 +138,5 @@ using AccelBuffer = ThreadSafeRingBuffer3D<accelBufferSize>;
 using MagBuffer = ThreadSafeRingBuffer3D<magBufferSize>;
 using GyroTimesBuffer = ThreadSafeRingBuffer<gyroBufferSize>;
 using AccelTimesBuffer = ThreadSafeRingBuffer<accelBufferSize>;
-using MagTimesBuffer = ThreadSafeRingBuffer<magBufferSize>;
\ No newline at end of file
+using MagTimesBuffer = ThreadSafeRingBuffer<magBufferSize>;
+using AttitudeHistoryBuffer = AttitudeHistory<gyroBufferSize>;   // One entry per gyro update
\ No newline at end of file
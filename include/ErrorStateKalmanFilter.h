@@ -0,0 +1,69 @@
+#pragma once
+#include "Config.h"
+#include "util/Structs3D.h"
+#include "util/Math3D.h"
+#include "util/Matrix.h"
+#include "SensorRates.h"
+
+using namespace Structs3D;
+
+// Error-state (multiplicative) extended Kalman filter for attitude and gyro bias. The nominal state
+// is the body-to-world quaternion and the gyro bias; the filter tracks the covariance of a 6-element
+// error state (small body-frame attitude error, bias error) that is folded back into the nominal
+// state after every measurement. Takes the same updates as ComplementaryFilter:
+//   gyro:  propagates the attitude with the bias-corrected rate and the covariance with the
+//          gyro noise and bias random walk
+//   accel: 3-axis update of the gravity direction, skipped when the magnitude is more than
+//          eskfAccelGate away from the gravity measured during alignment (linear acceleration)
+//   mag:   scalar heading update from the horizontal east direction, so a disturbed field
+//          cannot tilt roll and pitch
+// There is no online magnetometer calibration; feed calibrated readings.
+class ErrorStateKalmanFilter {
+public:
+    static constexpr std::size_t ERROR_STATES = 6;   // Attitude error (rad), gyro bias error (rad/s)
+    using Covariance = LinearAlgebra::MatrixF<ERROR_STATES, ERROR_STATES>;
+
+    explicit ErrorStateKalmanFilter(const SensorRates& rates = SensorRates());
+
+    // Same signatures as ComplementaryFilter; the gyro is integrated over the fixed gyro period
+    void updateWithGyro(float gyroX, float gyroY, float gyroZ, float timestamp);
+    void updateWithAccel(float accelX, float accelY, float accelZ);
+    void updateWithMag(float magX, float magY, float magZ);
+
+    bool isAligned() const { return aligned_; }
+    QuaternionF getAttitude() const { return quaternion_; }
+
+    // Negated bias estimate (rad/s), comparable with ComplementaryFilter::getGyroCorrection()
+    Vector3F getGyroCorrection() const { return Vector3F(-bias_[0], -bias_[1], -bias_[2]); }
+
+    // One-sigma attitude and bias uncertainty per body axis, from the covariance diagonal
+    Vector3F getAttitudeSigma() const;
+    Vector3F getBiasSigma() const;
+    const Covariance& getCovariance() const { return covariance_; }
+
+private:
+    void finishAlignment();
+    void inject(const LinearAlgebra::VectorF<ERROR_STATES>& correction);
+
+    SensorRates rates_;
+    float gyroDeltaT_;
+    int alignmentAccelTarget_;
+
+    // Alignment: average the first alignmentAccelSeconds of data, then build the attitude directly
+    bool aligned_ = false;
+    float alignmentGyroSum_[3] = {0.0f, 0.0f, 0.0f};
+    float alignmentAccelSum_[3] = {0.0f, 0.0f, 0.0f};
+    float alignmentMagSum_[3] = {0.0f, 0.0f, 0.0f};
+    float alignmentAccelNormSum_ = 0.0f;
+    int alignmentGyroCount_ = 0;
+    int alignmentAccelCount_ = 0;
+    int alignmentMagCount_ = 0;
+    bool alignmentStationary_ = true;
+
+    float gravityNorm_ = 1.0f;   // Accel magnitude at rest, in the device's units
+
+    QuaternionF quaternion_ = {1.0f, 0.0f, 0.0f, 0.0f};
+    LinearAlgebra::Vector3 bias_;
+    Covariance covariance_;
+    Covariance processNoise_;    // Per gyro step
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "util/Structs3D.h"
+
+using namespace Structs3D;
+
+// Online hard/soft-iron magnetometer calibration.
+// Fits the ellipsoid a*x^2 + b*y^2 + c*z^2 + 2d*xy + 2e*xz + 2f*yz + 2g*x + 2h*y + 2i*z = 1
+// by recursive least squares over exponentially forgotten sufficient statistics, so each
+// sample costs O(1) and no sample history is stored. The fit is re-solved every few samples.
+// addSample, correct and reset run on the sensor thread; getStatus and requestReset may be
+// called from any thread.
+class MagCalibrator {
+public:
+    struct Status {
+        bool valid = false;          // Fit is usable for correction
+        float coverage = 0.0f;       // Fraction of direction bins visited recently (0..1)
+        float residual = 1.0f;       // RMS of (|corrected| - fieldStrength) / fieldStrength
+        float fieldStrength = 0.0f;  // uT
+        std::size_t samples = 0;
+        Vector3F offset = Vector3F(0.0f, 0.0f, 0.0f);                      // Hard-iron offset (uT)
+        float softIron[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};         // Soft-iron correction matrix
+    };
+
+    MagCalibrator();
+    void addSample(float magX, float magY, float magZ);
+    Vector3F correct(float magX, float magY, float magZ) const;
+    bool isValid() const { return status_.valid; }
+    void reset();
+
+    // Snapshot published after every sample
+    Status getStatus() const;
+    // Reset before the next sample
+    void requestReset() { resetRequested_.store(true, std::memory_order_release); }
+
+private:
+    static constexpr int N = 9;                        // Ellipsoid parameters
+    static constexpr float INPUT_SCALE = 50.0f;        // uT, keeps the normal equations well conditioned
+    static constexpr double FORGETTING = 0.9995;       // Per-sample weight decay of old statistics
+    static constexpr int SOLVE_INTERVAL = 25;          // Samples between re-solves
+    static constexpr std::size_t MIN_SAMPLES = 100;
+    static constexpr float MAX_RAW_MAGNITUDE = 1000.0f;
+    static constexpr float MIN_COVERAGE = 0.5f;
+    static constexpr float MAX_RESIDUAL = 0.05f;
+    static constexpr float MAX_AXIS_RATIO = 3.0f;      // Largest/smallest ellipsoid radius
+    static constexpr float RESIDUAL_SMOOTHING = 0.02f;
+    static constexpr int AZIMUTH_BINS = 8;
+    static constexpr int ELEVATION_BINS = 4;
+    static constexpr int BINS = AZIMUTH_BINS * ELEVATION_BINS;
+    static constexpr float MIN_BIN_SHARE = 0.01f;      // Of the forgotten sample weight, for a bin to count as covered
+
+    // Sufficient statistics: upper triangle of sum(phi * phi^T) and sum(phi)
+    double normalMatrix_[N][N];
+    double normalVector_[N];
+
+    // Sample weight per direction bin, forgotten like the normal equations so coverage describes
+    // the samples the fit is made of
+    float binWeight_[BINS];
+    float totalWeight_ = 0.0f;
+    int samplesSinceSolve_ = 0;
+    float residualSquared_ = 1.0f;
+    bool haveFit_ = false;
+    Status status_;
+
+    std::atomic<bool> resetRequested_{false};
+    mutable std::mutex statusMtx_;
+    Status publishedStatus_;
+
+    void publishStatus();
+
+    void solve();
+    void updateCoverage(float x, float y, float z);
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "Config.h"
+#include "SensorRates.h"
+#include "util/Biquad.h"
+#include "util/SensorSample.h"
+
+// Per-sensor chain of low-pass/notch biquads applied to samples before they reach the ring
+// buffers and the filter. x/y/z run together in the lanes of one BiquadCascade. Chains can be
+// changed from the UI thread at any time; the ingestion thread picks the change up on its next
+// sample and ramps to the new coefficients. A sensor whose sections are all off costs nothing.
+class Prefilter {
+public:
+    enum class SectionType { Off, LowPass, Notch };
+
+    struct Section {
+        SectionType type = SectionType::Off;
+        float frequency = 10.0f;   // Hz, cutoff or notch center
+        float q = 0.707f;
+    };
+    using Chain = std::array<Section, prefilterSections>;
+
+    explicit Prefilter(const SensorRates& rates = SensorRates());
+
+    void setChain(SensorType sensor, const Chain& chain);
+    Chain getChain(SensorType sensor) const;
+
+    // Filter one sample in place (ingestion thread)
+    void apply(SensorSample& sample);
+
+    float sampleRate(SensorType sensor) const { return rates_.rate(sensor); }
+
+private:
+    using Cascade = BiquadCascade<4, prefilterSections>;   // x, y, z and one idle lane
+
+    struct Stage {
+        Cascade cascade;
+        bool active = false;
+    };
+
+    void retune(int index);
+
+    SensorRates rates_;
+    Stage stages_[3];
+    std::atomic<bool> changed_[3];
+
+    mutable std::mutex chainMtx_;
+    Chain chains_[3];
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "Config.h"
+#include "util/SensorSample.h"
+
+// Sample rates of the three sensors in Hz. The defaults are the Config.h rates the app uses;
+// code embedding the filter, prefilter or sessions passes the rates of its own devices.
+struct SensorRates {
+    float gyro = static_cast<float>(gyroFreq);
+    float accel = static_cast<float>(accelFreq);
+    float mag = static_cast<float>(magFreq);
+
+    float rate(SensorType sensor) const {
+        switch (sensor) {
+            case SensorType::Mag: return mag;
+            case SensorType::Accel: return accel;
+            case SensorType::Gyro: return gyro;
+        }
+        return gyro;
+    }
+
+    float deltaT(SensorType sensor) const { return 1.0f / rate(sensor); }
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "SensorRates.h"
+#include "util/FFTPlan.h"
+
+// Vibration spectra of the gyro and accel streams, computed on a worker thread.
+// New samples are drained from the ring buffers into a sliding window per axis; every hop of
+// (1 - spectrumOverlap) * spectrumFFTSize samples a Hann-windowed segment is transformed and
+// folded into a running Welch average of the last spectrumAverages segments.
+class SpectrumAnalyzer {
+public:
+    struct Spectrum {
+        std::vector<float> frequencies;   // Hz, bins from 0 to Nyquist
+        std::vector<float> density[3];    // Amplitude spectral density per axis (units/rtHz)
+        uint64_t segments = 0;
+    };
+
+    SpectrumAnalyzer(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const SensorRates& rates = SensorRates());
+    ~SpectrumAnalyzer();
+
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // Copy the latest averaged spectra (reuses the vectors in 'out')
+    void getGyroSpectrum(Spectrum& out) const;
+    void getAccelSpectrum(Spectrum& out) const;
+
+private:
+    static constexpr int POLL_MS = 50;
+
+    struct Stream {
+        explicit Stream(float rate);
+
+        float sampleRate;
+        std::size_t since = 0;             // Ring buffer write count already consumed
+        std::vector<float> history[3];     // Last spectrumFFTSize samples, circular
+        std::size_t position = 0;          // Oldest sample in history
+        std::size_t filled = 0;
+        std::size_t pending = 0;           // Samples since the last segment
+        std::vector<float> power[3];       // Averaged power spectral density
+        uint64_t segments = 0;
+        Spectrum published;                // Guarded by spectrumMtx_
+    };
+
+    void run();
+    template <std::size_t Capacity>
+    void drain(const ThreadSafeRingBuffer3D<Capacity>& buffer, Stream& stream);
+    void analyze(Stream& stream);
+    void publish(Stream& stream);
+    void copySpectrum(const Stream& stream, Spectrum& out) const;
+
+    const GyroBuffer& gyroBuffer_;
+    const AccelBuffer& accelBuffer_;
+
+    FFTPlan plan_;
+    std::vector<float> window_;
+    float windowPower_;                    // Sum of squared window coefficients
+    std::size_t hop_;
+    std::vector<float> re_, im_;
+    std::vector<float> scratch_[3];
+
+    Stream gyro_;
+    Stream accel_;
+
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    mutable std::mutex spectrumMtx_;
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "ComplementaryFilter.h"
+#include "SensorRates.h"
+#include "util/SensorSample.h"
+
+// Threshold rules over blocks of samples of one sensor. The per-sample measures (squared
+// magnitude, squared largest axis) and the "any sample past a threshold" test run as plain loops
+// over contiguous arrays, which the compiler vectorizes; only a block with a hit, or a rule whose
+// hold time started in an earlier block, is walked sample by sample to count how long it lasts.
+class TriggerScanner {
+public:
+    static constexpr int MAX_RULES = 8;
+
+    enum class Measure { Magnitude, LargestAxis };
+
+    struct Rule {
+        std::string name;
+        SensorType sensor;
+        Measure measure;
+        bool above;          // Fires above the threshold, otherwise below it
+        float threshold;     // Sensor units, or a multiple of gravity when perGravity
+        float holdSeconds;   // How long the condition must last; 0 fires on one sample
+        bool perGravity = false;
+    };
+
+    struct Hit {
+        std::size_t index;   // Sample that completed the rule
+        int rule;
+    };
+
+    // Free fall, shock and gyro saturation from the trigger* settings in Config.h
+    static std::vector<Rule> defaultRules();
+
+    TriggerScanner(const std::vector<Rule>& rules, const SensorRates& rates = SensorRates());
+
+    // Gravity magnitude in accel units that perGravity thresholds scale with. Those rules stay
+    // off until it is set to a positive value
+    void setGravity(float gravity);
+
+    // Scan the next n samples of 'sensor'. Hold times carry over from the previous block, and a
+    // rule fires once per episode. Returns the number of hits written (at most maxHits)
+    std::size_t scan(SensorType sensor, const float* x, const float* y, const float* z, std::size_t n,
+                     Hit* hits, std::size_t maxHits);
+
+    const std::vector<Rule>& rules() const { return rules_; }
+
+private:
+    std::vector<Rule> rules_;
+    float threshold2_[MAX_RULES];   // Squared, compared with the squared measures
+    bool enabled_[MAX_RULES];
+    int holdSamples_[MAX_RULES];
+    int run_[MAX_RULES];            // Consecutive samples meeting the rule so far
+    std::vector<float> magnitude2_;
+    std::vector<float> largestAxis2_;
+};
+
+// Captures the data around shock, free-fall and saturation events. While running, a worker thread
+// drains new samples from the ring buffers every POLL_MS (the ingestion thread does no extra
+// work) and scans gyro and accel with a TriggerScanner. When a rule fires it snapshots the last
+// triggerPreSeconds of all three sensors from the ring buffers, keeps draining until
+// triggerPostSeconds after the trigger, and writes the window to
+// <triggerCaptureDirectory>/<rule>_<date>_<time>.txt in the IMULoadGen recording format
+// ("G|A|M t x y z"), so IMUTuner and IMUFilterBench can replay it. Triggers during a capture are
+// counted, not captured again. The accel rules are multiples of the gravity magnitude the filter
+// measured at alignment, so they hold whether the device reports g or m/s^2.
+class TriggerCapture {
+public:
+    struct Stats {
+        float gravity = 0.0f;         // Accel magnitude perGravity rules are scaled by; 0 until the filter aligns
+        uint64_t scannedSamples = 0;
+        uint64_t missedSamples = 0;   // Overwritten in the ring buffers before they could be read
+        double scanNanos = 0.0;       // Total time spent in TriggerScanner::scan
+        uint64_t triggers[TriggerScanner::MAX_RULES] = {};
+        uint64_t captures = 0;
+        bool capturing = false;
+        std::string lastCapture;
+    };
+
+    TriggerCapture(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer,
+                   const GyroTimesBuffer& gyroTimesBuffer, const AccelTimesBuffer& accelTimesBuffer,
+                   const MagTimesBuffer& magTimesBuffer, const ComplementaryFilter& filter,
+                   const std::string& directory = triggerCaptureDirectory);
+    ~TriggerCapture();
+
+    // Starts scanning the samples that arrive from now on; does nothing without a directory
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    const std::vector<TriggerScanner::Rule>& getRules() const { return scanner_.rules(); }
+    Stats getStats() const;
+
+private:
+    static constexpr int POLL_MS = 50;
+    static constexpr std::size_t MAX_HITS = 64;   // Per scanned block
+
+    struct Sample {
+        float t, x, y, z;
+    };
+
+    // Samples drained from one sensor's data and times buffers, paired by write count
+    struct Stream {
+        std::size_t since = 0;    // Write count drained up to
+        std::size_t first = 0;    // Write count of x[0]
+        std::size_t count = 0;
+        std::vector<float> t, x, y, z;
+        float latest = 0.0f;            // Time of the newest drained sample
+        std::size_t captureNext = 0;    // First write count not yet in the capture
+        std::vector<Sample> captured;
+    };
+
+    struct Capture {
+        bool active = false;
+        int rule = 0;
+        float triggerTime = 0.0f;
+        float endTime = 0.0f;
+        std::chrono::steady_clock::time_point deadline;   // Written even if a sensor stops
+        uint64_t laterTriggers = 0;
+    };
+
+    void run();
+
+    template <std::size_t Capacity>
+    void drain(const ThreadSafeRingBuffer3D<Capacity>& dataBuffer, const ThreadSafeRingBuffer<Capacity>& timesBuffer, Stream& stream);
+
+    template <std::size_t Capacity>
+    void snapshot(const ThreadSafeRingBuffer3D<Capacity>& dataBuffer, const ThreadSafeRingBuffer<Capacity>& timesBuffer, Stream& stream);
+
+    void scanStream(SensorType sensor, Stream& stream);
+    void startCapture(int rule, float triggerTime);
+    void collect(Stream& stream);
+    bool captureComplete() const;
+    void writeCapture();
+
+    const GyroBuffer& gyroBuffer_;
+    const AccelBuffer& accelBuffer_;
+    const MagBuffer& magBuffer_;
+    const GyroTimesBuffer& gyroTimesBuffer_;
+    const AccelTimesBuffer& accelTimesBuffer_;
+    const MagTimesBuffer& magTimesBuffer_;
+    const ComplementaryFilter& filter_;
+    std::string directory_;
+
+    TriggerScanner scanner_;
+    Stream streams_[3];   // Indexed by SensorType
+    Capture capture_;
+
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex statsMtx_;
+    Stats stats_;
+};
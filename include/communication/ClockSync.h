@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Config.h"
+
+// Maps a device's free-running microsecond counter onto host steady_clock time, from the
+// device timestamps carried by the timestamped wire formats.
+//
+// Every message gives one point (device time d, host arrival h) with h = offset + (1 + skew) * d
+// + delay, where delay >= the path minimum. Device time is split into bins of clockSyncBinSeconds,
+// the smallest h - d in each bin is kept (minimum-delay filter, which rejects queueing and
+// scheduling jitter), and a line is fitted through the last clockSyncBins minima (windowed linear
+// regression). The mapping handed to the pipeline is steered toward each new fit at a bounded
+// rate instead of stepping, so mapped sample times never run backwards; only disagreements larger
+// than clockSyncStepThreshold (a wrong first estimate) are stepped.
+//
+// A one-way stream cannot observe the fixed part of the path delay, so mapped times (and the
+// latencies below) are relative to the fastest message seen, not to the absolute sample instant.
+class ClockSync {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        bool active = false;          // Timestamped messages are arriving
+        bool locked = false;          // Enough bins for a skew estimate
+        uint64_t messages = 0;
+        uint64_t resets = 0;          // Device clock restarts detected
+        uint64_t steps = 0;           // Mapping corrections too large to steer
+        double offset = 0.0;          // Host seconds (since epoch()) at device time 0
+        double skewPpm = 0.0;         // Device clock slow (+) or fast (-) relative to the host
+        double errorBound = 0.0;      // Seconds, largest residual of the window's minima about the fit
+        double steering = 0.0;        // Seconds the applied mapping still differs from the fit
+        float transportLatency = 0.0f;  // Mean seconds from sample time to message arrival, last second
+        float endToEndLatency = 0.0f;   // Mean seconds from sample time to release into the filter, last second
+        float endToEndMax = 0.0f;
+    };
+
+    ClockSync() = default;
+
+    // New connection: forget the previous device's clock
+    void reset();
+
+    // Record a message stamped with the device's microsecond counter and return the stamp as
+    // unwrapped device seconds (the counter wraps every ~71 minutes)
+    double observe(uint32_t deviceMicros, Clock::time_point arrival);
+
+    // Host time for a device instant, in the seconds-since-epoch() units used for sample timestamps
+    double toHostTime(double deviceSeconds) const;
+
+    // Latency accounting for a sample with a mapped timestamp leaving the reorder stage
+    void noteRelease(double timestamp, Clock::time_point now);
+
+    bool active() const;
+    Stats getStats() const;
+
+    // Common time origin for mapped timestamps from every session
+    static Clock::time_point epoch();
+    static double hostSeconds(Clock::time_point time);
+
+private:
+    struct Bin {
+        double device = 0.0;    // Device seconds of the minimum
+        double minimum = 0.0;   // Smallest host - device in the bin
+    };
+
+    void restart();
+    void fit();
+    void steer(double deviceSeconds);
+    double mapped(double deviceSeconds) const { return appliedOffset_ + appliedRate_ * deviceSeconds; }
+    void publishLatency(double now);
+
+    mutable std::mutex mtx_;
+
+    bool started_ = false;
+    uint32_t lastMicros_ = 0;
+    double deviceSeconds_ = 0.0;
+
+    std::vector<Bin> bins_;           // Completed bins, oldest first, at most clockSyncBins
+    Bin current_;
+    int64_t currentIndex_ = -1;
+
+    // Latest fit: host = fitOffset_ + fitRate_ * device
+    double fitOffset_ = 0.0;
+    double fitRate_ = 1.0;
+
+    // Mapping applied to samples, steered toward the fit
+    double appliedOffset_ = 0.0;
+    double appliedRate_ = 1.0;
+
+    // Latency accumulators, published once per second
+    double windowStart_ = 0.0;
+    double transportSum_ = 0.0;
+    uint64_t transportCount_ = 0;
+    double releaseSum_ = 0.0;
+    double releaseMax_ = 0.0;
+    uint64_t releaseCount_ = 0;
+
+    Stats stats_;
+};
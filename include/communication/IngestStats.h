@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "util/SensorSample.h"
+
+// Ingestion counters written by the io thread and read by the UI without locking: every counter is
+// a relaxed atomic that only ever grows, so a reader takes two snapshots and works with the
+// differences (the last reconnect gap is the exception: it is simply the latest value). IO-to-attitude latency (message arrival to the filter update for its sample) is kept
+// as a histogram with four buckets per octave of microseconds.
+class IngestStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int LATENCY_BUCKETS = 84;   // 1 us to ~2 s
+
+    struct Snapshot {
+        uint64_t messages = 0;        // Messages, batches or datagrams received
+        uint64_t resyncs = 0;         // Stream framing or sequence lost and re-acquired
+        uint64_t rejected = 0;        // Malformed or out-of-order messages dropped
+        uint64_t lateDrops = 0;       // Samples too late for the reorder stage
+        uint64_t samples[3] = {0, 0, 0};   // Samples fused, indexed by SensorType
+        uint64_t reconnects = 0;      // Device lost and found again
+        uint64_t lastGapMicros = 0;   // Data gap of the latest reconnect
+        uint64_t longestGapMicros = 0;
+        uint64_t latency[LATENCY_BUCKETS] = {};
+    };
+
+    void countMessage() { messages_.fetch_add(1, std::memory_order_relaxed); }
+    void countResync() { resyncs_.fetch_add(1, std::memory_order_relaxed); }
+    void countRejected() { rejected_.fetch_add(1, std::memory_order_relaxed); }
+    void countLateDrop() { lateDrops_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Data resumed after a reconnect, 'gapSeconds' after the last data before the device was lost
+    void countReconnect(double gapSeconds);
+
+    // A sample that arrived at 'arrival' has been fused at 'fused'
+    void countSample(SensorType type, Clock::time_point arrival, Clock::time_point fused);
+
+    Snapshot snapshot() const;
+
+    // Latency at the given fraction (0..1) of the counts, in seconds (upper edge of its bucket)
+    static double percentile(const uint64_t (&counts)[LATENCY_BUCKETS], double fraction);
+    static double bucketUpperSeconds(int bucket);
+
+private:
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> resyncs_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> lateDrops_{0};
+    std::atomic<uint64_t> samples_[3] = {};
+    std::atomic<uint64_t> reconnects_{0};
+    std::atomic<uint64_t> lastGapMicros_{0};
+    std::atomic<uint64_t> longestGapMicros_{0};
+    std::atomic<uint64_t> latency_[LATENCY_BUCKETS] = {};
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Config.h"
+#include "SensorRates.h"
+#include "communication/ClockSync.h"
+#include "util/SensorSample.h"
+
+// Sensor message shared by the WebSocket and UDP transports:
+//
+//   [0xAA][flags][sequence: u16, flag 0x10][device time: u32 us, flag 0x08][counts: 3 x u8, flag 0x20][floats]
+//
+// Flag bits 0x04/0x02/0x01 mark one mag/accel/gyro sample each. A batched message (0x20) instead
+// carries mag, accel and gyro sample counts and ignores those bits. Samples follow as x,y,z floats,
+// all mag samples first, then accel, then gyro. Multi-byte fields are little-endian.
+namespace MessageFormat {
+    constexpr uint8_t SYNC = 0xAA;
+    constexpr uint8_t MAG = 0x04;
+    constexpr uint8_t ACCEL = 0x02;
+    constexpr uint8_t GYRO = 0x01;
+    constexpr uint8_t TIMESTAMP = 0x08;
+    constexpr uint8_t SEQUENCE = 0x10;
+    constexpr uint8_t BATCH = 0x20;
+    constexpr int MAX_BATCH_SAMPLES = 32;   // Per sensor
+}
+
+struct SensorMessage {
+    uint8_t counts[3] = {0, 0, 0};   // Samples per sensor, indexed by SensorType
+    bool hasSequence = false;
+    uint16_t sequence = 0;
+    bool hasTimestamp = false;
+    uint32_t deviceMicros = 0;
+    const uint8_t* values = nullptr; // 3 floats per sample, unaligned
+
+    float value(std::size_t index) const {
+        float v;
+        std::memcpy(&v, values + index * sizeof(float), sizeof(float));
+        return v;
+    }
+};
+
+enum class ParseError {
+    None,
+    TooShort,
+    BadSync,
+    TooManySamples,
+    SizeMismatch
+};
+
+ParseError parseSensorMessage(const uint8_t* data, std::size_t size, SensorMessage& message);
+const char* describeParseError(ParseError error);
+
+// Assigns timestamps to the samples of one device's messages. With a device time, every sensor's
+// newest sample in the message was taken at that time and earlier ones are spaced back at the
+// sensor rates, all mapped onto host time by the ClockSync. Without one, each sensor's
+// timestamp starts at the host time of the first message (ClockSync::hostSeconds, the same
+// domain as mapped times) and advances by its sample period per sample.
+class MessageTimestamper {
+public:
+    explicit MessageTimestamper(ClockSync& clockSync, const SensorRates& rates = SensorRates())
+        : clockSync_(&clockSync) {
+        for (int s = 0; s < 3; s++) deltaT_[s] = rates.deltaT(static_cast<SensorType>(s));
+    }
+
+    // Emit the message's samples in wire order (mag, accel, gyro)
+    template <typename Emit>
+    void emit(const SensorMessage& message, std::chrono::steady_clock::time_point arrival, Emit&& emit) {
+        double deviceStamp = 0.0;
+        if (message.hasTimestamp) deviceStamp = clockSync_->observe(message.deviceMicros, arrival);
+
+        std::size_t index = 0;
+        for (int s = 0; s < 3; s++) {
+            SensorType type = static_cast<SensorType>(s);
+            int count = message.counts[s];
+            for (int i = 0; i < count; i++) {
+                double timestamp;
+                if (message.hasTimestamp) {
+                    timestamp = clockSync_->toHostTime(deviceStamp - (count - 1 - i) * deltaT_[s]);
+                } else {
+                    if (!started_) {
+                        for (double& counter : counters_) counter = ClockSync::hostSeconds(arrival);
+                        started_ = true;
+                    }
+                    counters_[s] += deltaT_[s];
+                    timestamp = counters_[s];
+                }
+                emit(SensorSample{type, message.value(index), message.value(index + 1), message.value(index + 2), timestamp});
+                index += 3;
+            }
+        }
+    }
+
+    // Advance the rate-based timestamps over a gap in the stream (e.g. a reconnect), so data after
+    // it does not continue where the data before it stopped
+    void skip(double seconds) {
+        for (double& counter : counters_) counter += seconds;
+    }
+
+    // Start the rate-based timestamps again from the next message's arrival, e.g. for a new device
+    void restart() { started_ = false; }
+
+private:
+    ClockSync* clockSync_;
+    double deltaT_[3];
+    double counters_[3] = {0.0, 0.0, 0.0};   // Summed in double: float steps of 1 ms drift after minutes
+    bool started_ = false;
+};
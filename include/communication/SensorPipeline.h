@@ -0,0 +1,73 @@
+#pragma once
+#include <boost/asio.hpp>
+
+#include "Config.h"
+#include "util/SensorSample.h"
+#include "util/ReorderBuffer.h"
+
+class ClockSync;
+class ComplementaryFilter;
+class IngestStats;
+class Prefilter;
+class SensorRecorder;
+
+// Common path from a session to the rest of the app: samples pass through a bounded-latency
+// reorder stage, are recorded raw when a recording is running, are conditioned by the
+// prefilter, and are then appended to the ring buffers and fused, in strict time order. Samples
+// with device-mapped timestamps also feed the clock synchronizer's end-to-end latency figure, and
+// every fused sample is counted in the ingestion statistics with its arrival-to-fusion latency.
+// The samples of one release are appended and fused as a block (ComplementaryFilter::updateBatch),
+// so the buffer locks, the filter's checks and the attitude publication are paid once per block.
+class SensorPipeline {
+public:
+    SensorPipeline(boost::asio::io_context& ioc,
+                   GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
+                   GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
+                   ComplementaryFilter& complementaryFilter, Prefilter& prefilter, SensorRecorder& recorder,
+                   ClockSync& clockSync, IngestStats& ingestStats);
+
+    // Queue samples from one message or batch (received at 'arrival'), then release whatever is ready
+    void push(const SensorSample& sample, ReorderBuffer::Clock::time_point arrival);
+    void release();
+    void flush();
+    // Flush, then take the next samples as a new stream (another device, another time base)
+    void restart();
+
+    const ReorderBuffer& reorderBuffer() const { return reorderBuffer_; }
+
+private:
+    static constexpr std::size_t MAX_BLOCK = 64;   // Samples per sensor fused at once
+
+    // Released samples of one sensor waiting to be fused, in time order
+    struct Block {
+        float x[MAX_BLOCK];
+        float y[MAX_BLOCK];
+        float z[MAX_BLOCK];
+        float timestamp[MAX_BLOCK];
+        ReorderBuffer::Clock::time_point arrival[MAX_BLOCK];
+        std::size_t count = 0;
+
+        SampleBlock view() const { return {x, y, z, timestamp, count}; }
+    };
+
+    void dispatch(const SensorSample& rawSample, ReorderBuffer::Clock::time_point arrival);
+    void fuse();
+    void scheduleFlush();
+
+    ReorderBuffer reorderBuffer_;
+    boost::asio::steady_timer flushTimer_;
+    bool flushPending_ = false;
+    Block blocks_[3];   // Indexed by SensorType
+
+    GyroBuffer& gyroDataBuffer_;
+    AccelBuffer& accelDataBuffer_;
+    MagBuffer& magDataBuffer_;
+    GyroTimesBuffer& gyroTimesBuffer_;
+    AccelTimesBuffer& accelTimesBuffer_;
+    MagTimesBuffer& magTimesBuffer_;
+    ComplementaryFilter& complementaryFilter_;
+    Prefilter& prefilter_;
+    SensorRecorder& recorder_;
+    ClockSync& clockSync_;
+    IngestStats& ingestStats_;
+};
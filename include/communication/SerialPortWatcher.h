@@ -0,0 +1,54 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <boost/asio/posix/stream_descriptor.hpp>
+#endif
+
+// Finds USB serial ports and reports when one (re)appears. Ports are identified by the USB serial
+// number of the device behind them, so a replugged device is found again even when it comes back
+// under another name (ttyUSB0 -> ttyUSB1). On Linux the candidates are /dev/ttyUSB* and
+// /dev/ttyACM*, serial numbers come from sysfs, and an inotify watch on /dev wakes the io thread
+// as soon as udev creates the node. On macOS the /dev/tty.usb* nodes are polled every
+// serialRetrySeconds. A fallback path outside those names (a /dev/serial/by-id link, a pty) is
+// polled and reported when it exists. Elsewhere ports cannot be listed and the fallback port is
+// reported right away, so the caller simply retries it.
+class SerialPortWatcher {
+public:
+    struct Port {
+        std::string path;
+        std::string serial;   // USB serial number, empty if the device has none or it is unknown
+    };
+
+    explicit SerialPortWatcher(boost::asio::io_context& ioc);
+    ~SerialPortWatcher();
+
+    // USB serial ports present now, sorted by path
+    static std::vector<Port> list();
+    static std::string serialNumber(const std::string& path);
+
+    // Call 'found' once, from the io thread, with the first port whose serial number is 'serial'
+    // (any port if empty), now if one is present or else when one appears, or with 'fallback' as
+    // described above. A new call replaces a pending one
+    void waitFor(const std::string& serial, const std::string& fallback, std::function<void(const Port&)> found);
+    void cancel();
+
+private:
+    bool check();
+    void poll();
+#if defined(__linux__)
+    void readEvents();
+
+    boost::asio::posix::stream_descriptor inotify_;
+    std::vector<char> events_ = std::vector<char>(4096);
+    bool reading_ = false;
+#endif
+
+    boost::asio::steady_timer pollTimer_;
+    std::string serial_;
+    std::string fallback_;
+    std::function<void(const Port&)> found_;
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Config.h"
+#include "util/Structs3D.h"
+#include "ComplementaryFilter.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
+#include "communication/MessageParser.h"
+#include "communication/SensorPipeline.h"
+#include "storage/FilterCheckpoint.h"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
+
+class Prefilter;
+class SensorRecorder;
+
+// Connectionless ingestion: many devices send MessageParser messages as datagrams to one socket.
+// No handshake or stream framing, and a lost datagram never holds up the ones behind it.
+//
+// Datagrams are demultiplexed by source address. The primary device (the first one heard, replaced
+// when it goes quiet for udpPrimaryTimeout) feeds the app's pipeline, buffers and filter; every
+// other device runs its own ComplementaryFilter and clock estimate. Messages carrying a sequence
+// number are checked for loss, reordering and duplicates per device. On Linux the socket is drained with
+// recvmmsg, up to udpBatchDatagrams datagrams per system call.
+class UDPSession : public std::enable_shared_from_this<UDPSession> {
+public:
+    UDPSession(boost::asio::io_context& ioc, unsigned short port,
+               GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
+               GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
+               ComplementaryFilter& complementaryFilter, Prefilter& prefilter,
+               SensorRecorder& recorder, ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+               const SensorRates& rates = SensorRates());
+
+    void run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Endpoint = boost::asio::ip::udp::endpoint;
+
+    struct Device {
+        Device(int id, const Endpoint& source, const SensorRates& rates)
+            : id(id), source(source), timestamper(clock, rates) {}
+
+        int id;
+        Endpoint source;
+        bool primary = false;
+        Clock::time_point lastHeard;
+
+        // Secondary devices only. The primary uses the app's clock estimate and feeds its filter
+        // through the pipeline
+        ClockSync clock;
+        MessageTimestamper timestamper;
+        QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+        Vector3F accelVector = {0.0f, 0.0f, 0.0f};
+        std::unique_ptr<ComplementaryFilter> filter;
+
+        bool sequenced = false;
+        uint16_t expectedSequence = 0;
+        uint64_t seen = 0;        // Bit i: sequence expectedSequence - 1 - i has arrived
+        uint64_t messages = 0;
+        uint64_t lost = 0;        // Sequence numbers skipped and not (yet) seen
+        uint64_t reordered = 0;   // Arrived after a later sequence number
+        uint64_t duplicates = 0;  // Sequence numbers seen before
+        uint64_t malformed = 0;
+    };
+
+    void receive();
+    void drain();
+    void handleDatagram(const uint8_t* data, std::size_t size, const Endpoint& source, Clock::time_point arrival);
+    Device& deviceFor(const Endpoint& source, Clock::time_point now);
+    void promote(Device& device);
+    bool trackSequence(Device& device, uint16_t sequence);
+    void feedSecondary(Device& device, const SensorSample& sample);
+    void report(Clock::time_point now);
+
+    boost::asio::ip::udp::socket socket_;
+    SensorPipeline pipeline_;
+    ComplementaryFilter& complementaryFilter_;
+    ClockSync& clockSync_;
+    IngestStats& ingestStats_;
+    FilterCheckpointer& checkpointer_;
+    SensorRates rates_;
+    MessageTimestamper primaryTimestamper_;   // Shared by the primaries; restarted on each promotion
+
+    std::map<Endpoint, std::unique_ptr<Device>> devices_;
+    Device* primary_ = nullptr;
+    int nextDeviceId_ = 0;
+
+    // Receive buffers: one slot of udpMaxDatagram bytes per datagram of a batch
+    std::vector<uint8_t> buffers_;
+#if defined(__linux__)
+    std::array<mmsghdr, udpBatchDatagrams> headers_;
+    std::array<iovec, udpBatchDatagrams> iovecs_;
+    std::array<sockaddr_storage, udpBatchDatagrams> addresses_;
+#endif
+
+    uint64_t syscalls_ = 0;
+    uint64_t datagrams_ = 0;
+    uint64_t truncated_ = 0;
+    Clock::time_point lastReport_;
+};
@@ -1,14 +1,52 @@
 #pragma once
 #include "Config.h"
+#include "communication/MessageParser.h"
+#include "communication/SensorPipeline.h"
+#include "communication/SerialPortWatcher.h"
+#include "SensorRates.h"
 
 #include <boost/asio.hpp>
 #include <boost/asio/serial_port.hpp>
+#include <chrono>
 #include <memory>
+#include <string>
 #include <vector>
 
 #define SYNC_BYTE 0xAA
+#define SYNC_BYTE_TIMESTAMPED 0xAB   // Batch header followed by a uint32 device timestamp in microseconds
+#define SYNC_BYTE_SCALES 0xAC        // Compact encoding: per-sensor scale and offsets for the session
+#define SYNC_BYTE_COMPACT 0xAD       // Compact encoding: batch of int16 counts
+
+// Compact encoding, for links too slow for float batches at full sensor rates. When
+// serialCompactEncoding is set, the session writes REQUEST to the device after opening the port.
+// A device without compact support ignores it and keeps sending float batches; one with it answers
+// with a scale message and then sends compact batches:
+//
+//   [0xAC]["IMUS"][mag scale][mag offset x,y,z][accel ...][gyro ...]     12 float32
+//   [0xAD][flags][mag_count][accel_count][gyro_count][device time: u32 us, flag 0x08][data]
+//
+// Data holds int16 x,y,z counts per sample, mag first, then accel, then gyro, and each value is
+// count * scale + offset. With a sensor's delta flag set, its samples after the first are int8
+// differences from the previous sample instead (3 instead of 6 bytes). The device sets it per
+// batch when every difference fits. Both formats are accepted at any time. A scale message is
+// only taken as the reply to REQUEST, once per open, so a 0xAC met while resyncing a float stream
+// cannot replace the scales; the magic guards the wait for that reply. Compact batches without
+// scales (the reply was lost in a damaged batch) make the session ask again, at most once a second
+namespace CompactFormat {
+    constexpr uint8_t REQUEST = 0xC1;       // Host to device
+    constexpr uint8_t DELTA_MAG = 0x04;
+    constexpr uint8_t DELTA_ACCEL = 0x02;
+    constexpr uint8_t DELTA_GYRO = 0x01;
+    constexpr uint8_t TIMESTAMP = 0x08;
+    constexpr uint8_t SCALES_MAGIC[4] = {'I', 'M', 'U', 'S'};
+    constexpr std::size_t SCALES_BYTES = 12 * sizeof(float);
+}
 
 class ComplementaryFilter;
+class FilterCheckpointer;
+class IngestStats;
+class Prefilter;
+class SensorRecorder;
 
 class USBSession : public std::enable_shared_from_this<USBSession> {
 private:
@@ -26,40 +64,104 @@ private:
         HEADER,
         DATA
     };
+    enum class BatchKind {
+        FLOAT,
+        SCALES,
+        COMPACT
+    };
     ReadState read_state_;
+    BatchKind batch_kind_ = BatchKind::FLOAT;
     BatchHeader current_header_ = {0, 0, 0};
+    bool timestamped_ = false;         // Current batch carries a device timestamp
+    uint32_t batch_device_micros_ = 0;
+    uint8_t compact_flags_ = 0;
+
+    // Compact encoding state, reset when the port is (re)opened and set by the device's reply to REQUEST
+    struct SensorScale {
+        float scale;
+        float offset[3];
+    };
+    SensorScale scales_[3] = {};       // Wire order: mag, accel, gyro
+    bool have_scales_ = false;
+    bool awaiting_scales_ = false;     // REQUEST written, no scale message taken yet
+    std::chrono::steady_clock::time_point last_request_;
+    bool warned_no_scales_ = false;
 
-    // Buffer for binary reading
-    std::vector<uint8_t> binary_buffer_ = std::vector<uint8_t>(200);
+    // Buffer for binary reading, large enough for the biggest batch
+    static constexpr uint8_t MAX_BATCH_SAMPLES = 7;   // Per sensor
+    std::vector<uint8_t> binary_buffer_ = std::vector<uint8_t>(MAX_BATCH_SAMPLES * 3 * 3 * sizeof(float));
+    std::vector<float> decoded_ = std::vector<float>(MAX_BATCH_SAMPLES * 3 * 3);   // Compact batch as floats
     size_t bytes_needed_;
     bool reading_header_;
     
-    // Data buffers and filters
-    GyroBuffer& gyroDataBuffer_;
-    AccelBuffer& accelDataBuffer_;
-    MagBuffer& magDataBuffer_;
-    GyroTimesBuffer& gyroTimesBuffer_;
-    AccelTimesBuffer& accelTimesBuffer_;
-    MagTimesBuffer& magTimesBuffer_;
-    ComplementaryFilter& complementaryFilter_;
+    // Reorders samples and feeds the data buffers and filter
+    SensorPipeline pipeline_;
     
-    // Timing
-    float magTimestamp_ = 0.0f;
-    float accelTimestamp_ = 0.0f;
-    float gyroTimestamp_ = 0.0f;
+    // Timing. Timestamped batches are mapped onto host time; untimestamped ones advance by the sensor rates
+    MessageTimestamper timestamper_;
+
+    // Batches, resyncs and latency for the performance panel
+    IngestStats& ingestStats_;
+
+    // Warm start for the device on this port
+    FilterCheckpointer& checkpointer_;
+    std::string device_id_;
+    bool attached_ = false;
+
+    // Hot-plug: when the port fails it is closed and the device (matched by USB serial number) is
+    // reopened as soon as it reappears. Buffers, pipeline and filter state carry over; the data gap
+    // is counted in the ingestion statistics
+    std::string port_name_;
+    std::string device_serial_;        // Sticks to the first device opened unless serialDeviceSerial is set
+    SerialPortWatcher watcher_;
+    boost::asio::steady_timer retry_timer_;
+    std::string last_open_error_;      // Repeated open failures are logged once
+    std::chrono::steady_clock::time_point last_batch_arrival_;
+    bool gap_pending_ = false;         // Lost the port after data; the next batch closes the gap
 
+    bool openPort(const std::string& portName);
+    void startReadLoop();
+    void waitForDevice();
+    void portLost(const boost::system::error_code& ec);
+
+    ReadLoop read_loop_ = sessionReadLoop;
+
+    // Callback read loop: one async_read per state, each handler holding a shared_from_this() copy
     void startReading();
     void readPacketHeader();
     void processBatch(const BatchHeader& header, const float* data);
     void readPacketData();
     void readSyncByte();
 
+    // Coroutine read loop: one coroutine holding a single session reference reads whatever the port
+    // has into a receive buffer and parses every complete batch in it, instead of one read per
+    // field. Its frame and read operation reuse asio's per-thread recycled handler memory
+    boost::asio::awaitable<void> readCoroutine();
+    void parseReceived();
+
+    std::vector<uint8_t> receive_buffer_ = std::vector<uint8_t>(4096);
+    std::size_t receive_end_ = 0;      // Unparsed bytes are [0, receive_end_)
+
+    bool isSyncByte(uint8_t byte);
+    std::size_t headerBytes() const;
+    bool parseHeader();
+    void handlePayload(const uint8_t* data);
+    void requestCompact();
+    void parseScales(const uint8_t* data);
+    void decodeCompact(const uint8_t* data);
+
 public:
+    // Opens portName if it exists; otherwise run() waits for a USB serial port to appear
     USBSession(boost::asio::io_context& ioc, const std::string& portName, 
                GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
                GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
-               ComplementaryFilter& complementaryFilter);
+               ComplementaryFilter& complementaryFilter, Prefilter& prefilter,
+               SensorRecorder& recorder, ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+               const SensorRates& rates = SensorRates());
     
     ~USBSession();
     void run();
+
+    // Choose the read loop before run() (defaults to sessionReadLoop)
+    void setReadLoop(ReadLoop readLoop) { read_loop_ = readLoop; }
 };
\ No newline at end of file
@@ -2,9 +2,17 @@
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
 #include <atomic>
+#include <optional>
 
 #include "Config.h"
 #include "ComplementaryFilter.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
+#include "communication/MessageParser.h"
+#include "communication/SensorPipeline.h"
+#include "Prefilter.h"
+#include "storage/FilterCheckpoint.h"
+#include "storage/SensorRecorder.h"
 
 namespace beast = boost::beast;
 namespace net = boost::asio;
@@ -15,30 +23,30 @@ public:
     WebSocketSession(net::io_context& ioc, unsigned short port, 
                      GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
                      GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
-                     ComplementaryFilter& complementaryFilter);
+                     ComplementaryFilter& complementaryFilter, Prefilter& prefilter,
+                     SensorRecorder& recorder, ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+                     const SensorRates& rates = SensorRates());
     
     void run();
+
+    // Choose the read loop for later connections (defaults to sessionReadLoop)
+    void setReadLoop(ReadLoop readLoop) { readLoop_ = readLoop; }
     
 private:
     void handleConnection(tcp::socket socket);
     void readLoop();
+    net::awaitable<void> readCoroutine();   // Same loop as readLoop(), one coroutine per connection
     void processMessage(size_t bytes);
 
     tcp::acceptor acceptor_;
     std::optional<beast::websocket::stream<tcp::socket>> ws_;
     beast::flat_buffer buffer_;
-
-    GyroBuffer& gyroDataBuffer_;
-    AccelBuffer& accelDataBuffer_;
-    MagBuffer& magDataBuffer_;
-
-    GyroTimesBuffer& gyroTimesBuffer_;
-    AccelTimesBuffer& accelTimesBuffer_;
-    MagTimesBuffer& magTimesBuffer_;
-
-    float gyroTimestamp_ = 0.0f;
-    float accelTimestamp_ = 0.0f;
-    float magTimestamp_ = 0.0f;
+    ReadLoop readLoop_ = sessionReadLoop;
 
     ComplementaryFilter& complementaryFilter_;
+    ClockSync& clockSync_;
+    IngestStats& ingestStats_;
+    FilterCheckpointer& checkpointer_;
+    MessageTimestamper timestamper_;
+    SensorPipeline pipeline_;
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+// MSB-first bit packing for the sensor codec. Writes and reads take 1 to 32 bits at a time.
+// The writer grows 'out' in large steps and stores whole 32-bit words; flush() trims it to
+// the bytes actually written. Do not read 'out' between flush() calls.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out), position_(out.size()) {}
+
+    void write(uint32_t value, int bits) {
+        accumulator_ = (accumulator_ << bits) | (value & mask(bits));
+        pending_ += bits;
+        if (pending_ >= 32) {
+            pending_ -= 32;
+            if (position_ + 4 > out_.size()) {
+                out_.resize(out_.size() * 2 + 64);
+            }
+            uint32_t word = byteSwap32(static_cast<uint32_t>(accumulator_ >> pending_));
+            std::memcpy(out_.data() + position_, &word, 4);
+            position_ += 4;
+        }
+    }
+
+    // Write out the remaining bits, padding the last byte with zeros
+    void flush() {
+        out_.resize(position_);
+        while (pending_ >= 8) {
+            pending_ -= 8;
+            out_.push_back(static_cast<uint8_t>(accumulator_ >> pending_));
+        }
+        if (pending_ > 0) {
+            out_.push_back(static_cast<uint8_t>(accumulator_ << (8 - pending_)));
+        }
+        accumulator_ = 0;
+        pending_ = 0;
+        position_ = out_.size();
+    }
+
+    // Continue at the current end of 'out' (after it was cleared or appended to elsewhere)
+    void rewind() {
+        accumulator_ = 0;
+        pending_ = 0;
+        position_ = out_.size();
+    }
+
+private:
+    static uint64_t mask(int bits) { return (uint64_t(1) << bits) - 1; }
+
+    static uint32_t byteSwap32(uint32_t value) {
+#if defined(_MSC_VER)
+        return _byteswap_ulong(value);
+#else
+        return __builtin_bswap32(value);
+#endif
+    }
+
+    std::vector<uint8_t>& out_;
+    std::size_t position_;
+    uint64_t accumulator_ = 0;
+    int pending_ = 0;
+};
+
+// Reads through a 64-bit window that is refilled a whole word at a time where possible.
+// Reading past the end yields zero bits; callers check overrun() once per column.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+    uint32_t read(int bits) {
+        if (available_ < bits) refill();
+        uint32_t value = static_cast<uint32_t>(window_ >> (64 - bits));
+        window_ <<= bits;
+        available_ -= bits;
+        return value;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+    // Consume and count the run of zero bits at the read position, stopping after 'limit' (<= 56)
+    int skipZeros(int limit) {
+        if (available_ < limit) refill();
+        int zeros = window_ == 0 ? 64 : countLeadingZeros(window_);
+        if (zeros > limit) zeros = limit;
+        window_ <<= zeros;
+        available_ -= zeros;
+        return zeros;
+    }
+
+    // Consumed more bits than the column holds
+    bool overrun() const { return position_ * 8 - available_ > size_ * 8; }
+
+private:
+    void refill() {
+        if (position_ + 8 <= size_) {
+            uint64_t word;
+            std::memcpy(&word, data_ + position_, 8);
+            window_ |= byteSwap(word) >> available_;
+            int bytes = (63 - available_) >> 3;
+            position_ += bytes;
+            available_ += bytes * 8;
+            return;
+        }
+        while (available_ <= 56) {
+            uint64_t byte = position_ < size_ ? data_[position_] : 0;
+            window_ |= byte << (56 - available_);
+            position_++;
+            available_ += 8;
+        }
+    }
+
+    static int countLeadingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+    static uint64_t byteSwap(uint64_t value) {
+#if defined(_MSC_VER)
+        return _byteswap_uint64(value);
+#else
+        return __builtin_bswap64(value);
+#endif
+    }
+
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t position_ = 0;
+    uint64_t window_ = 0;
+    int available_ = 0;
+};
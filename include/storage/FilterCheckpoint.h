@@ -0,0 +1,79 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "Config.h"
+#include "ComplementaryFilter.h"
+
+// Learned filter state kept across restarts, one small text file per device:
+//
+//   version 1
+//   device <id>
+//   saved <unix seconds>
+//   temperature <deg C or nan>
+//   attitude <w x y z>
+//   gyro_correction <x y z>          (integral terms, rad/s)
+//   gains <kp roll/pitch> <ki roll/pitch> <kp yaw> <ki yaw>
+//   defaults <the same four from Config.h when saved>
+struct FilterCheckpoint {
+    static constexpr int VERSION = 1;
+
+    std::string deviceId;
+    double savedAt = 0.0;
+    float temperature = NAN;
+    QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+    Vector3F gyroCorrection = {0.0f, 0.0f, 0.0f};
+    ComplementaryFilter::Gains gains;
+    ComplementaryFilter::Gains defaults;   // Lets a restart after a Config.h gain change keep the new gains
+
+    bool read(const std::string& path);
+    bool write(const std::string& path) const;   // Via a temporary file renamed over the old one
+};
+
+// Restores a device's checkpoint when it becomes the app's device and saves the filter state for it
+// every checkpointInterval on the io thread (and once more at exit). The gains are restored unless
+// the Config.h defaults changed since the save; the gyro correction and attitude only when the
+// checkpoint is younger than checkpointMaxAge and, if both temperatures are known, the device
+// temperature moved less than checkpointMaxTemperatureDelta.
+class FilterCheckpointer {
+public:
+    struct Status {
+        std::string deviceId;
+        std::string restore;       // What was restored at attach, or why not
+        float restoredAge = 0.0f;  // Seconds between the save and the restore
+        uint64_t saves = 0;
+        bool saveFailed = false;
+    };
+
+    FilterCheckpointer(boost::asio::io_context& ioc, ComplementaryFilter& filter,
+                       const std::string& directory = checkpointDirectory);
+
+    // A device now drives the filter (io thread, before its samples and before the filter re-enters
+    // alignment). Saves the previous or reconnecting device's state first
+    void attach(const std::string& deviceId);
+
+    // Device temperature, for transports that report one
+    void setTemperature(float celsius) { temperature_ = celsius; }
+
+    // Save now; only once the filter has aligned, so an unconverged state never replaces a good one
+    void save();
+
+    Status getStatus() const;
+
+    static std::string pathFor(const std::string& directory, const std::string& deviceId);
+
+private:
+    void scheduleSave();
+
+    boost::asio::steady_timer timer_;
+    ComplementaryFilter& filter_;
+    std::string directory_;
+    std::string deviceId_;
+    float temperature_ = NAN;
+
+    mutable std::mutex mtx_;   // Status is read by the UI
+    Status status_;
+};
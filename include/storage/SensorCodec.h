@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util/SensorSample.h"
+#include "storage/BitStream.h"
+
+// Compressed column block for one sensor stream. Timestamps are delta-of-delta coded on their
+// order-preserving integer image, so evenly spaced float timestamps cost about one bit each and
+// decode bit-exact. Each axis is its own column, coded one of two ways:
+//   * Xor: Gorilla-style XOR against the previous value. Lossless, but noisy mantissa bits
+//     do not compress, so expect well under 2x on live sensor data.
+//   * QuantizedDelta: values are rounded to a fixed resolution (chosen at or below the sensor
+//     LSB), and the differences are zigzag coded and bit-packed in groups of 32 at the group's
+//     widest difference. Costs about log2(noise / resolution) + 3 bits per value.
+//
+// Block layout (little endian):
+//   [u8 sensor type][u8 coding][u16 count][f32 resolution][u32 column bytes x4][t][x][y][z]
+
+// Decoded block as structure-of-arrays, ready for ThreadSafeRingBuffer3D::append(x, y, z, count)
+struct SensorBlock {
+    SensorType type = SensorType::Gyro;
+    std::size_t count = 0;
+    std::vector<float> timestamps;
+    std::vector<float> x, y, z;
+};
+
+enum class ValueCoding : uint8_t {
+    Xor,
+    QuantizedDelta
+};
+
+class SensorBlockEncoder {
+public:
+    static constexpr std::size_t HEADER_BYTES = 8 + 4 * sizeof(uint32_t);
+    static constexpr std::size_t MAX_SAMPLES = 65535;
+    static constexpr std::size_t GROUP = 32;   // Values per bit-packed group
+
+    // resolution > 0 selects QuantizedDelta with that step, 0 keeps the values lossless (Xor)
+    explicit SensorBlockEncoder(SensorType type, float resolution = 0.0f);
+    SensorBlockEncoder(const SensorBlockEncoder&) = delete;
+    SensorBlockEncoder& operator=(const SensorBlockEncoder&) = delete;
+
+    void append(float timestamp, float x, float y, float z);
+    std::size_t count() const { return count_; }
+
+    // Append the finished block to 'out' and start a new one
+    void finish(std::vector<uint8_t>& out);
+
+private:
+    struct Column {
+        std::vector<uint8_t> bytes;
+        BitWriter writer{bytes};
+    };
+    struct AxisState {
+        uint32_t previous = 0;      // Xor: last bits. QuantizedDelta: last quantized value
+        int leading = -1;           // Xor window of the last stored XOR, -1 until one is stored
+        int trailing = 0;
+        uint32_t group[GROUP];      // QuantizedDelta: zigzag differences waiting to be packed
+        std::size_t grouped = 0;
+    };
+
+    void encodeTimestamp(uint32_t key);
+    void encodeXor(int axis, float value);
+    void encodeQuantized(int axis, float value);
+    void packGroup(int axis);
+    void reset();
+
+    SensorType type_;
+    ValueCoding coding_;
+    float resolution_;
+    float inverseResolution_;
+    std::size_t count_ = 0;
+    Column columns_[4];   // t, x, y, z
+    uint32_t previousKey_ = 0;
+    int64_t previousDelta_ = 0;
+    AxisState axes_[3];
+};
+
+class SensorBlockDecoder {
+public:
+    // Decode one block from the start of 'data' into 'block' (vectors are reused).
+    // Returns the bytes consumed, or 0 if the data does not hold a valid block
+    static std::size_t decode(const uint8_t* data, std::size_t size, SensorBlock& block);
+
+    // Largest column a valid block of 'count' samples can have: the 32-bit first value, then at
+    // most 68 bits per sample (a timestamp delta-of-delta escape)
+    static constexpr std::size_t maxColumnBytes(std::size_t count) { return 4 + count * 9; }
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "util/SensorSample.h"
+#include "storage/SensorCodec.h"
+
+// Compressed recording of the raw sensor streams: a file header followed by SensorCodec blocks,
+// each holding up to recordBlockSamples samples of one sensor. Blocks of different sensors are
+// interleaved in the order they fill up, so readers merge by timestamp when they need one
+// time-ordered stream.
+namespace RecordingFormat {
+    constexpr char MAGIC[4] = {'I', 'M', 'U', 'R'};
+    constexpr uint32_t VERSION = 1;
+    constexpr std::size_t HEADER_BYTES = 8;
+}
+
+// Writes samples from the ingestion thread; start/stop and stats may be called from the UI
+class SensorRecorder {
+public:
+    struct Stats {
+        bool recording = false;
+        std::string path;
+        uint64_t samples = 0;
+        uint64_t rawBytes = 0;       // Timestamp plus three floats per sample
+        uint64_t encodedBytes = 0;   // Written to the file so far, including headers
+    };
+
+    SensorRecorder() = default;
+    ~SensorRecorder();
+
+    bool start(const std::string& path);
+    void stop();
+    bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+    void record(const SensorSample& sample);
+    Stats getStats() const;
+
+private:
+    void writeBlock(SensorBlockEncoder& encoder);
+
+    std::atomic<bool> recording_{false};
+    mutable std::mutex mtx_;
+    std::ofstream file_;
+    std::unique_ptr<SensorBlockEncoder> encoders_[3];
+    std::vector<uint8_t> block_;
+    Stats stats_;
+};
+
+// Reads a recording block by block
+class RecordingReader {
+public:
+    bool open(const std::string& path);
+
+    // Decode the next block into 'block'; false at the end of the file or on a damaged block
+    bool next(SensorBlock& block);
+
+    uint64_t fileBytes() const { return fileBytes_; }
+
+private:
+    std::ifstream file_;
+    std::vector<uint8_t> buffer_;
+    uint64_t fileBytes_ = 0;
+};
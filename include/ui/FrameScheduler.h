@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+
+#include "Config.h"
+#include "util/Structs3D.h"
+
+class FrameScheduler {
+public:
+    struct Stats {
+        std::size_t activeFrames = 0;         // Frames drawn at targetFPS
+        std::size_t idleFrames = 0;           // Frames drawn at idleFPS
+        std::size_t skippedFrames = 0;        // Frames a fixed targetFPS loop would have drawn on top of ours
+        std::size_t sceneRenders = 0;         // 3D scene re-rendered into its render texture
+        std::size_t sceneRendersSkipped = 0;  // 3D scene reused from the previous frame
+    };
+
+    FrameScheduler(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer,
+                   const Structs3D::QuaternionF& attitude);
+
+    void BeginFrame();
+    bool IsSceneDirty() const;
+    void MarkSceneRendered();
+    void MarkSceneReused();
+
+    bool IsIdle() const { return m_idle; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    bool HasNewSamples();
+    bool HasInput() const;
+    float AttitudeChangeDeg() const;
+
+    const GyroBuffer& m_gyroBuffer;
+    const AccelBuffer& m_accelBuffer;
+    const MagBuffer& m_magBuffer;
+    const Structs3D::QuaternionF& m_attitude;
+
+    std::size_t m_gyroWrites = 0;
+    std::size_t m_accelWrites = 0;
+    std::size_t m_magWrites = 0;
+
+    Structs3D::QuaternionF m_renderedAttitude = {1.0f, 0.0f, 0.0f, 0.0f};
+    bool m_sceneRendered = false;
+
+    double m_lastActivityTime = 0.0;
+    bool m_idle = false;
+    Stats m_stats;
+};
@@ -2,6 +2,15 @@
 #include "imgui.h"
 #include "util/Structs3D.h"
 #include "ComplementaryFilter.h"
+#include "ui/FrameScheduler.h"
+#include "AttitudePredictor.h"
+#include "AllanCapture.h"
+#include "TriggerCapture.h"
+#include "Prefilter.h"
+#include "storage/SensorRecorder.h"
+#include "storage/FilterCheckpoint.h"
+#include "communication/ClockSync.h"
+#include "ui/PerformanceMonitor.h"
 
 class ImGuiPanel {
 private:
@@ -11,9 +20,22 @@ private:
     int m_height;
     Structs3D::QuaternionF& attitude_;
     ComplementaryFilter& filter_;
-    
+    const FrameScheduler& scheduler_;
+    AttitudePredictor& predictor_;
+    AllanCapture& allanCapture_;
+    TriggerCapture& triggerCapture_;
+    Prefilter& prefilter_;
+    Prefilter::Chain prefilterChains_[3];   // Edited in the UI, sent on change
+    SensorRecorder& recorder_;
+    char recordingPath_[256] = "recording.imur";
+    const ClockSync& clockSync_;
+    const PerformanceMonitor& perfMonitor_;
+    const FilterCheckpointer& checkpointer_;
 
 public:
-    ImGuiPanel(int posX, int posY, int width, int height, Structs3D::QuaternionF& attitude, ComplementaryFilter& complementaryFilter);
+    ImGuiPanel(int posX, int posY, int width, int height, Structs3D::QuaternionF& attitude, ComplementaryFilter& complementaryFilter,
+               const FrameScheduler& scheduler, AttitudePredictor& predictor, AllanCapture& allanCapture,
+               TriggerCapture& triggerCapture, Prefilter& prefilter, SensorRecorder& recorder, const ClockSync& clockSync,
+               const PerformanceMonitor& perfMonitor, const FilterCheckpointer& checkpointer);
     void Draw();
 };
\ No newline at end of file
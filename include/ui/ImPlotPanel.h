@@ -4,6 +4,7 @@
 #include "util/ThreadSafeRingBuffer3D.h"
 #include "Config.h"
 #include "SensorPlot.h"
+#include "SpectrumAnalyzer.h"
 
 class ImPlotPanel {
 private:
@@ -19,6 +20,12 @@ private:
     SensorPlot<accelBufferSize> m_accelPlot;
     SensorPlot<magBufferSize> m_magPlot;
 
+    // Vibration spectrum view (analysis runs only while shown)
+    SpectrumAnalyzer& m_spectrumAnalyzer;
+    bool m_show_spectrum;
+    SpectrumAnalyzer::Spectrum m_gyroSpectrum;
+    SpectrumAnalyzer::Spectrum m_accelSpectrum;
+
     static constexpr float min_zoom = 0.1f;
     static constexpr float max_zoom = 10.0f;
 
@@ -29,8 +36,12 @@ public:
                 const MagBuffer& magBuffer,
                 const GyroTimesBuffer& gyroTimeBuffer,
                 const AccelTimesBuffer& accelTimeBuffer,
-                const MagTimesBuffer& magTimeBuffer
+                const MagTimesBuffer& magTimeBuffer,
+                SpectrumAnalyzer& spectrumAnalyzer
                 );
 
     void Draw();
+
+private:
+    void DrawSpectrum(const char* name, const SpectrumAnalyzer::Spectrum& spectrum, float height) const;
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Config.h"
+#include "communication/IngestStats.h"
+
+// Figures for the performance panel. Ingestion rates, counts and latency percentiles come from
+// IngestStats snapshots taken perfWindowSeconds apart (relaxed atomic loads, so the panel never
+// blocks the io thread). Frame costs are timed on the render thread around the 3D scene, the
+// ImPlot panel and the ImGui panel; ImGui's time includes rendering the draw lists of both.
+class PerformanceMonitor {
+public:
+    struct Window {
+        float sampleRate[3] = {0.0f, 0.0f, 0.0f};   // Achieved samples per second, indexed by SensorType
+        float messageRate = 0.0f;                    // Messages, batches or datagrams per second
+        uint64_t resyncs = 0;                        // Totals since start
+        uint64_t rejected = 0;
+        uint64_t lateDrops = 0;
+        uint64_t reconnects = 0;
+        float lastGap = 0.0f;                        // Seconds without data around the latest reconnect
+        float longestGap = 0.0f;
+        std::size_t missed[3] = {0, 0, 0};           // Samples overwritten before a buffer reader got them, indexed by SensorType
+        uint64_t latencySamples = 0;                 // Samples in the latency figures below
+        float latencyP50 = 0.0f;                     // Seconds from message arrival to filter update
+        float latencyP90 = 0.0f;
+        float latencyP99 = 0.0f;
+        float latencyMax = 0.0f;
+    };
+
+    PerformanceMonitor(const IngestStats& ingestStats,
+                       const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer);
+
+    // Call in frame order: BeginFrame before drawing, then after the scene, the plots and the GUI
+    void BeginFrame();
+    void MarkScene();
+    void MarkPlots();
+    void MarkGui();
+
+    const Window& GetWindow() const { return m_window; }
+
+    // Frame history in milliseconds, perfFrameHistory entries oldest at GetHistoryOffset(). Costs
+    // are stacked: scene, scene + plots, scene + plots + GUI
+    const float* GetSceneHistory() const { return m_sceneTop.data(); }
+    const float* GetPlotsHistory() const { return m_plotsTop.data(); }
+    const float* GetGuiHistory() const { return m_guiTop.data(); }
+    const float* GetIntervalHistory() const { return m_interval.data(); }
+    int GetHistoryOffset() const { return m_historyIndex; }
+
+private:
+    void UpdateWindow(double now);
+
+    const IngestStats& m_ingestStats;
+    const GyroBuffer& m_gyroBuffer;
+    const AccelBuffer& m_accelBuffer;
+    const MagBuffer& m_magBuffer;
+
+    IngestStats::Snapshot m_previous;
+    double m_windowStart = 0.0;
+    Window m_window;
+
+    double m_frameStart = 0.0;
+    std::array<float, perfFrameHistory> m_sceneTop{};
+    std::array<float, perfFrameHistory> m_plotsTop{};
+    std::array<float, perfFrameHistory> m_guiTop{};
+    std::array<float, perfFrameHistory> m_interval{};
+    int m_historyIndex = 0;
+};
@@ -1,9 +1,17 @@
 #pragma once
+#include <vector>
 #include "raylib.h"
 #include "util/Structs3D.h"
 
 class RaylibScene {
 private:
+    // One draw of a cached mesh: local transform and color are fixed at Init
+    struct SceneItem {
+        const Mesh* mesh;
+        Matrix transform;
+        Color color;
+    };
+
     const int m_sceneOriginX;
     const int m_sceneOriginY;
     const int m_sceneWidth;
@@ -13,9 +21,27 @@ private:
     const Structs3D::QuaternionF& attitude_;
     const Structs3D::Vector3F& accelVector_;
 
+    // GPU meshes, generated and uploaded once in Init. Arrows share the unit cylinder and sphere
+    Mesh m_cylinderMesh;
+    Mesh m_sphereMesh;
+    Mesh m_deviceMesh;
+    Mesh m_deviceEdgesMesh;
+    Mesh m_gridMesh;
+    Mesh m_gridCenterMesh;
+    Material m_material;
+
+    std::vector<SceneItem> m_worldItems;   // Fixed in world frame (grid, axes)
+    std::vector<SceneItem> m_bodyItems;    // Rotate with the device attitude
+
+    void AddArrow(std::vector<SceneItem>& items, Vector3 direction, float length, float radius, float tipRadius, Color color);
+    void DrawItems(const std::vector<SceneItem>& items, Matrix frame);
+
 public:
     RaylibScene(int originX, int originY, int width, int height, const Structs3D::QuaternionF& attitude, const Structs3D::Vector3F& accelVector);
     ~RaylibScene();
     void Init();
-    void Draw();
-};
\ No newline at end of file
+    void Draw(bool renderScene = true);
+
+private:
+    void RenderScene();
+};
@@ -4,6 +4,11 @@
 #include "util/Structs3D.h"
 #include "util/ThreadSafeRingBuffer3D.h"
 #include "ComplementaryFilter.h"
+#include "Prefilter.h"
+#include "storage/SensorRecorder.h"
+#include "storage/FilterCheckpoint.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
 
 void runApp(const GyroBuffer &gyroBuffer, 
             const AccelBuffer &accelBuffer,
@@ -13,4 +18,9 @@ void runApp(const GyroBuffer &gyroBuffer,
             const MagTimesBuffer &magTimesBuffer,
             Structs3D::QuaternionF &estimatedAttitude,
             Structs3D::Vector3F& accelVector,
-            ComplementaryFilter &complementaryFilter);
\ No newline at end of file
+            ComplementaryFilter &complementaryFilter,
+            Prefilter &prefilter,
+            SensorRecorder &recorder,
+            ClockSync &clockSync,
+            const IngestStats &ingestStats,
+            const FilterCheckpointer &checkpointer);
\ No newline at end of file
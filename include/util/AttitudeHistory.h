@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <algorithm>
+
+#include "util/Structs3D.h"
+#include "util/Math3D.h"
+#include "util/BufferArena.h"
+
+// Timestamped attitude history using the same double-length layout as ThreadSafeRingBuffer,
+// so the retained window is always contiguous and sorted by time for binary search.
+template <std::size_t Capacity>
+class AttitudeHistory {
+public:
+    AttitudeHistory() : times(2 * Capacity), attitudes(2 * Capacity), head(0), count(0) {}
+
+    // Timestamps must be non-decreasing; an older entry is ignored
+    void append(float timestamp, const Structs3D::QuaternionF& attitude) {
+        std::lock_guard<std::mutex> lock(mtx);
+        appendLocked(timestamp, attitude);
+    }
+
+    // Batch variant: one lock for all entries
+    void append(const float* timestamps, const Structs3D::QuaternionF* attitudeData, std::size_t n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (std::size_t i = 0; i < n; i++) {
+            appendLocked(timestamps[i], attitudeData[i]);
+        }
+    }
+
+    // Attitude at time t, interpolated between the neighboring entries. False if t is outside the history
+    bool attitudeAt(float t, Structs3D::QuaternionF& attitude) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::size_t hint = head - count;
+        return lookup(t, attitude, hint);
+    }
+
+    // Batch variant: one lock for all queries. Sorted query times reuse the previous position
+    // as the lower search bound. Returns how many queries fell inside the history
+    std::size_t attitudesAt(const float* queryTimes, Structs3D::QuaternionF* attitudes, bool* valid, std::size_t n) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::size_t resolved = 0;
+        std::size_t hint = head - count;
+
+        for (std::size_t i = 0; i < n; i++) {
+            if (i > 0 && queryTimes[i] < queryTimes[i - 1]) {
+                hint = head - count;   // Unsorted query, search the full window again
+            }
+            valid[i] = lookup(queryTimes[i], attitudes[i], hint);
+            if (valid[i]) resolved++;
+        }
+        return resolved;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return count;
+    }
+
+    // Time span covered by the history. False while empty
+    bool timeRange(float& oldest, float& newest) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (count == 0) return false;
+        oldest = times[head - count];
+        newest = times[head - 1];
+        return true;
+    }
+
+private:
+    // Caller holds the lock
+    void appendLocked(float timestamp, const Structs3D::QuaternionF& attitude) {
+        if (count > 0 && timestamp < times[head - 1]) {
+            return;
+        }
+
+        if (head + 1 > 2 * Capacity) {   // Overflow - move the most recent entries to the front
+            std::size_t elements_to_keep = Capacity - 1;
+            std::copy(times.begin() + (head - elements_to_keep), times.begin() + head, times.begin());
+            std::copy(attitudes.begin() + (head - elements_to_keep), attitudes.begin() + head, attitudes.begin());
+            head = elements_to_keep;
+        }
+
+        times[head] = timestamp;
+        attitudes[head] = attitude;
+        head += 1;
+        count = (count + 1 < Capacity) ? count + 1 : Capacity;
+    }
+
+    // Caller holds the lock. 'hint' is the first index that may contain t and is advanced to the match
+    bool lookup(float t, Structs3D::QuaternionF& attitude, std::size_t& hint) const {
+        if (count == 0) return false;
+        std::size_t first = head - count;
+        if (t < times[first] || t > times[head - 1]) return false;
+
+        // First entry strictly after t; its predecessor is at or before t
+        auto upper = std::upper_bound(times.begin() + std::max(hint, first), times.begin() + head, t);
+        std::size_t after = static_cast<std::size_t>(upper - times.begin());
+        if (after == head) {
+            attitude = attitudes[head - 1];   // t equals the newest timestamp
+            hint = head - 1;
+            return true;
+        }
+        std::size_t before = after - 1;
+        hint = before;
+
+        float span = times[after] - times[before];
+        float fraction = span > 0.0f ? (t - times[before]) / span : 0.0f;
+        attitude = Math3D::slerpQuaternions(attitudes[before], attitudes[after], fraction);
+        return true;
+    }
+
+    mutable std::mutex mtx;
+    ArenaArray<float> times;   // 2 * Capacity each, in BufferArena::global()
+    ArenaArray<Structs3D::QuaternionF> attitudes;
+    std::size_t head;
+    std::size_t count;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Normalized (a0 = 1) second order section coefficients
+struct BiquadCoefficients {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    static BiquadCoefficients passThrough() { return BiquadCoefficients(); }
+
+    // RBJ cookbook designs; frequency is clamped below Nyquist
+    static BiquadCoefficients lowPass(float frequency, float sampleRate, float q) {
+        float w0 = 2.0f * static_cast<float>(M_PI) * std::min(frequency, 0.49f * sampleRate) / sampleRate;
+        float cosW = std::cos(w0), alpha = std::sin(w0) / (2.0f * q);
+        float a0 = 1.0f + alpha;
+        return {(1.0f - cosW) / 2.0f / a0, (1.0f - cosW) / a0, (1.0f - cosW) / 2.0f / a0,
+                -2.0f * cosW / a0, (1.0f - alpha) / a0};
+    }
+
+    static BiquadCoefficients notch(float frequency, float sampleRate, float q) {
+        float w0 = 2.0f * static_cast<float>(M_PI) * std::min(frequency, 0.49f * sampleRate) / sampleRate;
+        float cosW = std::cos(w0), alpha = std::sin(w0) / (2.0f * q);
+        float a0 = 1.0f + alpha;
+        return {1.0f / a0, -2.0f * cosW / a0, 1.0f / a0, -2.0f * cosW / a0, (1.0f - alpha) / a0};
+    }
+};
+
+// Cascade of transposed direct form II biquads applied to Lanes independent signals at once
+// (x/y/z of one or more devices). Every section shares its coefficients across lanes and keeps
+// per-lane state in contiguous arrays, so the fixed-width lane loops compile to SIMD.
+// retune() ramps the coefficients linearly over RampSamples steps instead of switching them,
+// which keeps the output free of steps when a cutoff or notch frequency is changed live (the
+// biquad stability triangle is convex, so every intermediate coefficient set is stable too).
+template <std::size_t Lanes, std::size_t Sections, std::size_t RampSamples = 64>
+class BiquadCascade {
+public:
+    BiquadCascade() { reset(); }
+
+    void reset() {
+        for (std::size_t s = 0; s < Sections; s++) {
+            current_[s] = target_[s] = step_[s] = Coefficients{};
+            current_[s].c[0] = target_[s].c[0] = 1.0f;   // b0 = 1: pass-through
+            std::fill(std::begin(s1_[s]), std::end(s1_[s]), 0.0f);
+            std::fill(std::begin(s2_[s]), std::end(s2_[s]), 0.0f);
+        }
+        rampRemaining_ = 0;
+    }
+
+    // Move towards new coefficients (missing sections become pass-through); state is kept
+    void retune(const BiquadCoefficients* sections, std::size_t count) {
+        for (std::size_t s = 0; s < Sections; s++) {
+            BiquadCoefficients c = (s < count) ? sections[s] : BiquadCoefficients::passThrough();
+            target_[s].c[0] = c.b0; target_[s].c[1] = c.b1; target_[s].c[2] = c.b2;
+            target_[s].c[3] = c.a1; target_[s].c[4] = c.a2;
+            for (int i = 0; i < 5; i++) {
+                step_[s].c[i] = (target_[s].c[i] - current_[s].c[i]) / RampSamples;
+            }
+        }
+        rampRemaining_ = RampSamples;
+    }
+
+    bool isRamping() const { return rampRemaining_ > 0; }
+
+    // Filter one time step of every lane in place
+    void process(float* lanes) {
+        if (rampRemaining_ > 0) advanceRamp();
+
+        // Work on a local copy so the compiler can prove the lanes do not alias the state
+        alignas(32) float v[Lanes];
+        for (std::size_t l = 0; l < Lanes; l++) v[l] = lanes[l];
+
+        for (std::size_t s = 0; s < Sections; s++) {
+            const float b0 = current_[s].c[0], b1 = current_[s].c[1], b2 = current_[s].c[2];
+            const float a1 = current_[s].c[3], a2 = current_[s].c[4];
+            for (std::size_t l = 0; l < Lanes; l++) {
+                float x = v[l];
+                float y = b0 * x + s1_[s][l];
+                s1_[s][l] = b1 * x - a1 * y + s2_[s][l];
+                s2_[s][l] = b2 * x - a2 * y;
+                v[l] = y;
+            }
+        }
+
+        for (std::size_t l = 0; l < Lanes; l++) lanes[l] = v[l];
+    }
+
+    // Filter 'count' time steps stored lane-interleaved ([step][lane])
+    void processBlock(float* data, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            process(data + i * Lanes);
+        }
+    }
+
+private:
+    struct Coefficients { float c[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; };   // b0 b1 b2 a1 a2
+
+    void advanceRamp() {
+        if (--rampRemaining_ == 0) {
+            for (std::size_t s = 0; s < Sections; s++) current_[s] = target_[s];   // Land exactly
+            return;
+        }
+        for (std::size_t s = 0; s < Sections; s++) {
+            for (int i = 0; i < 5; i++) current_[s].c[i] += step_[s].c[i];
+        }
+    }
+
+    alignas(32) float s1_[Sections][Lanes];
+    alignas(32) float s2_[Sections][Lanes];
+    Coefficients current_[Sections];
+    Coefficients target_[Sections];
+    Coefficients step_[Sections];
+    std::size_t rampRemaining_ = 0;
+};
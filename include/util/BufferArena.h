@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// How the arena backs its memory
+enum class PageMode {
+    Normal,        // Regular pages
+    Transparent,   // Regular mapping advised for transparent hugepages (Linux MADV_HUGEPAGE)
+    Explicit       // Reserved hugepages (Linux MAP_HUGETLB, needs vm.nr_hugepages); falls back to Transparent
+};
+
+inline const char* pageModeName(PageMode pages) {
+    switch (pages) {
+        case PageMode::Transparent: return "transparent hugepages";
+        case PageMode::Explicit: return "reserved hugepages";
+        default: return "regular pages";
+    }
+}
+
+// Page-backed storage for the sample history buffers. Memory is mapped in chunks of whole
+// hugepages and handed out bump-pointer style, so every buffer of the app shares a few large
+// pages instead of scattering over many small ones (fewer TLB misses when plotting and analyzing
+// long histories), and none of it lives on a thread stack. Prefaulting touches each chunk when
+// it is mapped, so the first write to a buffer never stalls on a page fault. A chunk is unmapped
+// once everything allocated from it is released; the current chunk is rewound instead.
+// Platforms without mmap use aligned operator new.
+class BufferArena {
+public:
+    static constexpr std::size_t CHUNK_ALIGNMENT = std::size_t(2) << 20;   // One x86-64/ARM64 hugepage
+    static constexpr std::size_t ALLOCATION_ALIGNMENT = 64;                // Cache line
+
+    struct Stats {
+        std::size_t mappedBytes = 0;
+        std::size_t usedBytes = 0;
+        std::size_t chunks = 0;
+        PageMode pages = PageMode::Normal;   // What the mappings actually use after any fallback
+        bool prefaulted = false;
+    };
+
+    BufferArena(PageMode pages, bool prefault, std::size_t chunkBytes = CHUNK_ALIGNMENT);
+    ~BufferArena();
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    // The arena the ring buffers use, configured by bufferPageMode and bufferPrefault in Config.h
+    static BufferArena& global();
+
+    void* allocate(std::size_t bytes);
+    void deallocate(void* pointer);
+
+    Stats stats() const;
+
+private:
+    struct Chunk {
+        char* base = nullptr;
+        std::size_t size = 0;
+        std::size_t offset = 0;
+        std::size_t live = 0;   // Allocations not yet released
+    };
+
+    Chunk mapChunk(std::size_t bytes);
+    void unmapChunk(const Chunk& chunk);
+
+    mutable std::mutex mtx_;
+    std::vector<Chunk> chunks_;   // The last one is the current chunk
+    PageMode pages_;
+    bool prefault_;
+    std::size_t chunkBytes_;
+    std::size_t usedBytes_ = 0;
+};
+
+// Fixed-length array of a trivially copyable type in BufferArena::global(), zero-initialized.
+// Stands in for the std::array members of the ring buffers
+template <typename T>
+class ArenaArray {
+    static_assert(std::is_trivially_copyable_v<T>, "ArenaArray holds plain sample data");
+
+public:
+    explicit ArenaArray(std::size_t size)
+        : data_(static_cast<T*>(BufferArena::global().allocate(size * sizeof(T)))), size_(size) {
+        std::fill(data_, data_ + size_, T{});
+    }
+
+    ~ArenaArray() {
+        if (data_ != nullptr) BufferArena::global().deallocate(data_);
+    }
+
+    ArenaArray(const ArenaArray&) = delete;
+    ArenaArray& operator=(const ArenaArray&) = delete;
+    ArenaArray(ArenaArray&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    T* begin() { return data_; }
+    const T* begin() const { return data_; }
+    T* end() { return data_ + size_; }
+    const T* end() const { return data_ + size_; }
+    std::size_t size() const { return size_; }
+
+    T& operator[](std::size_t index) { return data_[index]; }
+    const T& operator[](std::size_t index) const { return data_[index]; }
+
+private:
+    T* data_;
+    std::size_t size_;
+};
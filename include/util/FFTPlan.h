@@ -0,0 +1,69 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// In-place radix-2 complex FFT on split real/imaginary arrays, with the bit-reversal permutation
+// and twiddles computed once per size. Twiddles for the stage with half-length h are stored
+// contiguously at [h, 2h), so every butterfly loop walks unit-stride arrays and vectorizes.
+class FFTPlan {
+public:
+    explicit FFTPlan(std::size_t size) : size_(size), twiddleRe_(size), twiddleIm_(size) {
+        // Size must be a power of two
+        std::size_t bits = 0;
+        while ((std::size_t(1) << bits) < size_) bits++;
+
+        for (std::size_t i = 0; i < size_; i++) {
+            std::size_t reversed = 0;
+            for (std::size_t b = 0; b < bits; b++) {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            if (i < reversed) {
+                swaps_.emplace_back(i, reversed);
+            }
+        }
+
+        for (std::size_t half = 1; half < size_; half <<= 1) {
+            for (std::size_t k = 0; k < half; k++) {
+                double angle = -M_PI * static_cast<double>(k) / static_cast<double>(half);
+                twiddleRe_[half + k] = static_cast<float>(std::cos(angle));
+                twiddleIm_[half + k] = static_cast<float>(std::sin(angle));
+            }
+        }
+    }
+
+    std::size_t size() const { return size_; }
+
+    void forward(float* re, float* im) const {
+        for (const std::pair<std::size_t, std::size_t>& s : swaps_) {
+            std::swap(re[s.first], re[s.second]);
+            std::swap(im[s.first], im[s.second]);
+        }
+
+        for (std::size_t half = 1; half < size_; half <<= 1) {
+            const float* wr = twiddleRe_.data() + half;
+            const float* wi = twiddleIm_.data() + half;
+            for (std::size_t base = 0; base < size_; base += 2 * half) {
+                float* aRe = re + base;
+                float* aIm = im + base;
+                float* bRe = aRe + half;
+                float* bIm = aIm + half;
+                for (std::size_t k = 0; k < half; k++) {
+                    float tRe = bRe[k] * wr[k] - bIm[k] * wi[k];
+                    float tIm = bRe[k] * wi[k] + bIm[k] * wr[k];
+                    bRe[k] = aRe[k] - tRe;
+                    bIm[k] = aIm[k] - tIm;
+                    aRe[k] += tRe;
+                    aIm[k] += tIm;
+                }
+            }
+        }
+    }
+
+private:
+    std::size_t size_;
+    std::vector<std::pair<std::size_t, std::size_t>> swaps_;
+    std::vector<float> twiddleRe_;
+    std::vector<float> twiddleIm_;
+};
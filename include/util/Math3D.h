@@ -102,4 +102,106 @@ namespace Math3D {
         result.z = v.z / magnitude;
         return result;
     }
+
+    inline float dotProduct(Vector3F a, Vector3F b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // Convert a rotation matrix (row-major, r[row][col]) to a unit quaternion (Shepperd's method)
+    inline QuaternionF quaternionFromRotationMatrix(const float r[3][3]) {
+        QuaternionF q;
+        float trace = r[0][0] + r[1][1] + r[2][2];
+        if (trace > 0.0f) {
+            float s = sqrt(trace + 1.0f) * 2.0f;
+            q.w = 0.25f * s;
+            q.x = (r[2][1] - r[1][2]) / s;
+            q.y = (r[0][2] - r[2][0]) / s;
+            q.z = (r[1][0] - r[0][1]) / s;
+        } else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+            float s = sqrt(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+            q.w = (r[2][1] - r[1][2]) / s;
+            q.x = 0.25f * s;
+            q.y = (r[0][1] + r[1][0]) / s;
+            q.z = (r[0][2] + r[2][0]) / s;
+        } else if (r[1][1] > r[2][2]) {
+            float s = sqrt(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+            q.w = (r[0][2] - r[2][0]) / s;
+            q.x = (r[0][1] + r[1][0]) / s;
+            q.y = 0.25f * s;
+            q.z = (r[1][2] + r[2][1]) / s;
+        } else {
+            float s = sqrt(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+            q.w = (r[1][0] - r[0][1]) / s;
+            q.x = (r[0][2] + r[2][0]) / s;
+            q.y = (r[1][2] + r[2][1]) / s;
+            q.z = 0.25f * s;
+        }
+        return normalizeQuaternion(q);
+    }
+
+    // Rotate q by a constant body rate over dt using the exact exponential map (no normalization drift)
+    inline QuaternionF integrateQuaternionExact(QuaternionF q, float wx, float wy, float wz, float dt) {
+        float rate = sqrt(wx*wx + wy*wy + wz*wz);
+        float halfAngle = 0.5f * rate * dt;
+        if (halfAngle < 1e-6f) {
+            return normalizeQuaternion(updateQuaternionWithAngularVelocity(q, wx, wy, wz, dt));
+        }
+        float s = sin(halfAngle) / rate;
+        QuaternionF delta;
+        delta.w = cos(halfAngle);
+        delta.x = wx * s;
+        delta.y = wy * s;
+        delta.z = wz * s;
+        return normalizeQuaternion(multiplyQuaternions(q, delta));
+    }
+
+    // TRIAD attitude from a gravity measurement (accel, pointing along world -Z) and optionally a
+    // magnetometer reading (east = mag x accel along world +Y). Without a usable heading the yaw
+    // keeps body X as close to world X as possible
+    inline QuaternionF attitudeFromGravityAndMag(Vector3F accel, Vector3F mag, bool hasMag) {
+        accel = normalizeVector(accel);
+        Vector3F upBody(-accel.x, -accel.y, -accel.z);
+
+        Vector3F eastBody(0.0f, 0.0f, 0.0f);
+        if (hasMag) {
+            eastBody = crossProduct(mag, accel);
+        }
+        if (sqrt(dotProduct(eastBody, eastBody)) < 1e-3f) {
+            Vector3F reference = fabs(upBody.x) < 0.9f ? Vector3F(1.0f, 0.0f, 0.0f) : Vector3F(0.0f, 1.0f, 0.0f);
+            float along = dotProduct(reference, upBody);
+            Vector3F northBody = normalizeVector(Vector3F(reference.x - along * upBody.x, reference.y - along * upBody.y, reference.z - along * upBody.z));
+            eastBody = crossProduct(upBody, northBody);
+        }
+        eastBody = normalizeVector(eastBody);
+        Vector3F northBody = crossProduct(eastBody, upBody);
+
+        // Rows of the body-to-world rotation are the world axes expressed in the body frame
+        const float rotation[3][3] = {
+            {northBody.x, northBody.y, northBody.z},
+            {eastBody.x, eastBody.y, eastBody.z},
+            {upBody.x, upBody.y, upBody.z}
+        };
+        return quaternionFromRotationMatrix(rotation);
+    }
+
+    // Spherical linear interpolation from q1 (t = 0) to q2 (t = 1) along the shorter arc
+    inline QuaternionF slerpQuaternions(QuaternionF q1, QuaternionF q2, float t) {
+        float dot = q1.w*q2.w + q1.x*q2.x + q1.y*q2.y + q1.z*q2.z;
+        if (dot < 0.0f) {
+            q2 = multiplyQuaternionByScalar(q2, -1.0f);
+            dot = -dot;
+        }
+
+        // Nearly identical rotations: linear interpolation avoids dividing by sin(~0)
+        if (dot > 0.9995f) {
+            QuaternionF result = addQuaternions(multiplyQuaternionByScalar(q1, 1.0f - t), multiplyQuaternionByScalar(q2, t));
+            return normalizeQuaternion(result);
+        }
+
+        float theta = acos(dot);
+        float sinTheta = sin(theta);
+        float w1 = sin((1.0f - t) * theta) / sinTheta;
+        float w2 = sin(t * theta) / sinTheta;
+        return addQuaternions(multiplyQuaternionByScalar(q1, w1), multiplyQuaternionByScalar(q2, w2));
+    }
 }
@@ -0,0 +1,206 @@
+#pragma once
+#include <cstddef>
+
+#include "Structs3D.h"
+
+// Fixed-size dense matrices for small estimators (Kalman filters, calibration fits). Dimensions are
+// template parameters and storage is a plain row-major array inside the object, so nothing touches
+// the heap, every loop has a compile-time trip count the compiler can unroll, and the innermost
+// loops run over contiguous elements so they vectorize. All arithmetic is constexpr.
+namespace LinearAlgebra {
+
+template <typename T, std::size_t Rows, std::size_t Cols>
+struct Matrix {
+    static constexpr std::size_t rows = Rows;
+    static constexpr std::size_t cols = Cols;
+
+    T data[Rows * Cols] = {};
+
+    static constexpr Matrix zero() { return Matrix(); }
+
+    static constexpr Matrix identity() {
+        static_assert(Rows == Cols, "identity() needs a square matrix");
+        Matrix result;
+        for (std::size_t i = 0; i < Rows; i++) result(i, i) = T(1);
+        return result;
+    }
+
+    static constexpr Matrix diagonal(T value) {
+        Matrix result = identity();
+        return result * value;
+    }
+
+    constexpr T& operator()(std::size_t row, std::size_t col) { return data[row * Cols + col]; }
+    constexpr const T& operator()(std::size_t row, std::size_t col) const { return data[row * Cols + col]; }
+
+    // Element access for column vectors
+    constexpr T& operator[](std::size_t i) { return data[i]; }
+    constexpr const T& operator[](std::size_t i) const { return data[i]; }
+
+    // Copy of the R x C block starting at (row, col)
+    template <std::size_t R, std::size_t C>
+    constexpr Matrix<T, R, C> block(std::size_t row, std::size_t col) const {
+        Matrix<T, R, C> result;
+        for (std::size_t r = 0; r < R; r++)
+            for (std::size_t c = 0; c < C; c++) result(r, c) = (*this)(row + r, col + c);
+        return result;
+    }
+
+    template <std::size_t R, std::size_t C>
+    constexpr void setBlock(std::size_t row, std::size_t col, const Matrix<T, R, C>& value) {
+        for (std::size_t r = 0; r < R; r++)
+            for (std::size_t c = 0; c < C; c++) (*this)(row + r, col + c) = value(r, c);
+    }
+
+    constexpr Matrix& operator+=(const Matrix& other) {
+        for (std::size_t i = 0; i < Rows * Cols; i++) data[i] += other.data[i];
+        return *this;
+    }
+
+    constexpr Matrix& operator-=(const Matrix& other) {
+        for (std::size_t i = 0; i < Rows * Cols; i++) data[i] -= other.data[i];
+        return *this;
+    }
+
+    constexpr Matrix& operator*=(T scalar) {
+        for (std::size_t i = 0; i < Rows * Cols; i++) data[i] *= scalar;
+        return *this;
+    }
+};
+
+template <typename T, std::size_t N>
+using Vector = Matrix<T, N, 1>;
+
+template <std::size_t Rows, std::size_t Cols>
+using MatrixF = Matrix<float, Rows, Cols>;
+template <std::size_t N>
+using VectorF = Vector<float, N>;
+
+using Matrix3F = MatrixF<3, 3>;
+using Vector3 = VectorF<3>;
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, R, C> operator+(Matrix<T, R, C> a, const Matrix<T, R, C>& b) { return a += b; }
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, R, C> operator-(Matrix<T, R, C> a, const Matrix<T, R, C>& b) { return a -= b; }
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, R, C> operator*(Matrix<T, R, C> a, T scalar) { return a *= scalar; }
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, R, C> operator*(T scalar, Matrix<T, R, C> a) { return a *= scalar; }
+
+// i-k-j order: the inner loop streams one row of b into one row of the result
+template <typename T, std::size_t R, std::size_t K, std::size_t C>
+constexpr Matrix<T, R, C> operator*(const Matrix<T, R, K>& a, const Matrix<T, K, C>& b) {
+    Matrix<T, R, C> result;
+    for (std::size_t i = 0; i < R; i++) {
+        for (std::size_t k = 0; k < K; k++) {
+            const T aik = a(i, k);
+            for (std::size_t j = 0; j < C; j++) result(i, j) += aik * b(k, j);
+        }
+    }
+    return result;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr Matrix<T, C, R> transpose(const Matrix<T, R, C>& a) {
+    Matrix<T, C, R> result;
+    for (std::size_t r = 0; r < R; r++)
+        for (std::size_t c = 0; c < C; c++) result(c, r) = a(r, c);
+    return result;
+}
+
+// a * b^T without forming the transpose (covariance propagation P F^T, K S K^T)
+template <typename T, std::size_t R, std::size_t K, std::size_t C>
+constexpr Matrix<T, R, C> multiplyTransposed(const Matrix<T, R, K>& a, const Matrix<T, C, K>& b) {
+    Matrix<T, R, C> result;
+    for (std::size_t i = 0; i < R; i++) {
+        for (std::size_t j = 0; j < C; j++) {
+            T sum = T(0);
+            for (std::size_t k = 0; k < K; k++) sum += a(i, k) * b(j, k);
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+// Average with the transpose; removes the asymmetry rounding adds to covariance updates
+template <typename T, std::size_t N>
+constexpr Matrix<T, N, N> symmetrize(const Matrix<T, N, N>& a) {
+    Matrix<T, N, N> result;
+    for (std::size_t r = 0; r < N; r++)
+        for (std::size_t c = 0; c < N; c++) result(r, c) = T(0.5) * (a(r, c) + a(c, r));
+    return result;
+}
+
+template <typename T, std::size_t N>
+constexpr T dot(const Vector<T, N>& a, const Vector<T, N>& b) {
+    T sum = T(0);
+    for (std::size_t i = 0; i < N; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+template <typename T>
+constexpr T determinant(const Matrix<T, 3, 3>& m) {
+    return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) -
+           m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0)) +
+           m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+}
+
+// Closed-form inverse (adjugate over determinant); false when the matrix is singular
+template <typename T>
+constexpr bool invert(const Matrix<T, 3, 3>& m, Matrix<T, 3, 3>& inverse) {
+    T det = determinant(m);
+    if (det == T(0)) return false;
+    T invDet = T(1) / det;
+    inverse(0, 0) = (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) * invDet;
+    inverse(0, 1) = (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * invDet;
+    inverse(0, 2) = (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * invDet;
+    inverse(1, 0) = (m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2)) * invDet;
+    inverse(1, 1) = (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * invDet;
+    inverse(1, 2) = (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * invDet;
+    inverse(2, 0) = (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0)) * invDet;
+    inverse(2, 1) = (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * invDet;
+    inverse(2, 2) = (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * invDet;
+    return true;
+}
+
+// Cross product matrix: skew(a) * b == a x b
+template <typename T>
+constexpr Matrix<T, 3, 3> skew(const Vector<T, 3>& a) {
+    Matrix<T, 3, 3> result;
+    result(0, 1) = -a[2]; result(0, 2) = a[1];
+    result(1, 0) = a[2];  result(1, 2) = -a[0];
+    result(2, 0) = -a[1]; result(2, 1) = a[0];
+    return result;
+}
+
+// Conversions from and to the Structs3D types used by the rest of the code
+inline Vector3 toVector(const Structs3D::Vector3F& v) {
+    Vector3 result;
+    result[0] = v.x; result[1] = v.y; result[2] = v.z;
+    return result;
+}
+
+inline Structs3D::Vector3F toVector3F(const Vector3& v) {
+    return Structs3D::Vector3F(v[0], v[1], v[2]);
+}
+
+// Body-to-world rotation matrix of a unit quaternion
+constexpr Matrix3F rotationMatrix(const Structs3D::QuaternionF& q) {
+    Matrix3F r;
+    r(0, 0) = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+    r(0, 1) = 2.0f * (q.x * q.y - q.w * q.z);
+    r(0, 2) = 2.0f * (q.x * q.z + q.w * q.y);
+    r(1, 0) = 2.0f * (q.x * q.y + q.w * q.z);
+    r(1, 1) = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+    r(1, 2) = 2.0f * (q.y * q.z - q.w * q.x);
+    r(2, 0) = 2.0f * (q.x * q.z - q.w * q.y);
+    r(2, 1) = 2.0f * (q.y * q.z + q.w * q.x);
+    r(2, 2) = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    return r;
+}
+
+} // namespace LinearAlgebra
@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "util/SensorSample.h"
+
+// Bounded-latency reorder stage. Samples are held in a min-heap keyed on timestamp (O(log k)
+// per sample) and released in strict time order once they are maxLatency behind the newest
+// timestamp seen, or have been held for maxLatency of host time. A sample older than one
+// already released can no longer be placed in order and is dropped as late. Samples are emitted
+// with their arrival time.
+class ReorderBuffer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ReorderBuffer(float maxLatency) : maxLatency_(maxLatency) {}
+
+    bool push(const SensorSample& sample, Clock::time_point arrival) {
+        if (hasReleased_ && sample.timestamp < lastReleased_) {
+            lateDrops_++;
+            return false;
+        }
+        heap_.push(Entry{sample, arrival, sequence_++});   // Sequence keeps arrival order for equal timestamps
+        if (sample.timestamp > newest_ || heap_.size() == 1) newest_ = sample.timestamp;
+        if (heap_.size() > maxDepth_) maxDepth_ = heap_.size();
+        return true;
+    }
+
+    // Release every sample that is ready at host time 'now', oldest first
+    template <typename Emit>
+    void release(Clock::time_point now, Emit&& emit) {
+        auto hold = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(maxLatency_));
+        while (!heap_.empty()) {
+            const Entry& top = heap_.top();
+            bool behindWatermark = top.sample.timestamp <= newest_ - maxLatency_;
+            bool heldTooLong = now - top.arrival >= hold;
+            if (!behindWatermark && !heldTooLong) break;
+            pop(emit);
+        }
+    }
+
+    // Release everything regardless of age, e.g. when the stream stops
+    template <typename Emit>
+    void flush(Emit&& emit) {
+        while (!heap_.empty()) pop(emit);
+    }
+
+    // Accept any timestamp again, for a new stream whose times need not follow the old one's.
+    // Flush first: held samples would be released out of order with the new ones
+    void restart() {
+        hasReleased_ = false;
+        newest_ = 0.0;
+    }
+
+    bool empty() const { return heap_.empty(); }
+    std::size_t size() const { return heap_.size(); }
+    std::size_t maxDepth() const { return maxDepth_; }
+    uint64_t lateDrops() const { return lateDrops_; }
+    uint64_t released() const { return released_; }
+    float maxLatency() const { return maxLatency_; }
+
+private:
+    struct Entry {
+        SensorSample sample;
+        Clock::time_point arrival;
+        uint64_t sequence;
+    };
+
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.sample.timestamp != b.sample.timestamp) return a.sample.timestamp > b.sample.timestamp;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    template <typename Emit>
+    void pop(Emit& emit) {
+        Entry entry = heap_.top();
+        heap_.pop();
+        lastReleased_ = entry.sample.timestamp;
+        hasReleased_ = true;
+        released_++;
+        emit(entry.sample, entry.arrival);
+    }
+
+    std::priority_queue<Entry, std::vector<Entry>, Later> heap_;
+    float maxLatency_;
+    double newest_ = 0.0;
+    double lastReleased_ = 0.0;
+    bool hasReleased_ = false;
+    uint64_t sequence_ = 0;
+    uint64_t lateDrops_ = 0;
+    uint64_t released_ = 0;
+    std::size_t maxDepth_ = 0;
+};
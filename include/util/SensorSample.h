@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum class SensorType : uint8_t {
+    Mag,
+    Accel,
+    Gyro
+};
+
+// One timestamped 3-axis reading as it moves from a session to the ring buffers and filter
+struct SensorSample {
+    SensorType type;
+    float x, y, z;
+    double timestamp;  // Sensor time in seconds; double until the reorder stage, whose order must
+                       // hold on long runs (float seconds since start step 2 ms after 4.5 h)
+};
+
+// Consecutive readings of one sensor as separate x/y/z/time arrays, oldest first
+struct SampleBlock {
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* z = nullptr;
+    const float* timestamp = nullptr;   // Sensor time in seconds
+    std::size_t count = 0;
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor splits the index range
+// evenly between the workers and the calling thread; each takes indices from the front of its
+// own range and, once that runs dry, steals the back half of another participant's remaining
+// range. Uneven tasks (e.g. filter runs that diverge early) therefore balance themselves
+// without every index going through one shared counter. parallelFor blocks until all are done.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) threads = 1;
+        for (std::size_t i = 0; i <= threads; i++) {
+            ranges_.push_back(std::make_unique<Range>());   // Last one belongs to the calling thread
+        }
+        for (std::size_t i = 0; i < threads; i++) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Run fn(i) for every i in [0, count) across the workers and the calling thread
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn) {
+        if (count == 0) return;
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        std::size_t participants = ranges_.size();
+        for (std::size_t p = 0; p < participants; p++) {
+            std::lock_guard<std::mutex> rangeLock(ranges_[p]->mtx);
+            ranges_[p]->begin = count * p / participants;
+            ranges_[p]->end = count * (p + 1) / participants;
+        }
+        job_ = &fn;
+        pending_ = count;
+        generation_++;
+        lock.unlock();
+        cv_.notify_all();
+
+        runJob(fn, participants - 1);
+
+        lock.lock();
+        done_.wait(lock, [this] { return pending_ == 0 && busy_ == 0; });
+        job_ = nullptr;
+    }
+
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    struct alignas(64) Range {
+        std::mutex mtx;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void workerLoop(std::size_t self) {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+            cv_.wait(lock, [&] { return stop_ || (job_ && generation_ != seen); });
+            if (stop_) return;
+            seen = generation_;
+            const std::function<void(std::size_t)>* job = job_;
+            busy_++;
+            lock.unlock();
+
+            runJob(*job, self);
+
+            lock.lock();
+            busy_--;
+            if (pending_ == 0 && busy_ == 0) done_.notify_all();
+        }
+    }
+
+    void runJob(const std::function<void(std::size_t)>& fn, std::size_t self) {
+        std::size_t finished = 0;
+        std::size_t index;
+        while (takeOwn(self, index) || steal(self, index)) {
+            fn(index);
+            finished++;
+        }
+        if (finished > 0) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            pending_ -= finished;
+            if (pending_ == 0) done_.notify_all();
+        }
+    }
+
+    bool takeOwn(std::size_t self, std::size_t& index) {
+        Range& own = *ranges_[self];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (own.begin >= own.end) return false;
+        index = own.begin++;
+        return true;
+    }
+
+    // Move the back half of the first non-empty victim range into our own and run its first index
+    bool steal(std::size_t self, std::size_t& index) {
+        std::size_t participants = ranges_.size();
+        for (std::size_t k = 1; k < participants; k++) {
+            Range& victim = *ranges_[(self + k) % participants];
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mtx);
+                if (victim.begin >= victim.end) continue;
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            Range& own = *ranges_[self];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            own.begin = begin + 1;
+            own.end = end;
+            index = begin;
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<Range>> ranges_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable done_;
+    const std::function<void(std::size_t)>* job_ = nullptr;
+    std::size_t pending_ = 0;
+    std::size_t busy_ = 0;
+    std::size_t generation_ = 0;
+    bool stop_ = false;
+};
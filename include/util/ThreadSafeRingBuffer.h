@@ -1,14 +1,15 @@
 #pragma once
-#include <array>
 #include <cstddef>
 #include <mutex>
 #include <algorithm>
 #include <stdexcept>
 
+#include "util/BufferArena.h"
+
 template <std::size_t Capacity>
 class ThreadSafeRingBuffer {
 public:
-    ThreadSafeRingBuffer() : head(0), count(0) {}
+    ThreadSafeRingBuffer() : buffer(2 * Capacity), head(0), count(0), writeCount(0) {}
 
     void append(const float* data, std::size_t len) {
         if (len > Capacity) {
@@ -30,6 +31,7 @@ public:
             head = Capacity;
             count = Capacity;
         }
+        writeCount += len;
     }
 
     void append(const float data) {
@@ -48,6 +50,7 @@ public:
             head = Capacity;
             count = Capacity;
         }
+        writeCount += 1;
     }
 
     float at(std::size_t index) const {
@@ -99,9 +102,26 @@ public:
         return head;
     }
 
+    // Same as ThreadSafeRingBuffer3D::copySince: the values appended after write count 'since'
+    // that are still held, oldest first, into 'data' (room for Capacity)
+    std::size_t copySince(std::size_t& since, float* data) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::size_t available = writeCount - since;
+        std::size_t n = (available < count) ? available : count;
+        std::copy(buffer.begin() + (head - n), buffer.begin() + head, data);
+        since = writeCount;
+        return n;
+    }
+
+    std::size_t getWriteCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return writeCount;
+    }
+
 private:
     mutable std::mutex mtx;
-    std::array<float, 2 * Capacity> buffer{};
+    ArenaArray<float> buffer;   // 2 * Capacity, in BufferArena::global()
     std::size_t head;
     std::size_t count;
+    std::size_t writeCount;
 };
\ No newline at end of file
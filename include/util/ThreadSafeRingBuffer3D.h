@@ -1,14 +1,17 @@
 #pragma once
-#include <array>
+#include <atomic>
 #include <cstddef>
 #include <mutex>
 #include <algorithm>
 #include <stdexcept>
 
+#include "util/BufferArena.h"
+
 template <std::size_t Capacity>
 class ThreadSafeRingBuffer3D {
 public:
-    ThreadSafeRingBuffer3D() : head(0), count(0) {}
+    ThreadSafeRingBuffer3D()
+        : xBuffer(2 * Capacity), yBuffer(2 * Capacity), zBuffer(2 * Capacity), head(0), count(0), writeCount(0) {}
 
     void append(float x, float y, float z) {
         std::lock_guard<std::mutex> lock(mtx);
@@ -42,6 +45,7 @@ public:
             head = Capacity;
             count = Capacity;
         }
+        writeCount += 1;
     }
 
     void append(const float* xData, const float* yData, const float* zData, std::size_t len) {
@@ -77,6 +81,7 @@ public:
             head = Capacity;
             count = Capacity;
         }
+        writeCount += len;
     }
 
     std::size_t size() const {
@@ -144,11 +149,57 @@ public:
         return head;
     }
 
+    // Copy the samples appended after write count 'since' into x/y/z (room for Capacity each), oldest
+    // first. Only the most recent Capacity can still be copied; older ones were overwritten before
+    // this reader got to them, and are skipped and counted in getMissedCount(). Returns the number
+    // copied and sets 'since' to the write count the copy is current to
+    std::size_t copySince(std::size_t& since, float* x, float* y, float* z) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::size_t available = writeCount - since;
+        std::size_t n = (available < count) ? available : count;
+        if (available > n) {
+            missedCount.fetch_add(available - n, std::memory_order_relaxed);
+        }
+        copyNewest(n, x, y, z);
+        since = writeCount;
+        return n;
+    }
+
+    // Copy everything the buffer still holds, oldest first, without counting older samples as
+    // missed. Returns the number copied and sets 'end' to the write count the copy is current to
+    std::size_t copyHeld(std::size_t& end, float* x, float* y, float* z) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        copyNewest(count, x, y, z);
+        end = writeCount;
+        return count;
+    }
+
+    // Total number of samples ever appended. Unlike the head index this never wraps,
+    // so readers can use it to detect new data between polls
+    std::size_t getWriteCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return writeCount;
+    }
+
+    // Samples overwritten before a copySince reader (TriggerCapture, AllanCapture,
+    // SpectrumAnalyzer) read them, summed over readers. Readable without the lock
+    std::size_t getMissedCount() const {
+        return missedCount.load(std::memory_order_relaxed);
+    }
+
 private:
     mutable std::mutex mtx;
-    std::array<float, 2 * Capacity> xBuffer{};
-    std::array<float, 2 * Capacity> yBuffer{};
-    std::array<float, 2 * Capacity> zBuffer{};
+    ArenaArray<float> xBuffer;   // 2 * Capacity each, in BufferArena::global()
+    ArenaArray<float> yBuffer;
+    ArenaArray<float> zBuffer;
     std::size_t head;
     std::size_t count;
+    std::size_t writeCount;
+    mutable std::atomic<std::size_t> missedCount{0};
+
+    void copyNewest(std::size_t n, float* x, float* y, float* z) const {
+        std::copy(xBuffer.begin() + (head - n), xBuffer.begin() + head, x);
+        std::copy(yBuffer.begin() + (head - n), yBuffer.begin() + head, y);
+        std::copy(zBuffer.begin() + (head - n), zBuffer.begin() + head, z);
+    }
 };
\ No newline at end of file
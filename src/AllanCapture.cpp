@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+
+#include "AllanCapture.h"
+
+AllanCapture::AllanCapture(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const SensorRates& rates)
+    : gyroBuffer_(gyroBuffer), accelBuffer_(accelBuffer),
+      pool_(std::min(6u, std::max(1u, std::thread::hardware_concurrency()))),
+      gyroEngine_(3, rates.gyro, OCTAVES, pool_),
+      accelEngine_(3, rates.accel, OCTAVES, pool_) {
+    for (std::vector<float>& axis : scratch_) {
+        axis.resize(std::max(gyroBufferSize, accelBufferSize));
+    }
+}
+
+AllanCapture::~AllanCapture() {
+    stop();
+}
+
+void AllanCapture::start() {
+    if (running_) return;
+
+    // Only samples that arrive from now on are characterized
+    gyroEngine_.reset();
+    accelEngine_.reset();
+    gyroSince_ = gyroBuffer_.getWriteCount();
+    accelSince_ = accelBuffer_.getWriteCount();
+    missed_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(resultMtx_);
+        result_ = Result();
+    }
+
+    running_ = true;
+    worker_ = std::thread([this] { run(); });
+}
+
+void AllanCapture::stop() {
+    running_ = false;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+AllanCapture::Result AllanCapture::getResult() const {
+    std::lock_guard<std::mutex> lock(resultMtx_);
+    return result_;
+}
+
+void AllanCapture::run() {
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+        drain(gyroBuffer_, gyroSince_, gyroEngine_);
+        drain(accelBuffer_, accelSince_, accelEngine_);
+
+        // Publish the current noise estimates for the UI
+        Result result;
+        for (int axis = 0; axis < 3; axis++) {
+            result.gyro[axis] = AllanVariance::noiseParameters(gyroEngine_.deviation(axis));
+            result.accel[axis] = AllanVariance::noiseParameters(accelEngine_.deviation(axis));
+        }
+        result.gyroSamples = gyroEngine_.samples();
+        result.accelSamples = accelEngine_.samples();
+        result.seconds = static_cast<float>(result.gyroSamples / gyroEngine_.sampleRate());
+        result.missedSamples = missed_;
+
+        std::lock_guard<std::mutex> lock(resultMtx_);
+        result_ = result;
+    }
+}
+
+template <std::size_t Capacity>
+void AllanCapture::drain(const ThreadSafeRingBuffer3D<Capacity>& buffer, std::size_t& since, AllanVariance& engine) {
+    std::size_t before = since;
+    std::size_t copied = buffer.copySince(since, scratch_[0].data(), scratch_[1].data(), scratch_[2].data());
+    missed_ += (since - before) - copied;
+
+    const float* data[3] = {scratch_[0].data(), scratch_[1].data(), scratch_[2].data()};
+    engine.addBlock(data, copied);
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "AllanVariance.h"
+
+namespace {
+    constexpr std::size_t MAX_BLOCK = 1 << 16;   // Ring headroom for one block on top of 2 * largest cluster
+}
+
+AllanVariance::AllanVariance(std::size_t channels, double sampleRate, int octaves, ThreadPool& pool)
+    : channels_(channels), sampleRate_(sampleRate), octaves_(octaves), pool_(pool) {
+    std::size_t needed = (std::size_t(2) << (octaves_ - 1)) + MAX_BLOCK + 1;
+    ringSize_ = 1;
+    while (ringSize_ < needed) ringSize_ <<= 1;
+    ringMask_ = ringSize_ - 1;
+    reset();
+}
+
+void AllanVariance::reset() {
+    cumulative_.assign(channels_, std::vector<double>(ringSize_, 0.0));
+    sumSquares_.assign(channels_, std::vector<double>(octaves_, 0.0));
+    terms_.assign(channels_, std::vector<uint64_t>(octaves_, 0));
+    samples_ = 0;
+}
+
+void AllanVariance::addBlock(const float* const* data, std::size_t count) {
+    // Split large inputs so a block never overruns the history the largest cluster still needs
+    std::vector<const float*> cursor(data, data + channels_);
+    while (count > 0) {
+        std::size_t block = std::min(count, MAX_BLOCK);
+        processBlock(cursor.data(), block);
+        for (const float*& p : cursor) p += block;
+        count -= block;
+    }
+}
+
+void AllanVariance::processBlock(const float* const* data, std::size_t count) {
+
+    const uint64_t first = samples_;
+    const double tau0 = 1.0 / sampleRate_;
+
+    // Stage 1: extend the cumulative sums, theta_n = theta_{n-1} + y_n * tau0 (index 0 is theta_0 = 0)
+    pool_.parallelFor(channels_, [&](std::size_t c) {
+        std::vector<double>& theta = cumulative_[c];
+        double running = theta[first & ringMask_];
+        for (std::size_t i = 0; i < count; i++) {
+            running += data[c][i] * tau0;
+            theta[(first + i + 1) & ringMask_] = running;
+        }
+    });
+
+    // Stage 2: every (channel, cluster size) accumulates theta_{n} - 2 theta_{n-m} + theta_{n-2m} for the new n
+    pool_.parallelFor(channels_ * octaves_, [&](std::size_t task) {
+        std::size_t c = task / octaves_;
+        std::size_t k = task % octaves_;
+        uint64_t m = uint64_t(1) << k;
+        const std::vector<double>& theta = cumulative_[c];
+
+        double sum = 0.0;
+        uint64_t terms = 0;
+        for (uint64_t n = std::max<uint64_t>(first + 1, 2 * m); n <= first + count; n++) {
+            double d = theta[n & ringMask_] - 2.0 * theta[(n - m) & ringMask_] + theta[(n - 2 * m) & ringMask_];
+            sum += d * d;
+            terms++;
+        }
+        sumSquares_[c][k] += sum;
+        terms_[c][k] += terms;
+    });
+
+    samples_ += count;
+}
+
+std::vector<AllanVariance::Point> AllanVariance::deviation(std::size_t channel) const {
+    std::vector<Point> curve;
+    for (int k = 0; k < octaves_; k++) {
+        uint64_t m = uint64_t(1) << k;
+        uint64_t terms = terms_[channel][k];
+        if (terms == 0 || samples_ / m < MIN_CLUSTERS) continue;
+
+        double tau = m / sampleRate_;
+        double variance = sumSquares_[channel][k] / (2.0 * tau * tau * terms);
+        curve.push_back({tau, std::sqrt(variance), terms});
+    }
+    return curve;
+}
+
+AllanVariance::NoiseParameters AllanVariance::noiseParameters(const std::vector<Point>& curve) {
+    NoiseParameters params;
+    if (curve.size() < 2) return params;
+
+    // Local log-log slope at each point (central difference inside, one-sided at the ends)
+    auto slopeAt = [&](std::size_t i) {
+        std::size_t a = (i == 0) ? 0 : i - 1;
+        std::size_t b = (i + 1 == curve.size()) ? i : i + 1;
+        return std::log(curve[b].deviation / curve[a].deviation) / std::log(curve[b].tau / curve[a].tau);
+    };
+
+    double bestWhite = std::numeric_limits<double>::max();
+    double bestRateWalk = std::numeric_limits<double>::max();
+    double minimum = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < curve.size(); i++) {
+        double slope = slopeAt(i);
+        const Point& p = curve[i];
+        minimum = std::min(minimum, p.deviation);
+
+        if (slope < 0.0 && std::abs(slope + 0.5) < bestWhite) {
+            bestWhite = std::abs(slope + 0.5);
+            params.randomWalk = p.deviation * std::sqrt(p.tau);           // sigma = N / sqrt(tau)
+        }
+        if (slope > 0.0 && std::abs(slope - 0.5) < bestRateWalk) {
+            bestRateWalk = std::abs(slope - 0.5);
+            params.rateRandomWalk = p.deviation * std::sqrt(3.0 / p.tau);  // sigma = K * sqrt(tau / 3)
+        }
+    }
+    params.biasInstability = minimum / 0.664;
+    return params;
+}
@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <chrono>
+
+#include "AttitudePredictor.h"
+
+using namespace Math3D;
+
+AttitudePredictor::AttitudePredictor(const QuaternionF& attitude, const GyroBuffer& gyroBuffer, const GyroTimesBuffer& gyroTimesBuffer,
+                                     const ComplementaryFilter& filter)
+    : attitude_(attitude), gyroBuffer_(gyroBuffer), gyroTimesBuffer_(gyroTimesBuffer), filter_(filter) {}
+
+QuaternionF AttitudePredictor::predict() {
+    QuaternionF attitude = attitude_;
+
+    // Age of the fused attitude in host time
+    int64_t lastUpdateNs = filter_.getLastAttitudeUpdateNs();
+    int64_t nowNs = std::chrono::steady_clock::now().time_since_epoch().count();
+    attitudeAge_ = lastUpdateNs > 0 ? (nowNs - lastUpdateNs) * 1e-9f : 0.0f;
+
+    // Newest gyro sample and its sensor timestamp
+    const float *gyroX, *gyroY, *gyroZ, *gyroTime;
+    gyroBuffer_.getRecentPointers(1, &gyroX, &gyroY, &gyroZ);
+    gyroTimesBuffer_.getRecentPointer(1, &gyroTime);
+
+    // Nothing to extrapolate from, or the stream stopped and the last rate no longer applies
+    if (!enabled_ || lastUpdateNs == 0 || !gyroX || !gyroTime || attitudeAge_ > predictionStaleAfter) {
+        horizon_ = 0.0f;
+        return attitude;
+    }
+    gyroTimestamp_ = *gyroTime;
+
+    // Bias-corrected body rate, held constant over the horizon
+    Vector3F correction = filter_.getGyroCorrection();
+    float wx = *gyroX + correction.x;
+    float wy = *gyroY + correction.y;
+    float wz = *gyroZ + correction.z;
+
+    horizon_ = std::clamp(attitudeAge_ + lookahead_, 0.0f, maxPredictionHorizon);
+    return integrateQuaternionExact(attitude, wx, wy, wz, horizon_);
+}
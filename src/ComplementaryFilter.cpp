@@ -1,13 +1,20 @@
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #include "Config.h"
 #include "ComplementaryFilter.h"
+#include "util/Matrix.h"
 
 using namespace Math3D;
 using namespace Structs3D;
 
-ComplementaryFilter::ComplementaryFilter(QuaternionF& attitude, Vector3F& magVector) : attitude_(attitude), magVector_(magVector) {}
+ComplementaryFilter::ComplementaryFilter(QuaternionF& attitude, Vector3F& magVector, const SensorRates& rates)
+    : rates_(rates),
+      gyroDeltaT_(rates.deltaT(SensorType::Gyro)),
+      accelDeltaT_(rates.deltaT(SensorType::Accel)),
+      alignmentAccelTarget_(std::max(1, static_cast<int>(rates.accel * alignmentAccelSeconds))),
+      attitude_(attitude), magVector_(magVector) {}
 
 bool ComplementaryFilter::isValidGyroReading(float gyroX, float gyroY, float gyroZ) const {
     // Check for NaN or infinity
@@ -59,13 +66,220 @@ bool ComplementaryFilter::isValidMagReading(float magX, float magY, float magZ)
     return true;
 }
 
-void ComplementaryFilter::updateWithGyro(float gyroX, float gyroY, float gyroZ){    
+void ComplementaryFilter::updateWithGyro(float gyroX, float gyroY, float gyroZ, float timestamp){    
     // Sanity check gyro values
     if (!isValidGyroReading(gyroX, gyroY, gyroZ)) {
         std::cout << "Warning: Invalid gyro reading detected, skipping update" << std::endl;
         return;
     }
 
+    // Collect the alignment window instead of integrating until the initial attitude is known
+    if (!running_) {
+        alignWithGyro(gyroX, gyroY, gyroZ);
+        return;
+    }
+
+    integrateGyro(gyroX, gyroY, gyroZ);
+    publishAttitude();
+    attitudeHistory_.append(timestamp, quaternion_);
+}
+
+void ComplementaryFilter::updateWithAccel(float accelX, float accelY, float accelZ){
+    // Sanity check accel values
+    if (!isValidAccelReading(accelX, accelY, accelZ)) {
+        std::cout << "Warning: Invalid accel reading detected, skipping update" << std::endl;
+        return;
+    }
+
+    if (!running_) {
+        alignWithAccel(accelX, accelY, accelZ);
+        return;
+    }
+
+    // Normalize the accel vector 
+    Vector3F accelVector = normalizeVector(Vector3F(accelX, accelY, accelZ));
+    correctWithAccel(accelVector, toBody(exptectedGravityWorld_));
+}
+
+void ComplementaryFilter::updateWithMag(float magX, float magY, float magZ){
+    // Feed the raw reading to the online calibration and fuse the corrected one once the fit is valid
+    magCalibrator_.addSample(magX, magY, magZ);
+    if (magCalibrationEnabled_.load(std::memory_order_relaxed) && magCalibrator_.isValid()) {
+        Vector3F corrected = magCalibrator_.correct(magX, magY, magZ);
+        magX = corrected.x;
+        magY = corrected.y;
+        magZ = corrected.z;
+    }
+
+    // Sanity check mag values
+    if (!isValidMagReading(magX, magY, magZ)) {
+        std::cout << "Warning: Invalid mag reading detected, skipping update" << std::endl;
+        return;
+    }
+
+    if (!running_) {
+        alignWithMag(magX, magY, magZ);
+        return;
+    }
+
+    // Normalize the mag vector
+    Vector3F magVector = normalizeVector(Vector3F(magX, magY, magZ));   
+    correctWithMag(magVector, bodyReferences());
+}
+
+void ComplementaryFilter::updateBatch(const SampleBlock& gyro, const SampleBlock& accel, const SampleBlock& mag) {
+    if (gyroValid_.size() < gyro.count) gyroValid_.resize(gyro.count);
+    if (accelValid_.size() < accel.count) {
+        accelValid_.resize(accel.count);
+        accelNorm_.resize(accel.count);
+    }
+
+    // Sanity checks as plain loops over the blocks, which the compiler vectorizes. The comparisons
+    // are false for NaN and infinity, so they cover the isfinite checks of the per-sample path
+    uint8_t* gyroValid = gyroValid_.data();
+    for (std::size_t i = 0; i < gyro.count; i++) {
+        gyroValid[i] = (std::abs(gyro.x[i]) <= MAX_GYRO_RATE) & (std::abs(gyro.y[i]) <= MAX_GYRO_RATE) &
+                       (std::abs(gyro.z[i]) <= MAX_GYRO_RATE);
+    }
+    uint8_t* accelValid = accelValid_.data();
+    float* accelNorm = accelNorm_.data();
+    for (std::size_t i = 0; i < accel.count; i++) {
+        accelNorm[i] = std::sqrt(accel.x[i] * accel.x[i] + accel.y[i] * accel.y[i] + accel.z[i] * accel.z[i]);
+        accelValid[i] = (accelNorm[i] >= MIN_ACCEL_MAGNITUDE) & (accelNorm[i] <= MAX_ACCEL_MAGNITUDE);
+    }
+
+    historyTimes_.clear();
+    historyAttitudes_.clear();
+    int rejected[3] = {0, 0, 0};   // Indexed by SensorType
+
+    // The body-frame references only change with the attitude, i.e. after a gyro update
+    BodyReferences references;
+    bool referencesCurrent = false;
+
+    std::size_t g = 0, a = 0, m = 0;
+    while (g < gyro.count || a < accel.count || m < mag.count) {
+        float gyroTime = g < gyro.count ? gyro.timestamp[g] : INFINITY;
+        float accelTime = a < accel.count ? accel.timestamp[a] : INFINITY;
+        float magTime = m < mag.count ? mag.timestamp[m] : INFINITY;
+
+        if (m < mag.count && magTime <= accelTime && magTime <= gyroTime) {
+            // The mag calibration is sequential, so mag keeps the per-sample checks; it is the slowest sensor
+            float magX = mag.x[m], magY = mag.y[m], magZ = mag.z[m];
+            m++;
+            magCalibrator_.addSample(magX, magY, magZ);
+            if (magCalibrationEnabled_.load(std::memory_order_relaxed) && magCalibrator_.isValid()) {
+                Vector3F corrected = magCalibrator_.correct(magX, magY, magZ);
+                magX = corrected.x;
+                magY = corrected.y;
+                magZ = corrected.z;
+            }
+            if (!isValidMagReading(magX, magY, magZ)) {
+                rejected[static_cast<int>(SensorType::Mag)]++;
+            } else if (!running_) {
+                alignWithMag(magX, magY, magZ);
+            } else {
+                if (!referencesCurrent) {
+                    references = bodyReferences();
+                    referencesCurrent = true;
+                }
+                correctWithMag(normalizeVector(Vector3F(magX, magY, magZ)), references);
+            }
+        } else if (a < accel.count && accelTime <= gyroTime) {
+            std::size_t i = a++;
+            if (!accelValid[i]) {
+                rejected[static_cast<int>(SensorType::Accel)]++;
+            } else if (!running_) {
+                alignWithAccel(accel.x[i], accel.y[i], accel.z[i]);
+            } else {
+                if (!referencesCurrent) {
+                    references = bodyReferences();
+                    referencesCurrent = true;
+                }
+                Vector3F accelVector(accel.x[i] / accelNorm[i], accel.y[i] / accelNorm[i], accel.z[i] / accelNorm[i]);
+                correctWithAccel(accelVector, references.gravity);
+            }
+        } else {
+            std::size_t i = g++;
+            if (!gyroValid[i]) {
+                rejected[static_cast<int>(SensorType::Gyro)]++;
+            } else if (!running_) {
+                alignWithGyro(gyro.x[i], gyro.y[i], gyro.z[i]);
+            } else {
+                integrateGyro(gyro.x[i], gyro.y[i], gyro.z[i]);
+                referencesCurrent = false;
+                historyTimes_.push_back(gyro.timestamp[i]);
+                historyAttitudes_.push_back(quaternion_);
+            }
+        }
+    }
+
+    if (!historyTimes_.empty()) {
+        publishAttitude();
+        attitudeHistory_.append(historyTimes_.data(), historyAttitudes_.data(), historyTimes_.size());
+    }
+
+    const char* names[3] = {"mag", "accel", "gyro"};
+    for (int sensor = 0; sensor < 3; sensor++) {
+        if (rejected[sensor] > 0) {
+            std::cout << "Warning: " << rejected[sensor] << " invalid " << names[sensor] << " reading(s) detected, skipping update" << std::endl;
+        }
+    }
+}
+
+// World-to-body is the transpose of the attitude's rotation matrix; one matrix replaces the
+// conjugate-and-rotate quaternion products per reference vector
+Vector3F ComplementaryFilter::toBody(const Vector3F& world) const {
+    return LinearAlgebra::toVector3F(LinearAlgebra::transpose(LinearAlgebra::rotationMatrix(quaternion_)) * LinearAlgebra::toVector(world));
+}
+
+ComplementaryFilter::BodyReferences ComplementaryFilter::bodyReferences() const {
+    LinearAlgebra::Matrix3F worldToBody = LinearAlgebra::transpose(LinearAlgebra::rotationMatrix(quaternion_));
+    BodyReferences references;
+    references.gravity = LinearAlgebra::toVector3F(worldToBody * LinearAlgebra::toVector(exptectedGravityWorld_));
+    references.down = LinearAlgebra::toVector3F(worldToBody * LinearAlgebra::toVector(Vector3F(0.0f, 0.0f, 1.0f)));
+    references.east = LinearAlgebra::toVector3F(worldToBody * LinearAlgebra::toVector(exptectedEastWorld_));
+    return references;
+}
+
+void ComplementaryFilter::alignWithGyro(float gyroX, float gyroY, float gyroZ) {
+    noteAlignmentSample();
+    alignmentGyroSamples_++;
+    float rate = std::sqrt(gyroX * gyroX + gyroY * gyroY + gyroZ * gyroZ);
+    if (rate > alignmentMaxGyroRate) {
+        // Motion restarts the stationary window, unless we have already waited too long
+        if (alignmentElapsed() < alignmentTimeout) {
+            alignmentWindow_ = AlignmentWindow();
+        } else {
+            alignmentWindow_.stationary = false;
+        }
+    } else {
+        alignmentWindow_.gyroSum[0] += gyroX;
+        alignmentWindow_.gyroSum[1] += gyroY;
+        alignmentWindow_.gyroSum[2] += gyroZ;
+        alignmentWindow_.gyroCount++;
+    }
+    checkAlignment();
+}
+
+void ComplementaryFilter::alignWithAccel(float accelX, float accelY, float accelZ) {
+    noteAlignmentSample();
+    alignmentAccelSamples_++;
+    alignmentWindow_.accelSum[0] += accelX;
+    alignmentWindow_.accelSum[1] += accelY;
+    alignmentWindow_.accelSum[2] += accelZ;
+    alignmentWindow_.accelNormSum += std::sqrt(accelX * accelX + accelY * accelY + accelZ * accelZ);
+    alignmentWindow_.accelCount++;
+    checkAlignment();
+}
+
+void ComplementaryFilter::alignWithMag(float magX, float magY, float magZ) {
+    alignmentWindow_.magSum[0] += magX;
+    alignmentWindow_.magSum[1] += magY;
+    alignmentWindow_.magSum[2] += magZ;
+    alignmentWindow_.magCount++;
+}
+
+void ComplementaryFilter::integrateGyro(float gyroX, float gyroY, float gyroZ) {
     // Correct with proportional terms and reset. Accel and mag updates will set P terms again
     if (PTermRoll_ != 0.0f && PTermPitch_ != 0.0f) {   
         gyroX += PTermRoll_;
@@ -84,66 +298,158 @@ void ComplementaryFilter::updateWithGyro(float gyroX, float gyroY, float gyroZ){
     gyroZ += ITermYaw_; 
 
     // Update quaternion with corrected gyro data and normalize 
-    quaternion_ = updateQuaternionWithAngularVelocity(quaternion_, gyroX, gyroY, gyroZ, gyroDeltaT);
+    quaternion_ = updateQuaternionWithAngularVelocity(quaternion_, gyroX, gyroY, gyroZ, gyroDeltaT_);
     quaternion_ = normalizeQuaternion(quaternion_);
+}
 
+void ComplementaryFilter::correctWithAccel(const Vector3F& accelVector, const Vector3F& expectedGravityBody) {
+    // Get the error between the expected gravity and the measured gravity with cross product
+    Vector3F error = crossProduct(accelVector, expectedGravityBody);
+
+    // Update the correction vectors
+    PTermRoll_ = KpRollPitch_ * error.x;
+    PTermPitch_ = KpRollPitch_ * error.y;   
+    ITermRoll_ += KiRollPitch_ * error.x * gyroDeltaT_;
+    ITermPitch_ += KiRollPitch_ * error.y * gyroDeltaT_;
+}
+
+void ComplementaryFilter::correctWithMag(const Vector3F& magVector, const BodyReferences& references) {
+    //Get the measuredEast vector in the body frame using cross product with down body vector
+    Vector3F measuredEastBody = crossProduct(references.down, magVector);
+
+    // Get the error between the expected east and the measured east with cross product
+    Vector3F error = crossProduct(measuredEastBody, references.east);
+
+    // Update the correction vector
+    PTermYaw_ = KpYaw_ * error.z;
+    ITermYaw_ += KiYaw_ * error.z * gyroDeltaT_;
+}
+
+void ComplementaryFilter::publishAttitude() {
     attitude_.w = quaternion_.w;
     attitude_.x = quaternion_.x;
     attitude_.y = quaternion_.y;
     attitude_.z = quaternion_.z;
+    lastAttitudeUpdateNs_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
 }
 
-void ComplementaryFilter::updateWithAccel(float accelX, float accelY, float accelZ){
-    // Sanity check accel values
-    if (!isValidAccelReading(accelX, accelY, accelZ)) {
-        std::cout << "Warning: Invalid accel reading detected, skipping update" << std::endl;
-        return;
-    }
+void ComplementaryFilter::setGains(const Gains& gains) {
+    KpRollPitch_ = gains.kpRollPitch;
+    KiRollPitch_ = gains.kiRollPitch;
+    KpYaw_ = gains.kpYaw;
+    KiYaw_ = gains.kiYaw;
+}
 
-    // Normalize the accel vector 
-    Vector3F accelVector = normalizeVector(Vector3F(accelX, accelY, accelZ));
+void ComplementaryFilter::restoreState(const QuaternionF& attitude, const Vector3F& gyroCorrection) {
+    quaternion_ = normalizeQuaternion(attitude);
+    attitude_.w = quaternion_.w;
+    attitude_.x = quaternion_.x;
+    attitude_.y = quaternion_.y;
+    attitude_.z = quaternion_.z;
+    ITermRoll_ = gyroCorrection.x;
+    ITermPitch_ = gyroCorrection.y;
+    ITermYaw_ = gyroCorrection.z;
+    restored_.valid = true;
+    restored_.attitude = quaternion_;
+    restored_.gyroCorrection = gyroCorrection;
+}
+
+void ComplementaryFilter::startAlignment() {
+    running_ = false;
+    alignmentWindow_ = AlignmentWindow();
+    alignmentGyroSamples_ = 0;
+    alignmentAccelSamples_ = 0;
+    alignmentStatus_.aligned = false;
+}
 
-    // Get the expected gravity vector in the body frame using INVERSE rotation
-    QuaternionF invQuaternion = conjugateQuaternion(quaternion_);
-    Vector3F expectedGravityBody = rotateVectorByQuaternion(exptectedGravityWorld_, invQuaternion);
+void ComplementaryFilter::noteAlignmentSample() {
+    if (alignmentGyroSamples_ == 0 && alignmentAccelSamples_ == 0) {
+        alignmentStart_ = std::chrono::steady_clock::now();
+    }
+}
 
-    // Get the error between the expected gravity and the measured gravity with cross product
-    Vector3F error = crossProduct(accelVector, expectedGravityBody);
+float ComplementaryFilter::alignmentElapsed() const {
+    return std::max(alignmentGyroSamples_ * gyroDeltaT_, alignmentAccelSamples_ * accelDeltaT_);
+}
 
-    // Update the correction vectors
-    PTermRoll_ = KpRollPitch_ * error.x;
-    PTermPitch_ = KpRollPitch_ * error.y;   
-    ITermRoll_ += KiRollPitch_ * error.x * gyroDeltaT;
-    ITermPitch_ += KiRollPitch_ * error.y * gyroDeltaT;
+void ComplementaryFilter::checkAlignment() {
+    const AlignmentWindow& window = alignmentWindow_;
+    bool timedOut = alignmentElapsed() >= alignmentTimeout;
+    if (window.accelCount >= alignmentAccelTarget_ || (timedOut && window.accelCount > 0)) {
+        finishAlignment();
+    }
 }
 
-void ComplementaryFilter::updateWithMag(float magX, float magY, float magZ){
-    // Sanity check mag values
-    if (!isValidMagReading(magX, magY, magZ)) {
-        std::cout << "Warning: Invalid mag reading detected, skipping update" << std::endl;
-        return;
+void ComplementaryFilter::finishAlignment() {
+    const AlignmentWindow& window = alignmentWindow_;
+
+    // TRIAD from the averaged gravity and, when available, magnetometer readings
+    Vector3F accel(window.accelSum[0], window.accelSum[1], window.accelSum[2]);
+    Vector3F mag(0.0f, 0.0f, 0.0f);
+    if (window.magCount > 0) {
+        mag = Vector3F(window.magSum[0] / window.magCount, window.magSum[1] / window.magCount, window.magSum[2] / window.magCount);
     }
+    QuaternionF measured = attitudeFromGravityAndMag(accel, mag, window.magCount > 0);
 
-    // Normalize the mag vector
-    Vector3F magVector = normalizeVector(Vector3F(magX, magY, magZ));   
+    // A restored checkpoint attitude survives when the window agrees with it. With a mag heading
+    // the whole rotation is compared; without one only the tilt is observable, and the restored
+    // heading is a better guess than the arbitrary one TRIAD picks
+    bool attitudeRestored = false;
+    if (restored_.valid) {
+        float change;
+        if (window.magCount > 0) {
+            float dot = std::abs(measured.w * restored_.attitude.w + measured.x * restored_.attitude.x +
+                                 measured.y * restored_.attitude.y + measured.z * restored_.attitude.z);
+            change = 2.0f * std::acos(std::min(dot, 1.0f));
+        } else {
+            quaternion_ = restored_.attitude;
+            float cosine = dotProduct(normalizeVector(accel), toBody(exptectedGravityWorld_));
+            change = std::acos(std::clamp(cosine, -1.0f, 1.0f));
+        }
+        attitudeRestored = change <= checkpointMaxAttitudeChange;
+    }
+    quaternion_ = attitudeRestored ? restored_.attitude : measured;
 
-    // Get the down vector in the body frame using INVERSE rotation
-    QuaternionF invQuaternion = conjugateQuaternion(quaternion_);
-    Vector3F downBody = rotateVectorByQuaternion(Vector3F(0.0f, 0.0f, 1.0f), invQuaternion);
+    // The restored gyro correction passed the checkpoint age and temperature checks and was
+    // integrated over far longer than the window, so it wins. Otherwise a stationary window gives
+    // the gyro bias directly; the integral terms cancel it
+    bool biasRestored = restored_.valid;
+    bool biasEstimated = !biasRestored && window.stationary && window.gyroCount > 0;
+    if (biasRestored) {
+        ITermRoll_ = restored_.gyroCorrection.x;
+        ITermPitch_ = restored_.gyroCorrection.y;
+        ITermYaw_ = restored_.gyroCorrection.z;
+    } else if (biasEstimated) {
+        ITermRoll_ = -window.gyroSum[0] / window.gyroCount;
+        ITermPitch_ = -window.gyroSum[1] / window.gyroCount;
+        ITermYaw_ = -window.gyroSum[2] / window.gyroCount;
+    }
+    restored_.valid = false;
+    PTermRoll_ = 0.0f;
+    PTermPitch_ = 0.0f;
+    PTermYaw_ = 0.0f;
 
-    //Get the measuredEast vector in the body frame using cross product with down body vector
-    Vector3F measuredEastBody = crossProduct(downBody, magVector);
+    attitude_.w = quaternion_.w;
+    attitude_.x = quaternion_.x;
+    attitude_.y = quaternion_.y;
+    attitude_.z = quaternion_.z;
 
-    // Get the expected east vector in the body frame using INVERSE rotation
-    Vector3F expectedEastBody = rotateVectorByQuaternion(exptectedEastWorld_, invQuaternion);
+    // Gravity in the device's accel units; a moving window only stands in until a still one measures it
+    if (window.stationary || gravityMagnitude_.load(std::memory_order_relaxed) == 0.0f) {
+        gravityMagnitude_.store(window.accelNormSum / window.accelCount, std::memory_order_relaxed);
+    }
 
-    // Get measured east vector in the world frame using rotation
-    Vector3F measuredEastWorld = rotateVectorByQuaternion(measuredEastBody, quaternion_);
-    
-    // Get the error between the expected east and the measured east with cross product
-    Vector3F error = crossProduct(measuredEastBody, expectedEastBody);
+    alignmentStatus_.aligned = true;
+    alignmentStatus_.gyroBiasEstimated = biasEstimated;
+    alignmentStatus_.gyroBiasRestored = biasRestored;
+    alignmentStatus_.attitudeRestored = attitudeRestored;
+    alignmentStatus_.timeToAlign = alignmentElapsed();
+    alignmentStatus_.hostTimeToAlign = std::chrono::duration<float>(std::chrono::steady_clock::now() - alignmentStart_).count();
+    alignmentStatus_.alignments++;
+    running_ = true;
 
-    // Update the correction vector
-    PTermYaw_ = KpYaw_ * error.z;
-    ITermYaw_ += KiYaw_ * error.z * gyroDeltaT;
-}
\ No newline at end of file
+    std::cout << "[Filter] Aligned after " << alignmentStatus_.timeToAlign << " s ("
+              << (biasRestored ? "gyro bias from checkpoint" : biasEstimated ? "gyro bias estimated" : "moving, gyro bias kept")
+              << (attitudeRestored ? ", attitude from checkpoint" : "")
+              << (window.magCount > 0 ? ", heading from mag" : ", no mag heading") << ")" << std::endl;
+}
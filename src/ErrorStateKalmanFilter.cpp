@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ErrorStateKalmanFilter.h"
+
+using namespace Math3D;
+using namespace LinearAlgebra;
+
+ErrorStateKalmanFilter::ErrorStateKalmanFilter(const SensorRates& rates)
+    : rates_(rates),
+      gyroDeltaT_(rates.deltaT(SensorType::Gyro)),
+      alignmentAccelTarget_(std::max(1, static_cast<int>(rates.accel * alignmentAccelSeconds))) {
+    // Continuous white noise integrated over one gyro period
+    for (std::size_t i = 0; i < 3; i++) {
+        processNoise_(i, i) = eskfGyroNoiseDensity * eskfGyroNoiseDensity * gyroDeltaT_;
+        processNoise_(i + 3, i + 3) = eskfGyroBiasWalk * eskfGyroBiasWalk * gyroDeltaT_;
+    }
+}
+
+void ErrorStateKalmanFilter::updateWithGyro(float gyroX, float gyroY, float gyroZ, float timestamp) {
+    (void)timestamp;
+    if (!std::isfinite(gyroX) || !std::isfinite(gyroY) || !std::isfinite(gyroZ)) return;
+
+    if (!aligned_) {
+        if (std::sqrt(gyroX * gyroX + gyroY * gyroY + gyroZ * gyroZ) > alignmentMaxGyroRate) {
+            alignmentStationary_ = false;
+        }
+        alignmentGyroSum_[0] += gyroX;
+        alignmentGyroSum_[1] += gyroY;
+        alignmentGyroSum_[2] += gyroZ;
+        alignmentGyroCount_++;
+        return;
+    }
+
+    Vector3 rate;
+    rate[0] = gyroX - bias_[0];
+    rate[1] = gyroY - bias_[1];
+    rate[2] = gyroZ - bias_[2];
+    quaternion_ = integrateQuaternionExact(quaternion_, rate[0], rate[1], rate[2], gyroDeltaT_);
+
+    // Error dynamics: d(attitude error)/dt = -rate x (attitude error) - (bias error)
+    Covariance transition = Covariance::identity();
+    transition.setBlock(0, 0, Matrix3F::identity() - skew(rate) * gyroDeltaT_);
+    transition.setBlock(0, 3, Matrix3F::diagonal(-gyroDeltaT_));
+
+    covariance_ = multiplyTransposed(transition * covariance_, transition) + processNoise_;
+}
+
+void ErrorStateKalmanFilter::updateWithAccel(float accelX, float accelY, float accelZ) {
+    float norm = std::sqrt(accelX * accelX + accelY * accelY + accelZ * accelZ);
+    if (!std::isfinite(norm) || norm <= 0.0f) return;
+
+    if (!aligned_) {
+        alignmentAccelSum_[0] += accelX;
+        alignmentAccelSum_[1] += accelY;
+        alignmentAccelSum_[2] += accelZ;
+        alignmentAccelNormSum_ += norm;
+        alignmentAccelCount_++;
+        if (alignmentAccelCount_ >= alignmentAccelTarget_) finishAlignment();
+        return;
+    }
+
+    // Only a reading close to 1 g measures the gravity direction
+    if (std::abs(norm / gravityNorm_ - 1.0f) > eskfAccelGate) return;
+
+    // Expected gravity direction in the body frame, R^T (0, 0, -1), and its error Jacobian
+    Matrix3F rotation = rotationMatrix(quaternion_);
+    Vector3 expected;
+    for (std::size_t i = 0; i < 3; i++) expected[i] = -rotation(2, i);
+    Matrix3F jacobian = skew(expected);   // d(expected)/d(attitude error); zero for the bias
+
+    Vector3 innovation;
+    innovation[0] = accelX / norm - expected[0];
+    innovation[1] = accelY / norm - expected[1];
+    innovation[2] = accelZ / norm - expected[2];
+
+    // H P, with H = [jacobian 0]
+    MatrixF<3, ERROR_STATES> hp = jacobian * covariance_.block<3, ERROR_STATES>(0, 0);
+    Matrix3F innovationCovariance = multiplyTransposed(hp.block<3, 3>(0, 0), jacobian) +
+                                    Matrix3F::diagonal(eskfAccelNoise * eskfAccelNoise);
+    Matrix3F inverse;
+    if (!invert(innovationCovariance, inverse)) return;
+
+    // K = P H^T S^-1 = (H P)^T S^-1
+    MatrixF<ERROR_STATES, 3> gain = transpose(hp) * inverse;
+    inject(gain * innovation);
+    covariance_ = symmetrize(covariance_ - gain * hp);
+}
+
+void ErrorStateKalmanFilter::updateWithMag(float magX, float magY, float magZ) {
+    if (!std::isfinite(magX) || !std::isfinite(magY) || !std::isfinite(magZ)) return;
+
+    if (!aligned_) {
+        alignmentMagSum_[0] += magX;
+        alignmentMagSum_[1] += magY;
+        alignmentMagSum_[2] += magZ;
+        alignmentMagCount_++;
+        return;
+    }
+
+    // Measured east in the body frame (down x mag), taken to the world frame with the current
+    // attitude. It is horizontal by construction, so only its heading carries information
+    Matrix3F rotation = rotationMatrix(quaternion_);
+    Vector3F downBody(rotation(2, 0), rotation(2, 1), rotation(2, 2));
+    Vector3F eastBody = crossProduct(downBody, Vector3F(magX, magY, magZ));
+    if (dotProduct(eastBody, eastBody) < 1e-6f) return;   // Field along the vertical
+    Vector3 eastWorld = rotation * toVector(eastBody);
+
+    // Heading error about world Z: east rotates from +Y towards +X by the world-frame error angle
+    float innovation = std::atan2(eastWorld[0], eastWorld[1]);
+
+    // H = [row 2 of R, 0]: the world Z component of the body-frame attitude error
+    VectorF<ERROR_STATES> ph;   // P H^T
+    for (std::size_t r = 0; r < ERROR_STATES; r++) {
+        ph[r] = covariance_(r, 0) * rotation(2, 0) + covariance_(r, 1) * rotation(2, 1) + covariance_(r, 2) * rotation(2, 2);
+    }
+    float innovationVariance = ph[0] * rotation(2, 0) + ph[1] * rotation(2, 1) + ph[2] * rotation(2, 2) +
+                               eskfHeadingNoise * eskfHeadingNoise;
+
+    VectorF<ERROR_STATES> gain = ph * (1.0f / innovationVariance);
+    inject(gain * innovation);
+    covariance_ = symmetrize(covariance_ - multiplyTransposed(gain, ph));
+}
+
+// Fold an error-state estimate into the nominal state; the error state is zero again afterwards
+void ErrorStateKalmanFilter::inject(const VectorF<ERROR_STATES>& correction) {
+    QuaternionF delta = {1.0f, 0.5f * correction[0], 0.5f * correction[1], 0.5f * correction[2]};
+    quaternion_ = normalizeQuaternion(multiplyQuaternions(quaternion_, delta));
+    bias_[0] += correction[3];
+    bias_[1] += correction[4];
+    bias_[2] += correction[5];
+}
+
+void ErrorStateKalmanFilter::finishAlignment() {
+    Vector3F accel(alignmentAccelSum_[0], alignmentAccelSum_[1], alignmentAccelSum_[2]);
+    Vector3F mag(0.0f, 0.0f, 0.0f);
+    if (alignmentMagCount_ > 0) {
+        mag = Vector3F(alignmentMagSum_[0] / alignmentMagCount_, alignmentMagSum_[1] / alignmentMagCount_,
+                       alignmentMagSum_[2] / alignmentMagCount_);
+    }
+    quaternion_ = attitudeFromGravityAndMag(accel, mag, alignmentMagCount_ > 0);
+    gravityNorm_ = alignmentAccelNormSum_ / alignmentAccelCount_;
+
+    // A still device reads its bias directly; otherwise start from zero with the prior uncertainty
+    if (alignmentStationary_ && alignmentGyroCount_ > 0) {
+        for (std::size_t i = 0; i < 3; i++) bias_[i] = alignmentGyroSum_[i] / alignmentGyroCount_;
+    }
+
+    covariance_ = Covariance::zero();
+    for (std::size_t i = 0; i < 3; i++) {
+        covariance_(i, i) = eskfInitialAttitudeSigma * eskfInitialAttitudeSigma;
+        covariance_(i + 3, i + 3) = eskfInitialBiasSigma * eskfInitialBiasSigma;
+    }
+    aligned_ = true;
+}
+
+Vector3F ErrorStateKalmanFilter::getAttitudeSigma() const {
+    return Vector3F(std::sqrt(covariance_(0, 0)), std::sqrt(covariance_(1, 1)), std::sqrt(covariance_(2, 2)));
+}
+
+Vector3F ErrorStateKalmanFilter::getBiasSigma() const {
+    return Vector3F(std::sqrt(covariance_(3, 3)), std::sqrt(covariance_(4, 4)), std::sqrt(covariance_(5, 5)));
+}
@@ -0,0 +1,238 @@
+#include <cmath>
+#include <algorithm>
+
+#include "MagCalibrator.h"
+
+namespace {
+    // Cyclic Jacobi eigen decomposition of a symmetric 3x3 matrix: a = v * diag(eig) * v^T
+    void symmetricEigen3(const double a[3][3], double eig[3], double v[3][3]) {
+        double m[3][3];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                m[i][j] = a[i][j];
+                v[i][j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        for (int sweep = 0; sweep < 20; sweep++) {
+            double off = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+            if (off < 1e-24) break;
+
+            for (int p = 0; p < 2; p++) {
+                for (int q = p + 1; q < 3; q++) {
+                    if (std::abs(m[p][q]) < 1e-300) continue;
+                    double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+                    double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c = 1.0 / std::sqrt(t * t + 1.0);
+                    double s = t * c;
+
+                    for (int k = 0; k < 3; k++) {
+                        double mkp = m[k][p], mkq = m[k][q];
+                        m[k][p] = c * mkp - s * mkq;
+                        m[k][q] = s * mkp + c * mkq;
+                    }
+                    for (int k = 0; k < 3; k++) {
+                        double mpk = m[p][k], mqk = m[q][k];
+                        m[p][k] = c * mpk - s * mqk;
+                        m[q][k] = s * mpk + c * mqk;
+                    }
+                    for (int k = 0; k < 3; k++) {
+                        double vkp = v[k][p], vkq = v[k][q];
+                        v[k][p] = c * vkp - s * vkq;
+                        v[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < 3; i++) eig[i] = m[i][i];
+    }
+
+    // Solve the symmetric positive definite system a * x = b with Cholesky. Returns false if not SPD
+    template <int N>
+    bool choleskySolve(double a[N][N], double b[N], double x[N]) {
+        double l[N][N] = {};
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j <= i; j++) {
+                double sum = a[j][i];   // Upper triangle holds the data
+                for (int k = 0; k < j; k++) sum -= l[i][k] * l[j][k];
+                if (i == j) {
+                    if (sum <= 0.0) return false;
+                    l[i][i] = std::sqrt(sum);
+                } else {
+                    l[i][j] = sum / l[j][j];
+                }
+            }
+        }
+        double y[N];
+        for (int i = 0; i < N; i++) {
+            double sum = b[i];
+            for (int k = 0; k < i; k++) sum -= l[i][k] * y[k];
+            y[i] = sum / l[i][i];
+        }
+        for (int i = N - 1; i >= 0; i--) {
+            double sum = y[i];
+            for (int k = i + 1; k < N; k++) sum -= l[k][i] * x[k];
+            x[i] = sum / l[i][i];
+        }
+        return true;
+    }
+}
+
+MagCalibrator::MagCalibrator() {
+    reset();
+}
+
+void MagCalibrator::reset() {
+    for (int i = 0; i < N; i++) {
+        normalVector_[i] = 0.0;
+        for (int j = 0; j < N; j++) normalMatrix_[i][j] = 0.0;
+    }
+    for (float& weight : binWeight_) weight = 0.0f;
+    totalWeight_ = 0.0f;
+    samplesSinceSolve_ = 0;
+    residualSquared_ = 1.0f;
+    haveFit_ = false;
+    status_ = Status();
+    publishStatus();
+}
+
+MagCalibrator::Status MagCalibrator::getStatus() const {
+    std::lock_guard<std::mutex> lock(statusMtx_);
+    return publishedStatus_;
+}
+
+void MagCalibrator::publishStatus() {
+    std::lock_guard<std::mutex> lock(statusMtx_);
+    publishedStatus_ = status_;
+}
+
+void MagCalibrator::addSample(float magX, float magY, float magZ) {
+    if (resetRequested_.exchange(false, std::memory_order_acquire)) {
+        reset();
+    }
+
+    // Ignore readings that are clearly not a magnetic field measurement
+    if (!std::isfinite(magX) || !std::isfinite(magY) || !std::isfinite(magZ)) return;
+    if (std::sqrt(magX * magX + magY * magY + magZ * magZ) > MAX_RAW_MAGNITUDE) return;
+
+    // Track fit quality with the current solution before it absorbs this sample
+    if (haveFit_) {
+        Vector3F corrected = correct(magX, magY, magZ);
+        float magnitude = std::sqrt(corrected.x * corrected.x + corrected.y * corrected.y + corrected.z * corrected.z);
+        float error = (magnitude - status_.fieldStrength) / status_.fieldStrength;
+        residualSquared_ += RESIDUAL_SMOOTHING * (error * error - residualSquared_);
+        status_.residual = std::sqrt(residualSquared_);
+    }
+    updateCoverage(magX, magY, magZ);
+
+    // Regressor for the ellipsoid equation, in scaled units
+    double x = magX / INPUT_SCALE, y = magY / INPUT_SCALE, z = magZ / INPUT_SCALE;
+    const double phi[N] = { x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z };
+
+    // Rank-one update of the forgotten normal equations (upper triangle only)
+    for (int i = 0; i < N; i++) {
+        normalVector_[i] = FORGETTING * normalVector_[i] + phi[i];
+        for (int j = i; j < N; j++) {
+            normalMatrix_[i][j] = FORGETTING * normalMatrix_[i][j] + phi[i] * phi[j];
+        }
+    }
+
+    status_.samples++;
+    if (++samplesSinceSolve_ >= SOLVE_INTERVAL && status_.samples >= MIN_SAMPLES) {
+        samplesSinceSolve_ = 0;
+        solve();
+    }
+    publishStatus();
+}
+
+Vector3F MagCalibrator::correct(float magX, float magY, float magZ) const {
+    float dx = magX - status_.offset.x;
+    float dy = magY - status_.offset.y;
+    float dz = magZ - status_.offset.z;
+    const float (&w)[3][3] = status_.softIron;
+    return Vector3F(w[0][0] * dx + w[0][1] * dy + w[0][2] * dz,
+                    w[1][0] * dx + w[1][1] * dy + w[1][2] * dz,
+                    w[2][0] * dx + w[2][1] * dy + w[2][2] * dz);
+}
+
+void MagCalibrator::solve() {
+    double p[N];
+    if (!choleskySolve<N>(normalMatrix_, normalVector_, p)) return;
+
+    // Quadric matrix A and linear term v of x^T A x + 2 v^T x = 1
+    double a[3][3] = {{p[0], p[3], p[4]}, {p[3], p[1], p[5]}, {p[4], p[5], p[2]}};
+    double v[3] = {p[6], p[7], p[8]};
+
+    // Center c = -A^-1 v
+    double eig[3], vec[3][3];
+    symmetricEigen3(a, eig, vec);
+    if (eig[0] <= 0.0 || eig[1] <= 0.0 || eig[2] <= 0.0) return;   // Not an ellipsoid (yet)
+
+    double center[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) {
+            double projection = vec[0][k] * v[0] + vec[1][k] * v[1] + vec[2][k] * v[2];
+            center[i] -= vec[i][k] * projection / eig[k];
+        }
+    }
+
+    // Normalize so that (x - c)^T (A / k) (x - c) = 1
+    double k = 1.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) k += center[i] * a[i][j] * center[j];
+    }
+    if (k <= 0.0) return;
+
+    // Radii along the principal axes, and their geometric mean as the field strength
+    double radii[3];
+    for (int i = 0; i < 3; i++) radii[i] = std::sqrt(k / eig[i]);
+    double radius = std::cbrt(radii[0] * radii[1] * radii[2]);
+    double axisRatio = *std::max_element(radii, radii + 3) / *std::min_element(radii, radii + 3);
+
+    // A fit from too narrow a set of recent directions does not replace one that still matches the data
+    bool valid = status_.coverage >= MIN_COVERAGE && status_.residual <= MAX_RESIDUAL && axisRatio <= MAX_AXIS_RATIO;
+    if (!valid && status_.valid && status_.residual <= MAX_RESIDUAL) return;
+
+    // Symmetric soft-iron correction W = V * diag(radius / r_i) * V^T maps the ellipsoid onto a sphere without rotating it
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            double sum = 0.0;
+            for (int m = 0; m < 3; m++) sum += vec[i][m] * (radius / radii[m]) * vec[j][m];
+            status_.softIron[i][j] = static_cast<float>(sum);
+        }
+    }
+    status_.offset = Vector3F(static_cast<float>(center[0] * INPUT_SCALE),
+                              static_cast<float>(center[1] * INPUT_SCALE),
+                              static_cast<float>(center[2] * INPUT_SCALE));
+    status_.fieldStrength = static_cast<float>(radius * INPUT_SCALE);
+
+    if (!haveFit_) {
+        haveFit_ = true;
+        residualSquared_ = 1.0f;
+    }
+    status_.valid = valid;
+}
+
+void MagCalibrator::updateCoverage(float x, float y, float z) {
+    // Bin the field direction around the current center estimate on an equal-area sphere grid
+    x -= status_.offset.x;
+    y -= status_.offset.y;
+    z -= status_.offset.z;
+    float magnitude = std::sqrt(x * x + y * y + z * z);
+    if (magnitude <= 0.0f) return;
+
+    constexpr float pi = 3.14159265f;
+    float azimuth = std::atan2(y, x) + pi;   // [0, 2pi]
+    int azimuthBin = std::min(AZIMUTH_BINS - 1, static_cast<int>(azimuth / (2.0f * pi) * AZIMUTH_BINS));
+    int elevationBin = std::min(ELEVATION_BINS - 1, static_cast<int>((z / magnitude + 1.0f) * 0.5f * ELEVATION_BINS));
+
+    // Same forgetting as the normal equations: a long stay in one direction ages the others out
+    constexpr float forgetting = static_cast<float>(FORGETTING);
+    totalWeight_ = forgetting * totalWeight_ + 1.0f;
+    for (float& weight : binWeight_) weight *= forgetting;
+    binWeight_[elevationBin * AZIMUTH_BINS + azimuthBin] += 1.0f;
+
+    int visited = 0;
+    for (float weight : binWeight_) visited += weight >= MIN_BIN_SHARE * totalWeight_;
+    status_.coverage = static_cast<float>(visited) / BINS;
+}
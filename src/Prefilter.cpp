@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "Prefilter.h"
+
+Prefilter::Prefilter(const SensorRates& rates) : rates_(rates) {
+    for (std::atomic<bool>& changed : changed_) {
+        changed = false;
+    }
+}
+
+void Prefilter::setChain(SensorType sensor, const Chain& chain) {
+    int index = static_cast<int>(sensor);
+    {
+        std::lock_guard<std::mutex> lock(chainMtx_);
+        chains_[index] = chain;
+    }
+    changed_[index].store(true, std::memory_order_release);
+}
+
+Prefilter::Chain Prefilter::getChain(SensorType sensor) const {
+    std::lock_guard<std::mutex> lock(chainMtx_);
+    return chains_[static_cast<int>(sensor)];
+}
+
+void Prefilter::apply(SensorSample& sample) {
+    int index = static_cast<int>(sample.type);
+    if (changed_[index].exchange(false, std::memory_order_acquire)) {
+        retune(index);
+    }
+
+    Stage& stage = stages_[index];
+    if (!stage.active && !stage.cascade.isRamping()) return;
+
+    float lanes[4] = {sample.x, sample.y, sample.z, 0.0f};
+    stage.cascade.process(lanes);
+    sample.x = lanes[0];
+    sample.y = lanes[1];
+    sample.z = lanes[2];
+}
+
+void Prefilter::retune(int index) {
+    Chain chain;
+    {
+        std::lock_guard<std::mutex> lock(chainMtx_);
+        chain = chains_[index];
+    }
+
+    float rate = sampleRate(static_cast<SensorType>(index));
+    BiquadCoefficients coefficients[prefilterSections];
+    std::size_t count = 0;
+    for (const Section& section : chain) {
+        float q = std::max(section.q, 0.1f);
+        if (section.type == SectionType::LowPass) {
+            coefficients[count++] = BiquadCoefficients::lowPass(section.frequency, rate, q);
+        } else if (section.type == SectionType::Notch) {
+            coefficients[count++] = BiquadCoefficients::notch(section.frequency, rate, q);
+        }
+    }
+
+    Stage& stage = stages_[index];
+    if (!stage.active && !stage.cascade.isRamping()) {
+        // Idle cascades hold stale state from before they were switched off
+        stage.cascade.reset();
+    }
+    stage.cascade.retune(coefficients, count);
+    stage.active = count > 0;
+}
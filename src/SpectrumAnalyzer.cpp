@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "SpectrumAnalyzer.h"
+
+static_assert((spectrumFFTSize & (spectrumFFTSize - 1)) == 0, "spectrumFFTSize must be a power of two");
+
+SpectrumAnalyzer::Stream::Stream(float rate) : sampleRate(rate) {
+    for (int axis = 0; axis < 3; axis++) {
+        history[axis].assign(spectrumFFTSize, 0.0f);
+        power[axis].assign(spectrumFFTSize / 2 + 1, 0.0f);
+    }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const SensorRates& rates)
+    : gyroBuffer_(gyroBuffer), accelBuffer_(accelBuffer),
+      plan_(spectrumFFTSize), window_(spectrumFFTSize), windowPower_(0.0f),
+      re_(spectrumFFTSize), im_(spectrumFFTSize),
+      gyro_(rates.gyro), accel_(rates.accel) {
+    // Periodic Hann window
+    for (std::size_t i = 0; i < spectrumFFTSize; i++) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / spectrumFFTSize);
+        windowPower_ += window_[i] * window_[i];
+    }
+    hop_ = std::max<std::size_t>(1, static_cast<std::size_t>(spectrumFFTSize * (1.0f - spectrumOverlap)));
+
+    for (std::vector<float>& axis : scratch_) {
+        axis.resize(std::max(gyroBufferSize, accelBufferSize));
+    }
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    stop();
+}
+
+void SpectrumAnalyzer::start() {
+    if (running_) return;
+
+    // Start from an empty window so stale history does not smear into the first spectrum
+    for (Stream* stream : {&gyro_, &accel_}) {
+        stream->filled = 0;
+        stream->pending = 0;
+        stream->segments = 0;
+    }
+    gyro_.since = gyroBuffer_.getWriteCount();
+    accel_.since = accelBuffer_.getWriteCount();
+
+    running_ = true;
+    worker_ = std::thread([this] { run(); });
+}
+
+void SpectrumAnalyzer::stop() {
+    running_ = false;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void SpectrumAnalyzer::getGyroSpectrum(Spectrum& out) const {
+    copySpectrum(gyro_, out);
+}
+
+void SpectrumAnalyzer::getAccelSpectrum(Spectrum& out) const {
+    copySpectrum(accel_, out);
+}
+
+void SpectrumAnalyzer::copySpectrum(const Stream& stream, Spectrum& out) const {
+    std::lock_guard<std::mutex> lock(spectrumMtx_);
+    out.frequencies.assign(stream.published.frequencies.begin(), stream.published.frequencies.end());
+    for (int axis = 0; axis < 3; axis++) {
+        out.density[axis].assign(stream.published.density[axis].begin(), stream.published.density[axis].end());
+    }
+    out.segments = stream.published.segments;
+}
+
+void SpectrumAnalyzer::run() {
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+        drain(gyroBuffer_, gyro_);
+        drain(accelBuffer_, accel_);
+    }
+}
+
+template <std::size_t Capacity>
+void SpectrumAnalyzer::drain(const ThreadSafeRingBuffer3D<Capacity>& buffer, Stream& stream) {
+    std::size_t copied = buffer.copySince(stream.since, scratch_[0].data(), scratch_[1].data(), scratch_[2].data());
+    if (copied == 0) return;
+
+    uint64_t segmentsBefore = stream.segments;
+    for (std::size_t i = 0; i < copied; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            stream.history[axis][stream.position] = scratch_[axis][i];
+        }
+        stream.position = (stream.position + 1) % spectrumFFTSize;
+        stream.filled = std::min(stream.filled + 1, spectrumFFTSize);
+
+        if (++stream.pending >= hop_ && stream.filled == spectrumFFTSize) {
+            analyze(stream);
+            stream.pending = 0;
+        }
+    }
+
+    if (stream.segments != segmentsBefore) {
+        publish(stream);
+    }
+}
+
+void SpectrumAnalyzer::analyze(Stream& stream) {
+    const std::size_t bins = spectrumFFTSize / 2 + 1;
+    // One-sided PSD scaling; the Welch average weights segments equally until spectrumAverages are reached
+    const float scale = 2.0f / (stream.sampleRate * windowPower_);
+    const float alpha = 1.0f / static_cast<float>(std::min<uint64_t>(stream.segments + 1, spectrumAverages));
+
+    for (int axis = 0; axis < 3; axis++) {
+        // Unroll the circular history oldest first, removing the mean (gravity, bias) before windowing
+        const std::vector<float>& history = stream.history[axis];
+        std::size_t head = spectrumFFTSize - stream.position;
+        std::copy(history.begin() + stream.position, history.end(), re_.begin());
+        std::copy(history.begin(), history.begin() + stream.position, re_.begin() + head);
+
+        float mean = 0.0f;
+        for (std::size_t i = 0; i < spectrumFFTSize; i++) {
+            mean += re_[i];
+        }
+        mean /= spectrumFFTSize;
+        for (std::size_t i = 0; i < spectrumFFTSize; i++) {
+            re_[i] = (re_[i] - mean) * window_[i];
+            im_[i] = 0.0f;
+        }
+
+        plan_.forward(re_.data(), im_.data());
+
+        std::vector<float>& power = stream.power[axis];
+        for (std::size_t k = 0; k < bins; k++) {
+            float p = (re_[k] * re_[k] + im_[k] * im_[k]) * scale;
+            power[k] += alpha * (p - power[k]);
+        }
+    }
+    stream.segments++;
+}
+
+void SpectrumAnalyzer::publish(Stream& stream) {
+    const std::size_t bins = spectrumFFTSize / 2 + 1;
+    std::lock_guard<std::mutex> lock(spectrumMtx_);
+    Spectrum& out = stream.published;
+    out.frequencies.resize(bins);
+    for (std::size_t k = 0; k < bins; k++) {
+        out.frequencies[k] = k * stream.sampleRate / spectrumFFTSize;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        out.density[axis].resize(bins);
+        for (std::size_t k = 0; k < bins; k++) {
+            // Floor keeps the log-scaled plot defined where the mean removal zeroes the DC bin
+            out.density[axis][k] = std::sqrt(std::max(stream.power[axis][k], 1e-18f));
+        }
+    }
+    out.segments = stream.segments;
+}
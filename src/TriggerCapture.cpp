@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "TriggerCapture.h"
+
+std::vector<TriggerScanner::Rule> TriggerScanner::defaultRules() {
+    return {
+        {"free-fall", SensorType::Accel, Measure::Magnitude, false, triggerFreeFallAccel, triggerFreeFallSeconds, true},
+        {"shock", SensorType::Accel, Measure::Magnitude, true, triggerShockAccel, 0.0f, true},
+        {"gyro-saturation", SensorType::Gyro, Measure::LargestAxis, true,
+         triggerSaturationFraction * ComplementaryFilter::MAX_GYRO_RATE, 0.0f},
+    };
+}
+
+TriggerScanner::TriggerScanner(const std::vector<Rule>& rules, const SensorRates& rates)
+    : rules_(rules.begin(), rules.begin() + std::min<std::size_t>(rules.size(), MAX_RULES)) {
+    for (std::size_t r = 0; r < rules_.size(); r++) {
+        threshold2_[r] = rules_[r].threshold * rules_[r].threshold;
+        enabled_[r] = !rules_[r].perGravity;
+        holdSamples_[r] = std::max(1, static_cast<int>(std::lround(rules_[r].holdSeconds * rates.rate(rules_[r].sensor))));
+        run_[r] = 0;
+    }
+}
+
+void TriggerScanner::setGravity(float gravity) {
+    for (std::size_t r = 0; r < rules_.size(); r++) {
+        if (!rules_[r].perGravity) continue;
+        float threshold = rules_[r].threshold * gravity;
+        threshold2_[r] = threshold * threshold;
+        enabled_[r] = gravity > 0.0f;
+        run_[r] = 0;
+    }
+}
+
+std::size_t TriggerScanner::scan(SensorType sensor, const float* x, const float* y, const float* z, std::size_t n,
+                                 Hit* hits, std::size_t maxHits) {
+    if (magnitude2_.size() < n) {
+        magnitude2_.resize(n);
+        largestAxis2_.resize(n);
+    }
+
+    // Both measures for the whole block, without square roots
+    float* magnitude2 = magnitude2_.data();
+    float* largestAxis2 = largestAxis2_.data();
+    for (std::size_t i = 0; i < n; i++) {
+        float xx = x[i] * x[i], yy = y[i] * y[i], zz = z[i] * z[i];
+        magnitude2[i] = xx + yy + zz;
+        largestAxis2[i] = std::max(xx, std::max(yy, zz));
+    }
+
+    std::size_t found = 0;
+    for (std::size_t r = 0; r < rules_.size(); r++) {
+        const Rule& rule = rules_[r];
+        if (rule.sensor != sensor || !enabled_[r]) continue;
+        const float* measure = rule.measure == Measure::Magnitude ? magnitude2 : largestAxis2;
+        const float threshold = threshold2_[r];
+
+        // Most blocks have no sample past the threshold: one vectorized count rules them out
+        if (run_[r] == 0) {
+            int met = 0;
+            if (rule.above) {
+                for (std::size_t i = 0; i < n; i++) met += measure[i] > threshold;
+            } else {
+                for (std::size_t i = 0; i < n; i++) met += measure[i] < threshold;
+            }
+            if (met == 0) continue;
+        }
+
+        // Count the run of samples meeting the rule; it fires when the run reaches the hold time
+        int run = run_[r];
+        const int hold = holdSamples_[r];
+        for (std::size_t i = 0; i < n; i++) {
+            bool met = rule.above ? measure[i] > threshold : measure[i] < threshold;
+            run = met ? std::min(run + 1, hold + 1) : 0;
+            if (run == hold && found < maxHits) {
+                hits[found++] = {i, static_cast<int>(r)};
+            }
+        }
+        run_[r] = run;
+    }
+    return found;
+}
+
+TriggerCapture::TriggerCapture(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer,
+                               const GyroTimesBuffer& gyroTimesBuffer, const AccelTimesBuffer& accelTimesBuffer,
+                               const MagTimesBuffer& magTimesBuffer, const ComplementaryFilter& filter, const std::string& directory)
+    : gyroBuffer_(gyroBuffer), accelBuffer_(accelBuffer), magBuffer_(magBuffer),
+      gyroTimesBuffer_(gyroTimesBuffer), accelTimesBuffer_(accelTimesBuffer), magTimesBuffer_(magTimesBuffer),
+      filter_(filter), directory_(directory), scanner_(TriggerScanner::defaultRules(), filter.getRates()) {
+    std::size_t capacities[3] = {magBufferSize, accelBufferSize, gyroBufferSize};
+    for (int s = 0; s < 3; s++) {
+        for (std::vector<float>* column : {&streams_[s].t, &streams_[s].x, &streams_[s].y, &streams_[s].z}) {
+            column->resize(capacities[s]);
+        }
+    }
+}
+
+TriggerCapture::~TriggerCapture() {
+    stop();
+}
+
+void TriggerCapture::start() {
+    if (running_ || directory_.empty()) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "[Trigger] Could not create " << directory_ << ": " << ec.message() << std::endl;
+        return;
+    }
+
+    // Only samples that arrive from now on are scanned
+    streams_[static_cast<int>(SensorType::Mag)].since = std::min(magBuffer_.getWriteCount(), magTimesBuffer_.getWriteCount());
+    streams_[static_cast<int>(SensorType::Accel)].since = std::min(accelBuffer_.getWriteCount(), accelTimesBuffer_.getWriteCount());
+    streams_[static_cast<int>(SensorType::Gyro)].since = std::min(gyroBuffer_.getWriteCount(), gyroTimesBuffer_.getWriteCount());
+    capture_ = Capture();
+
+    running_ = true;
+    worker_ = std::thread([this] { run(); });
+}
+
+void TriggerCapture::stop() {
+    running_ = false;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+TriggerCapture::Stats TriggerCapture::getStats() const {
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    return stats_;
+}
+
+void TriggerCapture::run() {
+    float scannedGravity = 0.0f;
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+        drain(magBuffer_, magTimesBuffer_, streams_[static_cast<int>(SensorType::Mag)]);
+        drain(accelBuffer_, accelTimesBuffer_, streams_[static_cast<int>(SensorType::Accel)]);
+        drain(gyroBuffer_, gyroTimesBuffer_, streams_[static_cast<int>(SensorType::Gyro)]);
+
+        // The accel rules follow each new alignment's gravity magnitude
+        float gravity = filter_.getGravityMagnitude();
+        if (gravity != scannedGravity) {
+            scanner_.setGravity(gravity);
+            scannedGravity = gravity;
+            std::lock_guard<std::mutex> lock(statsMtx_);
+            stats_.gravity = gravity;
+        }
+
+        if (capture_.active) {
+            for (Stream& stream : streams_) collect(stream);
+        }
+        scanStream(SensorType::Accel, streams_[static_cast<int>(SensorType::Accel)]);
+        scanStream(SensorType::Gyro, streams_[static_cast<int>(SensorType::Gyro)]);
+
+        if (capture_.active && captureComplete()) {
+            writeCapture();
+        }
+    }
+
+    // A capture cut short by stop() still keeps what it has
+    if (capture_.active) {
+        writeCapture();
+    }
+}
+
+// Copy the samples appended since the last drain from the data and times buffers. The two are
+// appended one after the other, so the newest sample may be in one and not yet in the other; only
+// write counts present in both are taken, the rest comes with the next drain
+template <std::size_t Capacity>
+void TriggerCapture::drain(const ThreadSafeRingBuffer3D<Capacity>& dataBuffer, const ThreadSafeRingBuffer<Capacity>& timesBuffer,
+                           Stream& stream) {
+    std::size_t dataEnd = stream.since, timesEnd = stream.since;
+    std::size_t dataCount = dataBuffer.copySince(dataEnd, stream.x.data(), stream.y.data(), stream.z.data());
+    std::size_t timesCount = timesBuffer.copySince(timesEnd, stream.t.data());
+    std::size_t dataStart = dataEnd - dataCount, timesStart = timesEnd - timesCount;
+
+    std::size_t start = std::max(dataStart, timesStart);
+    std::size_t end = std::min(dataEnd, timesEnd);
+    stream.count = 0;
+    if (end <= start) return;
+
+    if (start > dataStart) {
+        std::size_t skip = start - dataStart;
+        for (std::vector<float>* column : {&stream.x, &stream.y, &stream.z}) {
+            std::copy(column->begin() + skip, column->begin() + skip + (end - start), column->begin());
+        }
+    }
+    if (start > timesStart) {
+        std::size_t skip = start - timesStart;
+        std::copy(stream.t.begin() + skip, stream.t.begin() + skip + (end - start), stream.t.begin());
+    }
+
+    std::size_t missed = start > stream.since ? start - stream.since : 0;
+    if (missed > 0) {
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.missedSamples += missed;
+    }
+    stream.first = start;
+    stream.count = end - start;
+    stream.since = end;
+    stream.latest = stream.t[stream.count - 1];
+}
+
+void TriggerCapture::scanStream(SensorType sensor, Stream& stream) {
+    if (stream.count == 0) return;
+
+    TriggerScanner::Hit hits[MAX_HITS];
+    auto start = std::chrono::steady_clock::now();
+    std::size_t found = scanner_.scan(sensor, stream.x.data(), stream.y.data(), stream.z.data(), stream.count, hits, MAX_HITS);
+    double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const TriggerScanner::Hit* first = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.scannedSamples += stream.count;
+        stats_.scanNanos += nanos;
+        for (std::size_t h = 0; h < found; h++) {
+            stats_.triggers[hits[h].rule]++;
+            if (first == nullptr || hits[h].index < first->index) first = &hits[h];
+        }
+    }
+    if (first == nullptr) return;
+
+    if (capture_.active) {
+        capture_.laterTriggers += found;
+    } else {
+        const TriggerScanner::Rule& rule = scanner_.rules()[first->rule];
+        std::cout << "[Trigger] " << rule.name << " at t=" << stream.t[first->index] << " s" << std::endl;
+        startCapture(first->rule, stream.t[first->index]);
+        capture_.laterTriggers += found - 1;
+    }
+}
+
+void TriggerCapture::startCapture(int rule, float triggerTime) {
+    capture_.active = true;
+    capture_.rule = rule;
+    capture_.triggerTime = triggerTime;
+    capture_.endTime = triggerTime + triggerPostSeconds;
+    capture_.deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(triggerPostSeconds + 2.0f));
+    capture_.laterTriggers = 0;
+
+    snapshot(magBuffer_, magTimesBuffer_, streams_[static_cast<int>(SensorType::Mag)]);
+    snapshot(accelBuffer_, accelTimesBuffer_, streams_[static_cast<int>(SensorType::Accel)]);
+    snapshot(gyroBuffer_, gyroTimesBuffer_, streams_[static_cast<int>(SensorType::Gyro)]);
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.capturing = true;
+}
+
+// Everything the ring buffers still hold from triggerPreSeconds before the trigger on (they may
+// already hold some of the post-trigger window too)
+template <std::size_t Capacity>
+void TriggerCapture::snapshot(const ThreadSafeRingBuffer3D<Capacity>& dataBuffer, const ThreadSafeRingBuffer<Capacity>& timesBuffer,
+                              Stream& stream) {
+    std::vector<float> x(Capacity), y(Capacity), z(Capacity), t(Capacity);
+    std::size_t dataEnd = 0, timesEnd = 0;
+    std::size_t dataCount = dataBuffer.copyHeld(dataEnd, x.data(), y.data(), z.data());
+    std::size_t timesCount = timesBuffer.copySince(timesEnd, t.data());
+    std::size_t dataStart = dataEnd - dataCount, timesStart = timesEnd - timesCount;
+    std::size_t start = std::max(dataStart, timesStart);
+    std::size_t end = std::min(dataEnd, timesEnd);
+
+    float from = capture_.triggerTime - triggerPreSeconds;
+    stream.captured.clear();
+    for (std::size_t index = start; index < end; index++) {
+        const float time = t[index - timesStart];
+        if (time < from || time > capture_.endTime) continue;
+        std::size_t i = index - dataStart;
+        stream.captured.push_back({time, x[i], y[i], z[i]});
+    }
+    stream.captureNext = end;
+}
+
+void TriggerCapture::collect(Stream& stream) {
+    for (std::size_t i = 0; i < stream.count; i++) {
+        if (stream.first + i < stream.captureNext) continue;
+        if (stream.t[i] > capture_.endTime) break;
+        stream.captured.push_back({stream.t[i], stream.x[i], stream.y[i], stream.z[i]});
+    }
+    stream.captureNext = std::max(stream.captureNext, stream.first + stream.count);
+}
+
+// Every sensor that is still delivering has passed the end of the window
+bool TriggerCapture::captureComplete() const {
+    if (std::chrono::steady_clock::now() >= capture_.deadline) return true;
+    for (const Stream& stream : streams_) {
+        if (stream.count > 0 && stream.latest < capture_.endTime) return false;
+    }
+    return true;
+}
+
+void TriggerCapture::writeCapture() {
+    const TriggerScanner::Rule& rule = scanner_.rules()[capture_.rule];
+
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::string path = (std::filesystem::path(directory_) / (rule.name + "_" + stamp + ".txt")).string();
+
+    std::ofstream file(path, std::ios::trunc);
+    if (file) {
+        // Every float digit: sample times are seconds since start, and the default 6 digits are
+        // 10 ms after 1000 s, coarser than a 1 kHz sample period
+        file.precision(std::numeric_limits<float>::max_digits10);
+        file << "# IMU trigger capture: " << rule.name << " at t=" << capture_.triggerTime << " s, "
+             << triggerPreSeconds << " s before and " << triggerPostSeconds << " s after";
+        if (capture_.laterTriggers > 0) file << ", " << capture_.laterTriggers << " more trigger(s) inside";
+        file << "\n";
+
+        // Merge the three sensors into one time-ordered stream
+        const char letters[3] = {'M', 'A', 'G'};
+        std::size_t next[3] = {0, 0, 0};
+        while (true) {
+            int pick = -1;
+            for (int s = 0; s < 3; s++) {
+                if (next[s] >= streams_[s].captured.size()) continue;
+                if (pick < 0 || streams_[s].captured[next[s]].t < streams_[pick].captured[next[pick]].t) pick = s;
+            }
+            if (pick < 0) break;
+            const Sample& sample = streams_[pick].captured[next[pick]++];
+            file << letters[pick] << " " << sample.t << " " << sample.x << " " << sample.y << " " << sample.z << "\n";
+        }
+    }
+    bool ok = static_cast<bool>(file);
+    file.close();
+
+    std::size_t samples = 0;
+    for (Stream& stream : streams_) {
+        samples += stream.captured.size();
+        stream.captured.clear();
+    }
+    capture_.active = false;
+
+    if (ok) {
+        std::cout << "[Trigger] Wrote " << samples << " samples to " << path << std::endl;
+    } else {
+        std::cerr << "[Trigger] Could not write " << path << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.capturing = false;
+    if (ok) {
+        stats_.captures++;
+        stats_.lastCapture = path;
+    }
+}
@@ -0,0 +1,194 @@
+#include "communication/ClockSync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+ClockSync::Clock::time_point ClockSync::epoch() {
+    static const Clock::time_point origin = Clock::now();
+    return origin;
+}
+
+double ClockSync::hostSeconds(Clock::time_point time) {
+    return std::chrono::duration<double>(time - epoch()).count();
+}
+
+void ClockSync::reset() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    restart();
+}
+
+void ClockSync::restart() {
+    uint64_t resets = stats_.resets;
+    started_ = false;
+    deviceSeconds_ = 0.0;
+    bins_.clear();
+    currentIndex_ = -1;
+    fitOffset_ = appliedOffset_ = 0.0;
+    fitRate_ = appliedRate_ = 1.0;
+    windowStart_ = transportSum_ = releaseSum_ = releaseMax_ = 0.0;
+    transportCount_ = releaseCount_ = 0;
+    stats_ = Stats();
+    stats_.resets = resets;
+}
+
+double ClockSync::observe(uint32_t deviceMicros, Clock::time_point arrival) {
+    double now = hostSeconds(arrival);
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (started_) {
+        // Wrapping difference. A small step back is a message overtaken in transit (UDP): map it
+        // with the current estimate but leave the estimate alone. A large one is a device restart
+        int32_t delta = static_cast<int32_t>(deviceMicros - lastMicros_);
+        if (delta < 0 && delta > -clockSyncReorderMicros) {
+            stats_.messages++;
+            return deviceSeconds_ + delta * 1e-6;
+        }
+        if (delta < 0) {
+            std::cout << "[ClockSync] Device clock went back " << -delta * 1e-6 << " s, restarting estimate" << std::endl;
+            stats_.resets++;
+            restart();
+        } else {
+            deviceSeconds_ += delta * 1e-6;
+        }
+    }
+    bool first = !started_;
+    if (first) {
+        started_ = true;
+        deviceSeconds_ = 0.0;
+    }
+    lastMicros_ = deviceMicros;
+
+    // Minimum-delay filter: keep the smallest host - device per bin of device time
+    double minimum = now - deviceSeconds_;
+    int64_t index = static_cast<int64_t>(std::floor(deviceSeconds_ / clockSyncBinSeconds));
+    if (index != currentIndex_) {
+        if (currentIndex_ >= 0) {
+            bins_.push_back(current_);
+            if (bins_.size() > static_cast<std::size_t>(clockSyncBins)) bins_.erase(bins_.begin());
+        }
+        current_ = {deviceSeconds_, minimum};
+        currentIndex_ = index;
+    } else if (minimum < current_.minimum) {
+        current_ = {deviceSeconds_, minimum};
+    }
+
+    fit();
+    if (first) {
+        appliedOffset_ = fitOffset_;
+        appliedRate_ = fitRate_;
+    } else {
+        steer(deviceSeconds_);
+    }
+
+    stats_.messages++;
+    transportSum_ += now - mapped(deviceSeconds_);
+    transportCount_++;
+    publishLatency(now);
+    return deviceSeconds_;
+}
+
+// Windowed least squares through the bin minima (the open bin included). Until enough bins
+// span the window the rate is taken as nominal and only the offset is estimated
+void ClockSync::fit() {
+    std::size_t count = bins_.size() + 1;
+    auto point = [this](std::size_t i) -> const Bin& { return i < bins_.size() ? bins_[i] : current_; };
+
+    double slope = 0.0;
+    double intercept;
+    stats_.locked = bins_.size() >= static_cast<std::size_t>(clockSyncMinBins);
+    if (stats_.locked) {
+        double meanD = 0.0, meanM = 0.0;
+        for (std::size_t i = 0; i < count; i++) {
+            meanD += point(i).device;
+            meanM += point(i).minimum;
+        }
+        meanD /= count;
+        meanM /= count;
+
+        double sdd = 0.0, sdm = 0.0;
+        for (std::size_t i = 0; i < count; i++) {
+            double dd = point(i).device - meanD;
+            sdd += dd * dd;
+            sdm += dd * (point(i).minimum - meanM);
+        }
+        slope = sdd > 0.0 ? sdm / sdd : 0.0;
+        intercept = meanM - slope * meanD;
+    } else {
+        intercept = point(0).minimum;
+        for (std::size_t i = 1; i < count; i++) intercept = std::min(intercept, point(i).minimum);
+    }
+
+    double bound = 0.0;
+    for (std::size_t i = 0; i < count; i++) {
+        bound = std::max(bound, std::abs(point(i).minimum - (intercept + slope * point(i).device)));
+    }
+
+    fitOffset_ = intercept;
+    fitRate_ = 1.0 + slope;
+    stats_.errorBound = bound;
+}
+
+// Close the gap to the fit with a rate correction proportional to it (time constant
+// clockSyncSteerSeconds, capped at clockSyncMaxSlew), keeping the mapping continuous at 'deviceSeconds'.
+// A gap too large to steer away in reasonable time (e.g. the first estimate came from a backlog
+// delivered in one burst) is stepped; samples mapped before a backward step then arrive late
+void ClockSync::steer(double deviceSeconds) {
+    double current = mapped(deviceSeconds);
+    double gap = fitOffset_ + fitRate_ * deviceSeconds - current;
+    if (std::abs(gap) > clockSyncStepThreshold) {
+        std::cout << "[ClockSync] Stepped mapping by " << gap * 1000.0 << " ms" << std::endl;
+        appliedOffset_ = fitOffset_;
+        appliedRate_ = fitRate_;
+        stats_.steps++;
+        return;
+    }
+    double correction = std::clamp(gap / clockSyncSteerSeconds, -static_cast<double>(clockSyncMaxSlew),
+                                   static_cast<double>(clockSyncMaxSlew));
+    appliedRate_ = fitRate_ + correction;
+    appliedOffset_ = current - appliedRate_ * deviceSeconds;
+}
+
+double ClockSync::toHostTime(double deviceSeconds) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return mapped(deviceSeconds);
+}
+
+void ClockSync::noteRelease(double timestamp, Clock::time_point now) {
+    double seconds = hostSeconds(now);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!started_) return;
+
+    double latency = seconds - timestamp;
+    releaseSum_ += latency;
+    releaseMax_ = std::max(releaseMax_, latency);
+    releaseCount_++;
+    publishLatency(seconds);
+}
+
+void ClockSync::publishLatency(double now) {
+    if (windowStart_ == 0.0) windowStart_ = now;
+    if (now - windowStart_ < 1.0) return;
+
+    stats_.transportLatency = transportCount_ > 0 ? static_cast<float>(transportSum_ / transportCount_) : 0.0f;
+    stats_.endToEndLatency = releaseCount_ > 0 ? static_cast<float>(releaseSum_ / releaseCount_) : 0.0f;
+    stats_.endToEndMax = static_cast<float>(releaseMax_);
+    transportSum_ = releaseSum_ = releaseMax_ = 0.0;
+    transportCount_ = releaseCount_ = 0;
+    windowStart_ = now;
+}
+
+bool ClockSync::active() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return started_;
+}
+
+ClockSync::Stats ClockSync::getStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats stats = stats_;
+    stats.active = started_;
+    stats.offset = fitOffset_;
+    stats.skewPpm = (fitRate_ - 1.0) * 1e6;
+    stats.steering = fitOffset_ + fitRate_ * deviceSeconds_ - mapped(deviceSeconds_);
+    return stats;
+}
@@ -0,0 +1,61 @@
+#include "communication/IngestStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+void IngestStats::countSample(SensorType type, Clock::time_point arrival, Clock::time_point fused) {
+    samples_[static_cast<int>(type)].fetch_add(1, std::memory_order_relaxed);
+
+    double micros = std::chrono::duration<double, std::micro>(fused - arrival).count();
+    int bucket = 0;
+    if (micros > 1.0) {
+        bucket = static_cast<int>(std::ceil(4.0 * std::log2(micros)));
+        if (bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+    }
+    latency_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void IngestStats::countReconnect(double gapSeconds) {
+    uint64_t micros = static_cast<uint64_t>(std::max(gapSeconds, 0.0) * 1e6);
+    reconnects_.fetch_add(1, std::memory_order_relaxed);
+    lastGapMicros_.store(micros, std::memory_order_relaxed);
+    uint64_t longest = longestGapMicros_.load(std::memory_order_relaxed);
+    while (micros > longest && !longestGapMicros_.compare_exchange_weak(longest, micros, std::memory_order_relaxed)) {}
+}
+
+IngestStats::Snapshot IngestStats::snapshot() const {
+    Snapshot snapshot;
+    snapshot.messages = messages_.load(std::memory_order_relaxed);
+    snapshot.resyncs = resyncs_.load(std::memory_order_relaxed);
+    snapshot.rejected = rejected_.load(std::memory_order_relaxed);
+    snapshot.lateDrops = lateDrops_.load(std::memory_order_relaxed);
+    snapshot.reconnects = reconnects_.load(std::memory_order_relaxed);
+    snapshot.lastGapMicros = lastGapMicros_.load(std::memory_order_relaxed);
+    snapshot.longestGapMicros = longestGapMicros_.load(std::memory_order_relaxed);
+    for (int s = 0; s < 3; s++) {
+        snapshot.samples[s] = samples_[s].load(std::memory_order_relaxed);
+    }
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        snapshot.latency[b] = latency_[b].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+double IngestStats::percentile(const uint64_t (&counts)[LATENCY_BUCKETS], double fraction) {
+    uint64_t total = 0;
+    for (uint64_t count : counts) total += count;
+    if (total == 0) return 0.0;
+
+    // Smallest bucket covering the requested share of the samples
+    double target = fraction * static_cast<double>(total);
+    uint64_t cumulative = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        cumulative += counts[b];
+        if (cumulative >= target && cumulative > 0) return bucketUpperSeconds(b);
+    }
+    return bucketUpperSeconds(LATENCY_BUCKETS - 1);
+}
+
+double IngestStats::bucketUpperSeconds(int bucket) {
+    return std::exp2(bucket / 4.0) * 1e-6;
+}
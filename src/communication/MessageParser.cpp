@@ -0,0 +1,56 @@
+#include "communication/MessageParser.h"
+
+ParseError parseSensorMessage(const uint8_t* data, std::size_t size, SensorMessage& message) {
+    // Verify minimum message length (sync + flags)
+    if (size < 2) return ParseError::TooShort;
+    if (data[0] != MessageFormat::SYNC) return ParseError::BadSync;
+
+    uint8_t flags = data[1];
+    std::size_t offset = 2;
+    message = SensorMessage();
+
+    message.hasSequence = (flags & MessageFormat::SEQUENCE) != 0;
+    if (message.hasSequence) {
+        if (size < offset + 2) return ParseError::TooShort;
+        message.sequence = static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+        offset += 2;
+    }
+
+    message.hasTimestamp = (flags & MessageFormat::TIMESTAMP) != 0;
+    if (message.hasTimestamp) {
+        if (size < offset + 4) return ParseError::TooShort;
+        std::memcpy(&message.deviceMicros, data + offset, sizeof(message.deviceMicros));
+        offset += 4;
+    }
+
+    // Counts in SensorType order (mag, accel, gyro), matching the order of the data
+    if (flags & MessageFormat::BATCH) {
+        if (size < offset + 3) return ParseError::TooShort;
+        for (int s = 0; s < 3; s++) {
+            message.counts[s] = data[offset + s];
+            if (message.counts[s] > MessageFormat::MAX_BATCH_SAMPLES) return ParseError::TooManySamples;
+        }
+        offset += 3;
+    } else {
+        message.counts[static_cast<int>(SensorType::Mag)] = (flags & MessageFormat::MAG) ? 1 : 0;
+        message.counts[static_cast<int>(SensorType::Accel)] = (flags & MessageFormat::ACCEL) ? 1 : 0;
+        message.counts[static_cast<int>(SensorType::Gyro)] = (flags & MessageFormat::GYRO) ? 1 : 0;
+    }
+
+    std::size_t samples = message.counts[0] + message.counts[1] + message.counts[2];
+    if (size != offset + samples * 3 * sizeof(float)) return ParseError::SizeMismatch;
+
+    message.values = data + offset;
+    return ParseError::None;
+}
+
+const char* describeParseError(ParseError error) {
+    switch (error) {
+        case ParseError::None: return "ok";
+        case ParseError::TooShort: return "message too short";
+        case ParseError::BadSync: return "invalid sync byte";
+        case ParseError::TooManySamples: return "too many samples in batch";
+        case ParseError::SizeMismatch: return "size does not match header";
+    }
+    return "unknown error";
+}
@@ -0,0 +1,105 @@
+#include "communication/SensorPipeline.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
+#include "ComplementaryFilter.h"
+#include "Prefilter.h"
+#include "storage/SensorRecorder.h"
+
+SensorPipeline::SensorPipeline(boost::asio::io_context& ioc,
+        GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
+        GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
+        ComplementaryFilter& complementaryFilter, Prefilter& prefilter, SensorRecorder& recorder,
+        ClockSync& clockSync, IngestStats& ingestStats)
+    :
+    reorderBuffer_(reorderMaxLatency),
+    flushTimer_(ioc),
+    gyroDataBuffer_(gyroDataBuffer), accelDataBuffer_(accelDataBuffer), magDataBuffer_(magDataBuffer),
+    gyroTimesBuffer_(gyroTimesBuffer), accelTimesBuffer_(accelTimesBuffer), magTimesBuffer_(magTimesBuffer),
+    complementaryFilter_(complementaryFilter), prefilter_(prefilter), recorder_(recorder), clockSync_(clockSync),
+    ingestStats_(ingestStats) {}
+
+void SensorPipeline::push(const SensorSample& sample, ReorderBuffer::Clock::time_point arrival) {
+    if (!reorderBuffer_.push(sample, arrival)) ingestStats_.countLateDrop();
+}
+
+void SensorPipeline::flush() {
+    reorderBuffer_.flush([this](const SensorSample& sample, ReorderBuffer::Clock::time_point arrival) {
+        dispatch(sample, arrival);
+    });
+    fuse();
+}
+
+void SensorPipeline::restart() {
+    flush();
+    reorderBuffer_.restart();
+}
+
+void SensorPipeline::release() {
+    reorderBuffer_.release(ReorderBuffer::Clock::now(), [this](const SensorSample& sample, ReorderBuffer::Clock::time_point arrival) {
+        dispatch(sample, arrival);
+    });
+    fuse();
+    scheduleFlush();
+}
+
+// Samples still held when the stream pauses are released by a timer, so holding latency stays bounded
+void SensorPipeline::scheduleFlush() {
+    if (reorderBuffer_.empty() || flushPending_) return;
+
+    flushPending_ = true;
+    flushTimer_.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(reorderBuffer_.maxLatency())));
+    flushTimer_.async_wait([this](const boost::system::error_code& ec) {
+        flushPending_ = false;
+        if (!ec) release();
+    });
+}
+
+void SensorPipeline::dispatch(const SensorSample& rawSample, ReorderBuffer::Clock::time_point arrival) {
+    clockSync_.noteRelease(rawSample.timestamp, ReorderBuffer::Clock::now());
+    recorder_.record(rawSample);
+
+    // Condition in time order so the biquad state sees a continuous signal
+    SensorSample sample = rawSample;
+    prefilter_.apply(sample);
+
+    Block& block = blocks_[static_cast<int>(sample.type)];
+    block.x[block.count] = sample.x;
+    block.y[block.count] = sample.y;
+    block.z[block.count] = sample.z;
+    block.timestamp[block.count] = static_cast<float>(sample.timestamp);   // In time order from here on
+    block.arrival[block.count] = arrival;
+    block.count++;
+    if (block.count == MAX_BLOCK) fuse();
+}
+
+// Append the collected blocks to the ring buffers and fuse them in one filter update
+void SensorPipeline::fuse() {
+    Block& mag = blocks_[static_cast<int>(SensorType::Mag)];
+    Block& accel = blocks_[static_cast<int>(SensorType::Accel)];
+    Block& gyro = blocks_[static_cast<int>(SensorType::Gyro)];
+    if (mag.count == 0 && accel.count == 0 && gyro.count == 0) return;
+
+    if (mag.count > 0) {
+        magDataBuffer_.append(mag.x, mag.y, mag.z, mag.count);
+        magTimesBuffer_.append(mag.timestamp, mag.count);
+    }
+    if (accel.count > 0) {
+        accelDataBuffer_.append(accel.x, accel.y, accel.z, accel.count);
+        accelTimesBuffer_.append(accel.timestamp, accel.count);
+    }
+    if (gyro.count > 0) {
+        gyroDataBuffer_.append(gyro.x, gyro.y, gyro.z, gyro.count);
+        gyroTimesBuffer_.append(gyro.timestamp, gyro.count);
+    }
+    complementaryFilter_.updateBatch(gyro.view(), accel.view(), mag.view());
+
+    ReorderBuffer::Clock::time_point fused = ReorderBuffer::Clock::now();
+    for (int sensor = 0; sensor < 3; sensor++) {
+        Block& block = blocks_[sensor];
+        for (std::size_t i = 0; i < block.count; i++) {
+            ingestStats_.countSample(static_cast<SensorType>(sensor), block.arrival[i], fused);
+        }
+        block.count = 0;
+    }
+}
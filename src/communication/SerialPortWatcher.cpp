@@ -0,0 +1,168 @@
+#include "communication/SerialPortWatcher.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool isUsbSerialName(const std::string& name) {
+#if defined(__linux__)
+    return name.rfind("ttyUSB", 0) == 0 || name.rfind("ttyACM", 0) == 0;
+#elif defined(__APPLE__)
+    return name.rfind("tty.usbserial", 0) == 0 || name.rfind("tty.usbmodem", 0) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+// A configured path that is not one of the listed USB ports, checked for existence instead
+bool isOtherPort(const std::string& path) {
+    return !path.empty() && !isUsbSerialName(std::filesystem::path(path).filename().string());
+}
+
+} // namespace
+
+SerialPortWatcher::SerialPortWatcher(boost::asio::io_context& ioc)
+    :
+#if defined(__linux__)
+    inotify_(ioc),
+#endif
+    pollTimer_(ioc)
+{
+#if defined(__linux__)
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, "/dev", IN_CREATE | IN_ATTRIB | IN_MOVED_TO) >= 0) {
+        inotify_.assign(fd);
+    } else {
+        std::cerr << "[Serial] Cannot watch /dev, polling for ports instead" << std::endl;
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+SerialPortWatcher::~SerialPortWatcher() {
+    cancel();
+}
+
+std::vector<SerialPortWatcher::Port> SerialPortWatcher::list() {
+    std::vector<Port> ports;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev", ec)) {
+        std::string name = entry.path().filename().string();
+        if (!isUsbSerialName(name)) continue;
+        ports.push_back({entry.path().string(), serialNumber(entry.path().string())});
+    }
+    std::sort(ports.begin(), ports.end(), [](const Port& a, const Port& b) { return a.path < b.path; });
+    return ports;
+}
+
+// The tty's sysfs device is a USB interface (or a port below one); the USB device above it carries
+// idVendor and, when the device has one, its serial number
+std::string SerialPortWatcher::serialNumber(const std::string& path) {
+#if defined(__linux__)
+    std::error_code ec;
+    std::filesystem::path resolved = std::filesystem::canonical(path, ec);   // Follows /dev/serial/by-id links
+    std::string name = (ec ? std::filesystem::path(path) : resolved).filename().string();
+    std::filesystem::path device = std::filesystem::canonical("/sys/class/tty/" + name + "/device", ec);
+    if (ec) return "";
+
+    for (std::filesystem::path dir = device; dir.has_relative_path() && dir != "/sys"; dir = dir.parent_path()) {
+        if (!std::filesystem::exists(dir / "idVendor", ec)) continue;
+        std::ifstream file(dir / "serial");
+        std::string serial;
+        std::getline(file, serial);
+        return serial;
+    }
+#else
+    (void)path;
+#endif
+    return "";
+}
+
+void SerialPortWatcher::waitFor(const std::string& serial, const std::string& fallback, std::function<void(const Port&)> found) {
+    serial_ = serial;
+    fallback_ = fallback;
+    found_ = std::move(found);
+
+    // Checked from the io thread, so 'found' never runs inside this call
+    boost::asio::post(pollTimer_.get_executor(), [this] {
+        if (!found_ || check()) return;
+#if defined(__linux__)
+        if (inotify_.is_open()) {
+            readEvents();
+            if (!isOtherPort(fallback_)) return;
+        }
+#endif
+        poll();
+    });
+}
+
+void SerialPortWatcher::cancel() {
+    found_ = nullptr;
+    pollTimer_.cancel();
+#if defined(__linux__)
+    boost::system::error_code ec;
+    inotify_.cancel(ec);
+#endif
+}
+
+// Report the first matching port, a configured fallback before the listed ones, and stop waiting
+bool SerialPortWatcher::check() {
+    std::vector<Port> ports;
+#if defined(__linux__) || defined(__APPLE__)
+    std::error_code ec;
+    if (isOtherPort(fallback_) && std::filesystem::exists(fallback_, ec)) ports.push_back({fallback_, serialNumber(fallback_)});
+#else
+    if (!fallback_.empty()) ports.push_back({fallback_, ""});
+#endif
+    std::vector<Port> listed = list();
+    ports.insert(ports.end(), listed.begin(), listed.end());
+    for (const Port& port : ports) {
+        if (!serial_.empty() && port.serial != serial_) continue;
+        std::function<void(const Port&)> found = std::move(found_);
+        found_ = nullptr;
+        pollTimer_.cancel();
+        found(port);
+        return true;
+    }
+    return false;
+}
+
+void SerialPortWatcher::poll() {
+    pollTimer_.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(serialRetrySeconds)));
+    pollTimer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec || !found_ || check()) return;
+        poll();
+    });
+}
+
+#if defined(__linux__)
+void SerialPortWatcher::readEvents() {
+    if (reading_) return;
+    reading_ = true;
+    inotify_.async_read_some(boost::asio::buffer(events_), [this](const boost::system::error_code& ec, std::size_t bytes) {
+        reading_ = false;
+        if (ec || !found_) return;
+
+        // Only look at the ports again when a tty node was created or became accessible
+        bool ttyEvent = false;
+        for (std::size_t offset = 0; offset + sizeof(inotify_event) <= bytes;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(events_.data() + offset);
+            if (event->len > 0 && isUsbSerialName(event->name)) ttyEvent = true;
+            offset += sizeof(inotify_event) + event->len;
+        }
+        if (ttyEvent && check()) return;
+        readEvents();
+    });
+}
+#endif
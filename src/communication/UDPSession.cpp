@@ -0,0 +1,262 @@
+#include "communication/UDPSession.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+// A sequence jump this large is a device restart (or a damaged sequence field) rather than loss
+// or reordering; the count resynchronizes instead of charging it as loss
+constexpr int SEQUENCE_RESYNC = 64;
+}
+
+UDPSession::UDPSession(boost::asio::io_context& ioc, unsigned short port,
+        GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
+        GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
+        ComplementaryFilter& complementaryFilter, Prefilter& prefilter, SensorRecorder& recorder,
+        ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+        const SensorRates& rates)
+    :
+    socket_(ioc, Endpoint(boost::asio::ip::udp::v4(), port)),
+    pipeline_(ioc, gyroDataBuffer, accelDataBuffer, magDataBuffer,
+              gyroTimesBuffer, accelTimesBuffer, magTimesBuffer, complementaryFilter, prefilter, recorder, clockSync,
+              ingestStats),
+    complementaryFilter_(complementaryFilter),
+    clockSync_(clockSync),
+    ingestStats_(ingestStats),
+    checkpointer_(checkpointer),
+    rates_(rates),
+    primaryTimestamper_(clockSync, rates),
+    buffers_(udpBatchDatagrams * udpMaxDatagram),
+    lastReport_(Clock::now())
+{
+    // Room for bursts from many devices while the io thread is busy
+    boost::system::error_code ec;
+    socket_.set_option(boost::asio::socket_base::receive_buffer_size(udpReceiveBufferBytes), ec);
+    socket_.non_blocking(true, ec);
+
+#if defined(__linux__)
+    for (std::size_t i = 0; i < udpBatchDatagrams; i++) {
+        iovecs_[i].iov_base = buffers_.data() + i * udpMaxDatagram;
+        iovecs_[i].iov_len = udpMaxDatagram;
+        std::memset(&headers_[i], 0, sizeof(headers_[i]));
+        headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+        headers_[i].msg_hdr.msg_name = &addresses_[i];
+    }
+#endif
+
+    std::cout << "[UDP] Listening on port " << port << std::endl;
+}
+
+void UDPSession::run() {
+    receive();
+}
+
+// Wait for readability, then take everything queued on the socket in as few calls as possible
+void UDPSession::receive() {
+    auto self(shared_from_this());
+    socket_.async_wait(boost::asio::ip::udp::socket::wait_read,
+        [this, self](const boost::system::error_code& ec) {
+            if (ec) {
+                std::cerr << "[UDP] Receive error: " << ec.message() << std::endl;
+                return;
+            }
+            drain();
+            receive();
+        });
+}
+
+void UDPSession::drain() {
+#if defined(__linux__)
+    int fd = socket_.native_handle();
+    while (true) {
+        for (std::size_t i = 0; i < udpBatchDatagrams; i++) {
+            headers_[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        }
+        int received = recvmmsg(fd, headers_.data(), udpBatchDatagrams, MSG_DONTWAIT, nullptr);
+        if (received <= 0) {
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "[UDP] recvmmsg failed: " << std::strerror(errno) << std::endl;
+            }
+            break;
+        }
+        syscalls_++;
+
+        Clock::time_point arrival = Clock::now();
+        for (int i = 0; i < received; i++) {
+            const msghdr& header = headers_[i].msg_hdr;
+            if (header.msg_flags & MSG_TRUNC) {
+                truncated_++;
+                continue;
+            }
+            Endpoint source;
+            std::memcpy(source.data(), &addresses_[i], header.msg_namelen);
+            source.resize(header.msg_namelen);
+            handleDatagram(buffers_.data() + i * udpMaxDatagram, headers_[i].msg_len, source, arrival);
+        }
+        datagrams_ += received;
+        if (received < static_cast<int>(udpBatchDatagrams)) break;
+    }
+#else
+    // One datagram per call where recvmmsg is not available
+    while (true) {
+        Endpoint source;
+        boost::system::error_code ec;
+        std::size_t size = socket_.receive_from(boost::asio::buffer(buffers_.data(), udpMaxDatagram), source, 0, ec);
+        if (ec) {
+            if (ec != boost::asio::error::would_block && ec != boost::asio::error::try_again) {
+                if (ec == boost::asio::error::message_size) {
+                    truncated_++;
+                    continue;
+                }
+                std::cerr << "[UDP] Receive failed: " << ec.message() << std::endl;
+            }
+            break;
+        }
+        syscalls_++;
+        datagrams_++;
+        handleDatagram(buffers_.data(), size, source, Clock::now());
+    }
+#endif
+
+    pipeline_.release();
+    report(Clock::now());
+}
+
+void UDPSession::handleDatagram(const uint8_t* data, std::size_t size, const Endpoint& source, Clock::time_point arrival) {
+    Device& device = deviceFor(source, arrival);
+    ingestStats_.countMessage();
+
+    SensorMessage message;
+    if (parseSensorMessage(data, size, message) != ParseError::None) {
+        device.malformed++;
+        ingestStats_.countRejected();
+        return;
+    }
+    // Datagrams overtaken by later ones are dropped: the filters and clock estimates need device order
+    if (message.hasSequence && !trackSequence(device, message.sequence)) {
+        ingestStats_.countRejected();
+        return;
+    }
+    device.messages++;
+
+    if (device.primary) {
+        primaryTimestamper_.emit(message, arrival, [this, arrival](const SensorSample& sample) {
+            pipeline_.push(sample, arrival);
+        });
+    } else {
+        device.timestamper.emit(message, arrival, [this, &device](const SensorSample& sample) { feedSecondary(device, sample); });
+    }
+}
+
+UDPSession::Device& UDPSession::deviceFor(const Endpoint& source, Clock::time_point now) {
+    auto it = devices_.find(source);
+    if (it == devices_.end()) {
+        it = devices_.emplace(source, std::make_unique<Device>(nextDeviceId_++, source, rates_)).first;
+        std::cout << "[UDP] New device " << it->second->id << " at " << source << std::endl;
+    }
+    Device& device = *it->second;
+    device.lastHeard = now;
+
+    auto primaryTimeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(udpPrimaryTimeout));
+    if (!primary_ || (primary_ != &device && now - primary_->lastHeard > primaryTimeout)) {
+        promote(device);
+    }
+    return device;
+}
+
+// The app follows one device at a time; a new one starts from a fresh alignment and clock estimate,
+// and as a new stream: the old primary's held samples are released, and the new one's timestamps
+// (mapped or rate-based) are not compared with the old ones
+void UDPSession::promote(Device& device) {
+    if (primary_) primary_->primary = false;
+    primary_ = &device;
+    device.primary = true;
+    device.filter.reset();
+    pipeline_.restart();
+    primaryTimestamper_.restart();
+    clockSync_.reset();
+    std::ostringstream deviceId;
+    deviceId << "udp:" << device.source;
+    checkpointer_.attach(deviceId.str());
+    complementaryFilter_.startAlignment();
+    std::cout << "[UDP] Device " << device.id << " (" << device.source << ") is now primary" << std::endl;
+}
+
+bool UDPSession::trackSequence(Device& device, uint16_t sequence) {
+    int diff = static_cast<int16_t>(static_cast<uint16_t>(sequence - device.expectedSequence));
+    if (!device.sequenced || diff >= SEQUENCE_RESYNC || diff <= -SEQUENCE_RESYNC) {
+        if (device.sequenced) ingestStats_.countResync();
+        device.sequenced = true;
+        device.expectedSequence = static_cast<uint16_t>(sequence + 1);
+        device.seen = 1;
+        return true;
+    }
+    if (diff >= 0) {
+        device.lost += diff;
+        device.expectedSequence = static_cast<uint16_t>(sequence + 1);
+        device.seen = (diff + 1 < 64 ? device.seen << (diff + 1) : 0) | 1;
+        return true;
+    }
+
+    // Within the window (SEQUENCE_RESYNC <= 64): either a copy of one already handled, or one
+    // counted as lost when the gap appeared that arrived after all, just out of order
+    uint64_t bit = uint64_t(1) << (-diff - 1);
+    if (device.seen & bit) {
+        device.duplicates++;
+        return false;
+    }
+    device.seen |= bit;
+    device.reordered++;
+    if (device.lost > 0) device.lost--;
+    return false;
+}
+
+void UDPSession::feedSecondary(Device& device, const SensorSample& sample) {
+    if (!device.filter) {
+        device.filter = std::make_unique<ComplementaryFilter>(device.attitude, device.accelVector, rates_);
+    }
+    switch (sample.type) {
+        case SensorType::Mag:
+            device.filter->updateWithMag(sample.x, sample.y, sample.z);
+            break;
+        case SensorType::Accel:
+            device.filter->updateWithAccel(sample.x, sample.y, sample.z);
+            break;
+        case SensorType::Gyro:
+            device.filter->updateWithGyro(sample.x, sample.y, sample.z, static_cast<float>(sample.timestamp));
+            break;
+    }
+}
+
+// Periodic per-device loss/reordering summary; devices silent for udpDeviceExpiry are forgotten
+void UDPSession::report(Clock::time_point now) {
+    if (std::chrono::duration<float>(now - lastReport_).count() < udpReportInterval) return;
+    lastReport_ = now;
+
+    std::cout << "[UDP] " << datagrams_ << " datagrams in " << syscalls_ << " receive calls ("
+              << (syscalls_ > 0 ? static_cast<double>(datagrams_) / syscalls_ : 0.0) << " per call), "
+              << truncated_ << " truncated" << std::endl;
+
+    for (auto it = devices_.begin(); it != devices_.end();) {
+        Device& device = *it->second;
+        if (std::chrono::duration<float>(now - device.lastHeard).count() > udpDeviceExpiry) {
+            std::cout << "[UDP] Device " << device.id << " (" << device.source << ") timed out" << std::endl;
+            if (primary_ == &device) primary_ = nullptr;
+            it = devices_.erase(it);
+            continue;
+        }
+
+        std::cout << "[UDP] Device " << device.id << (device.primary ? " (primary)" : "") << ": "
+                  << device.messages << " messages, " << device.lost << " lost, " << device.reordered
+                  << " reordered, " << device.duplicates << " duplicates, " << device.malformed << " malformed";
+        if (!device.primary && device.filter) {
+            const QuaternionF& q = device.attitude;
+            std::cout << ", attitude " << q.w << " " << q.x << " " << q.y << " " << q.z;
+        }
+        std::cout << std::endl;
+        ++it;
+    }
+}
@@ -1,45 +1,101 @@
 #include "communication/USBSession.h"
 #include "ComplementaryFilter.h"
+#include "communication/IngestStats.h"
+#include "storage/FilterCheckpoint.h"
 #include <iostream>
+#include <cmath>
 #include <cstring>
 #include <vector>
 #include <algorithm>
 
+namespace {
+
+// Bytes of one sensor's samples in a compact batch
+std::size_t compactBytes(uint8_t samples, bool delta) {
+    if (samples == 0) return 0;
+    return delta ? 3 * sizeof(int16_t) + (samples - 1) * 3 * sizeof(int8_t) : samples * 3 * sizeof(int16_t);
+}
+
+} // namespace
+
 USBSession::USBSession(boost::asio::io_context& ioc, const std::string& portName, 
         GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
         GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
-        ComplementaryFilter& complementaryFilter)
+        ComplementaryFilter& complementaryFilter, Prefilter& prefilter, SensorRecorder& recorder,
+        ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+        const SensorRates& rates)
     : 
     serial_port_(ioc),
-    gyroDataBuffer_(gyroDataBuffer),
-    accelDataBuffer_(accelDataBuffer),
-    magDataBuffer_(magDataBuffer),
-    gyroTimesBuffer_(gyroTimesBuffer),
-    accelTimesBuffer_(accelTimesBuffer),
-    magTimesBuffer_(magTimesBuffer),
-    complementaryFilter_(complementaryFilter),
     bytes_needed_(2), // Start by reading 2-byte header
-    reading_header_(true)
+    reading_header_(true),
+    pipeline_(ioc, gyroDataBuffer, accelDataBuffer, magDataBuffer,
+              gyroTimesBuffer, accelTimesBuffer, magTimesBuffer, complementaryFilter, prefilter, recorder, clockSync,
+              ingestStats),
+    timestamper_(clockSync, rates),
+    ingestStats_(ingestStats),
+    checkpointer_(checkpointer),
+    device_serial_(serialDeviceSerial),
+    watcher_(ioc),
+    retry_timer_(ioc)
 {
+    // Initialize state
+    read_state_ = ReadState::SYNC;
+    port_name_ = portName;
+    openPort(portName);
+}
+
+bool USBSession::openPort(const std::string& portName) {
     boost::system::error_code ec;
     serial_port_.open(portName, ec);
+    if (!ec) {
+        // Set standard options
+        serial_port_.set_option(boost::asio::serial_port_base::baud_rate(serialBaudRate), ec);
+        if (!ec) serial_port_.set_option(boost::asio::serial_port_base::character_size(8), ec);
+        if (!ec) serial_port_.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one), ec);
+        if (!ec) serial_port_.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none), ec);
+        if (!ec) serial_port_.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none), ec);
+        if (ec) {
+            boost::system::error_code closeError;
+            serial_port_.close(closeError);
+        }
+    }
     if (ec) {
-        std::cerr << "[USB] Failed to open port: " << ec.message() << std::endl;
-        return;
+        std::string error = portName + ": " + ec.message();
+        if (error != last_open_error_) {
+            std::cerr << "[USB] Failed to open port " << error << std::endl;
+            last_open_error_ = error;
+        }
+        return false;
     }
-    
-    // Set standard options
-    serial_port_.set_option(boost::asio::serial_port_base::baud_rate(115200));
-    serial_port_.set_option(boost::asio::serial_port_base::character_size(8));
-    serial_port_.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
-    serial_port_.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
-    serial_port_.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none));
-    
-    // Initialize state and binary buffer
+    last_open_error_.clear();
+
+    port_name_ = portName;
+    std::string serial = SerialPortWatcher::serialNumber(portName);
+    if (device_serial_.empty()) device_serial_ = serial;
+
+    // A new connection starts a new stream
     read_state_ = ReadState::SYNC;
-    binary_buffer_.resize(200);
-    
-    std::cout << "[USB] Serial port opened at 115200 baud: " << portName << std::endl;
+    receive_end_ = 0;
+    have_scales_ = false;
+    awaiting_scales_ = false;
+    warned_no_scales_ = false;
+
+    std::cout << "[USB] Serial port opened at " << serialBaudRate << " baud: " << portName;
+    if (!serial.empty()) std::cout << " (serial " << serial << ")";
+    std::cout << std::endl;
+
+    // The device may be a different one, or have restarted: ask again and wait for its scales
+    if (serialCompactEncoding) requestCompact();
+    return true;
+}
+
+void USBSession::requestCompact() {
+    boost::system::error_code ec;
+    uint8_t request = CompactFormat::REQUEST;
+    boost::asio::write(serial_port_, boost::asio::buffer(&request, 1), ec);
+    if (ec) std::cerr << "[USB] Could not request compact encoding: " << ec.message() << std::endl;
+    awaiting_scales_ = !ec;
+    last_request_ = std::chrono::steady_clock::now();
 }
 
 USBSession::~USBSession() {
@@ -54,10 +110,263 @@ USBSession::~USBSession() {
 
 void USBSession::run() {
     if (serial_port_.is_open()) {
+        startReadLoop();
+    } else {
+        std::cout << "[USB] Waiting for a USB serial port" << std::endl;
+        waitForDevice();
+    }
+}
+
+void USBSession::startReadLoop() {
+    // The checkpoint follows the device rather than the port name when it has a serial number
+    if (!attached_) {
+        device_id_ = "usb:" + (device_serial_.empty() ? port_name_ : device_serial_);
+        checkpointer_.attach(device_id_);
+        attached_ = true;
+    }
+
+    if (read_loop_ == ReadLoop::Coroutine) {
+        boost::asio::co_spawn(serial_port_.get_executor(), readCoroutine(), boost::asio::detached);
+    } else {
         startReading();
     }
 }
 
+void USBSession::waitForDevice() {
+    auto self(shared_from_this());
+    watcher_.waitFor(device_serial_, port_name_, [this, self](const SerialPortWatcher::Port& port) {
+        if (openPort(port.path)) {
+            startReadLoop();
+            return;
+        }
+        // The node can appear before udev has set its permissions
+        retry_timer_.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(serialRetrySeconds)));
+        retry_timer_.async_wait([this, self](const boost::system::error_code& ec) {
+            if (!ec) waitForDevice();
+        });
+    });
+}
+
+// A read failed: the device is gone (unplugged, reset) or the port is unusable. Close it, release
+// what the reorder stage holds, and reopen the same device when it comes back
+void USBSession::portLost(const boost::system::error_code& ec) {
+    if (ec == boost::asio::error::operation_aborted) return;   // Port closed on shutdown
+
+    std::cerr << "[USB] Lost " << port_name_ << ": " << ec.message() << ". Waiting for the device to return" << std::endl;
+    boost::system::error_code closeError;
+    serial_port_.close(closeError);
+    pipeline_.flush();
+    if (last_batch_arrival_ != std::chrono::steady_clock::time_point()) gap_pending_ = true;
+    waitForDevice();
+}
+
+boost::asio::awaitable<void> USBSession::readCoroutine() {
+    auto self(shared_from_this());   // Keeps the session alive for the whole loop
+    boost::system::error_code ec;
+    auto token = boost::asio::redirect_error(boost::asio::use_awaitable, ec);
+
+    while (true) {
+        std::size_t received = co_await serial_port_.async_read_some(
+            boost::asio::buffer(receive_buffer_.data() + receive_end_, receive_buffer_.size() - receive_end_), token);
+        if (ec) {
+            portLost(ec);
+            co_return;
+        }
+        receive_end_ += received;
+        parseReceived();
+    }
+}
+
+// Process every complete batch in the receive buffer; a trailing partial one waits for the next read
+void USBSession::parseReceived() {
+    std::size_t pos = 0;
+    while (pos < receive_end_) {
+        if (!isSyncByte(receive_buffer_[pos])) {
+            pos++;
+            continue;
+        }
+        std::size_t header_bytes = headerBytes();
+        if (receive_end_ - pos - 1 < header_bytes) break;
+        std::memcpy(binary_buffer_.data(), &receive_buffer_[pos + 1], header_bytes);
+        if (!parseHeader()) {
+            pos++;   // Look for the next sync byte right after this one
+            continue;
+        }
+
+        std::size_t batch_bytes = 1 + header_bytes + bytes_needed_;
+        if (receive_end_ - pos < batch_bytes) break;
+        std::memcpy(binary_buffer_.data(), &receive_buffer_[pos + 1 + header_bytes], bytes_needed_);
+        handlePayload(binary_buffer_.data());
+        pos += batch_bytes;
+    }
+
+    std::memmove(receive_buffer_.data(), receive_buffer_.data() + pos, receive_end_ - pos);
+    receive_end_ -= pos;
+}
+
+bool USBSession::isSyncByte(uint8_t byte) {
+    switch (byte) {
+        case SYNC_BYTE:
+        case SYNC_BYTE_TIMESTAMPED:
+            batch_kind_ = BatchKind::FLOAT;
+            timestamped_ = byte == SYNC_BYTE_TIMESTAMPED;
+            return true;
+        case SYNC_BYTE_SCALES:
+            batch_kind_ = BatchKind::SCALES;
+            return true;
+        case SYNC_BYTE_COMPACT:
+            batch_kind_ = BatchKind::COMPACT;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Fixed header after the sync byte. A compact batch's device time is read with its data
+std::size_t USBSession::headerBytes() const {
+    switch (batch_kind_) {
+        case BatchKind::SCALES: return sizeof(CompactFormat::SCALES_MAGIC);
+        case BatchKind::COMPACT: return 4;
+        default: return timestamped_ ? 7 : 3;
+    }
+}
+
+// Parse and validate the header in binary_buffer_ (order: mag, accel, gyro, then the device time;
+// a compact batch starts with its flags)
+bool USBSession::parseHeader() {
+    // Anything but the awaited reply is a 0xAC inside other data: keep looking for a sync byte
+    if (batch_kind_ == BatchKind::SCALES) {
+        bytes_needed_ = CompactFormat::SCALES_BYTES;
+        return awaiting_scales_ && std::equal(std::begin(CompactFormat::SCALES_MAGIC), std::end(CompactFormat::SCALES_MAGIC),
+                                              binary_buffer_.begin());
+    }
+
+    const uint8_t* counts = binary_buffer_.data();
+    if (batch_kind_ == BatchKind::COMPACT) {
+        compact_flags_ = binary_buffer_[0];
+        timestamped_ = compact_flags_ & CompactFormat::TIMESTAMP;
+        counts++;
+        if (compact_flags_ & ~(CompactFormat::DELTA_MAG | CompactFormat::DELTA_ACCEL | CompactFormat::DELTA_GYRO | CompactFormat::TIMESTAMP)) {
+            std::cerr << "[USB] Invalid compact flags 0x" << std::hex << (int)compact_flags_ << std::dec << ". Resyncing..." << std::endl;
+            ingestStats_.countResync();
+            return false;
+        }
+    }
+
+    uint8_t mag_samples = counts[0];
+    uint8_t accel_samples = counts[1];
+    uint8_t gyro_samples = counts[2];
+    if (timestamped_ && batch_kind_ == BatchKind::FLOAT) {
+        std::memcpy(&batch_device_micros_, &binary_buffer_[3], sizeof(batch_device_micros_));
+    }
+
+    // Simple validation
+    if (gyro_samples > MAX_BATCH_SAMPLES || accel_samples > MAX_BATCH_SAMPLES || mag_samples > MAX_BATCH_SAMPLES) {
+        std::cerr << "[USB] Invalid header: mag=" << (int)mag_samples 
+                  << ", accel=" << (int)accel_samples 
+                  << ", gyro=" << (int)gyro_samples << ". Resyncing..." << std::endl;
+        ingestStats_.countResync();
+        return false;
+    }
+
+    // Store header info for data reading
+    current_header_ = {
+        .mag_samples = mag_samples,
+        .accel_samples = accel_samples,
+        .gyro_samples = gyro_samples
+    };
+
+    if (batch_kind_ == BatchKind::COMPACT) {
+        bytes_needed_ = (timestamped_ ? sizeof(batch_device_micros_) : 0)
+                      + compactBytes(mag_samples, compact_flags_ & CompactFormat::DELTA_MAG)
+                      + compactBytes(accel_samples, compact_flags_ & CompactFormat::DELTA_ACCEL)
+                      + compactBytes(gyro_samples, compact_flags_ & CompactFormat::DELTA_GYRO);
+        return true;
+    }
+
+    // Calculate data size: (gyro + accel + mag) * 3 floats each * 4 bytes per float
+    bytes_needed_ = (gyro_samples * 3 + accel_samples * 3 + mag_samples * 3) * sizeof(float);
+    return true;
+}
+
+// The bytes_needed_ bytes after the header
+void USBSession::handlePayload(const uint8_t* data) {
+    switch (batch_kind_) {
+        case BatchKind::FLOAT:
+            processBatch(current_header_, bytes_needed_ > 0 ? reinterpret_cast<const float*>(data) : nullptr);
+            break;
+        case BatchKind::SCALES:
+            parseScales(data);
+            break;
+        case BatchKind::COMPACT:
+            decodeCompact(data);
+            break;
+    }
+}
+
+void USBSession::parseScales(const uint8_t* data) {
+    SensorScale scales[3];
+    for (SensorScale& sensor : scales) {
+        std::memcpy(&sensor.scale, data, sizeof(float));
+        std::memcpy(sensor.offset, data + sizeof(float), 3 * sizeof(float));
+        data += 4 * sizeof(float);
+        if (!std::isfinite(sensor.scale) || sensor.scale == 0.0f || !std::isfinite(sensor.offset[0]) ||
+            !std::isfinite(sensor.offset[1]) || !std::isfinite(sensor.offset[2])) {
+            std::cerr << "[USB] Invalid compact scales. Resyncing..." << std::endl;
+            ingestStats_.countResync();
+            return;
+        }
+    }
+
+    std::copy(std::begin(scales), std::end(scales), scales_);
+    std::cout << "[USB] Compact encoding: mag " << scales_[0].scale << ", accel " << scales_[1].scale
+              << ", gyro " << scales_[2].scale << " per count" << std::endl;
+    have_scales_ = true;
+    awaiting_scales_ = false;
+}
+
+// Expand int16 counts (or int8 deltas) to floats and hand them on like a float batch
+void USBSession::decodeCompact(const uint8_t* data) {
+    if (!have_scales_) {
+        if (!warned_no_scales_) {
+            std::cerr << "[USB] Compact batches before the device's scales, dropping them" << std::endl;
+            warned_no_scales_ = true;
+        }
+        if (serialCompactEncoding && std::chrono::steady_clock::now() - last_request_ >= std::chrono::seconds(1)) requestCompact();
+        return;
+    }
+
+    if (timestamped_) {
+        std::memcpy(&batch_device_micros_, data, sizeof(batch_device_micros_));
+        data += sizeof(batch_device_micros_);
+    }
+
+    const uint8_t samples[3] = {current_header_.mag_samples, current_header_.accel_samples, current_header_.gyro_samples};
+    const uint8_t deltas[3] = {CompactFormat::DELTA_MAG, CompactFormat::DELTA_ACCEL, CompactFormat::DELTA_GYRO};
+    float* out = decoded_.data();
+    for (int sensor = 0; sensor < 3; sensor++) {
+        const SensorScale& scale = scales_[sensor];
+        bool delta = compact_flags_ & deltas[sensor];
+        int32_t count[3] = {0, 0, 0};
+        for (int i = 0; i < samples[sensor]; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                if (i == 0 || !delta) {
+                    int16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    data += sizeof(value);
+                    count[axis] = value;
+                } else {
+                    count[axis] += static_cast<int8_t>(*data++);
+                }
+                *out++ = count[axis] * scale.scale + scale.offset[axis];
+            }
+        }
+    }
+
+    processBatch(current_header_, decoded_.data());
+}
+
 void USBSession::startReading() {
     switch (read_state_) {
         case ReadState::SYNC:
@@ -78,11 +387,11 @@ void USBSession::readSyncByte() {
         boost::asio::buffer(binary_buffer_.data(), 1),
         [this, self](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (ec) {
-                std::cerr << "[USB] Sync read error: " << ec.message() << std::endl;
+                portLost(ec);
                 return;
             }
             
-            if (binary_buffer_[0] == SYNC_BYTE) {
+            if (isSyncByte(binary_buffer_[0])) {
                 read_state_ = ReadState::HEADER;
                 readPacketHeader();
             } else {
@@ -97,158 +406,73 @@ void USBSession::processBatch(const BatchHeader& header, const float* data) {
         std::cerr << "[USB] Warning: No data to process but samples indicated" << std::endl;
         return;
     }
+    std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+    ingestStats_.countMessage();
+
+    // First batch after a reconnect: record the gap and move rate-based timestamps across it
+    if (gap_pending_) {
+        double gap = std::chrono::duration<double>(arrival - last_batch_arrival_).count();
+        gap_pending_ = false;
+        ingestStats_.countReconnect(gap);
+        timestamper_.skip(gap);
+        std::cout << "[USB] Data resumed on " << port_name_ << " after a " << gap * 1000.0 << " ms gap" << std::endl;
+    }
+    last_batch_arrival_ = arrival;
     
     // Debug output
     std::cout << "[USB] Processing batch: gyro=" << (int)header.gyro_samples 
               << ", accel=" << (int)header.accel_samples 
               << ", mag=" << (int)header.mag_samples;  
 
-    // Parse data from the buffer (order: mag -> accel -> gyro)
-    const float* data_ptr = data;
-    
-    // Extract mag data (now supports multiple samples)
-    struct MagSample {
-        float x, y, z;
-        float timestamp;
-    };
-    std::vector<MagSample> magSamples;
-    
-    for (int i = 0; i < header.mag_samples; i++) {
-        magSamples.push_back({data_ptr[0], data_ptr[1], data_ptr[2], magTimestamp_});
-        magTimestamp_ += magDeltaT;
-        data_ptr += 3;
-    }
-    
-    // Extract accel data
-    struct AccelSample {
-        float x, y, z;
-        float timestamp;
-    };
-    std::vector<AccelSample> accelSamples;
-    
-    for (int i = 0; i < header.accel_samples; i++) {
-        accelSamples.push_back({data_ptr[0], data_ptr[1], data_ptr[2], accelTimestamp_});
-        accelTimestamp_ += accelDeltaT;
-        data_ptr += 3;
-    }
-    
-    // Extract gyro data
-    struct GyroSample {
-        float x, y, z;
-        float timestamp;
-    };
-    std::vector<GyroSample> gyroSamples;
-    
-    for (int i = 0; i < header.gyro_samples; i++) {
-        gyroSamples.push_back({data_ptr[0], data_ptr[1], data_ptr[2], gyroTimestamp_});
-        gyroTimestamp_ += gyroDeltaT;
-        data_ptr += 3;
-    }
-    
-    // Create a combined sorted list of all samples by timestamp
-    struct SensorSample {
-        enum Type { MAG, ACCEL, GYRO } type;
-        float x, y, z;
-        float timestamp;
-        int index; // Index within the specific sensor type
-    };
-    
-    std::vector<SensorSample> allSamples;
-    
-    // Add all samples to the combined list
-    for (size_t i = 0; i < magSamples.size(); i++) {
-        allSamples.push_back({SensorSample::MAG, magSamples[i].x, magSamples[i].y, magSamples[i].z, magSamples[i].timestamp, (int)i});
-    }
-    for (size_t i = 0; i < accelSamples.size(); i++) {
-        allSamples.push_back({SensorSample::ACCEL, accelSamples[i].x, accelSamples[i].y, accelSamples[i].z, accelSamples[i].timestamp, (int)i});
-    }
-    for (size_t i = 0; i < gyroSamples.size(); i++) {
-        allSamples.push_back({SensorSample::GYRO, gyroSamples[i].x, gyroSamples[i].y, gyroSamples[i].z, gyroSamples[i].timestamp, (int)i});
-    }
-    
-    // Sort by timestamp to restore temporal order
-    std::sort(allSamples.begin(), allSamples.end(), 
-              [](const SensorSample& a, const SensorSample& b) {
-                  return a.timestamp < b.timestamp;
-              });
-    
-    // Process samples in temporal order for proper filtering
-    for (const auto& sample : allSamples) {
-        switch (sample.type) {
-            case SensorSample::MAG:
-                magDataBuffer_.append(sample.x, sample.y, sample.z);
-                magTimesBuffer_.append(sample.timestamp);
-                complementaryFilter_.updateWithMag(sample.x, sample.y, sample.z);
-                if (sample.index == 0) { // Only print first sample to avoid spam
-                    std::cout << "[USB] Mag: " << sample.x << ", " << sample.y << ", " << sample.z << std::endl;
-                }
-                break;
-                
-            case SensorSample::ACCEL:
-                accelDataBuffer_.append(sample.x, sample.y, sample.z);
-                accelTimesBuffer_.append(sample.timestamp);
-                complementaryFilter_.updateWithAccel(sample.x, sample.y, sample.z);
-                if (sample.index == 0) { // Only print first sample to avoid spam
-                    std::cout << "[USB] Accel: " << sample.x << ", " << sample.y << ", " << sample.z << std::endl;
-                }
-                break;
-                
-            case SensorSample::GYRO:
-                gyroDataBuffer_.append(sample.x, sample.y, sample.z);
-                gyroTimesBuffer_.append(sample.timestamp);
-                complementaryFilter_.updateWithGyro(sample.x, sample.y, sample.z);
-                if (sample.index == 0) { // Only print first sample to avoid spam
-                    std::cout << "[USB] Gyro: " << sample.x << ", " << sample.y << ", " << sample.z << std::endl;
-                }
-                break;
+    // The batch is a SensorMessage without the sync/flags framing: data order mag -> accel -> gyro,
+    // timestamps from the device time when present, otherwise from the sensor rates. The pipeline's
+    // reorder stage restores time order within and across batches
+    SensorMessage message;
+    message.counts[static_cast<int>(SensorType::Mag)] = header.mag_samples;
+    message.counts[static_cast<int>(SensorType::Accel)] = header.accel_samples;
+    message.counts[static_cast<int>(SensorType::Gyro)] = header.gyro_samples;
+    message.hasTimestamp = timestamped_;
+    message.deviceMicros = batch_device_micros_;
+    message.values = reinterpret_cast<const uint8_t*>(data);
+
+    const char* names[3] = {"Mag", "Accel", "Gyro"};
+    bool printed[3] = {false, false, false};
+    timestamper_.emit(message, arrival, [&](const SensorSample& sample) {
+        int sensor = static_cast<int>(sample.type);
+        if (!printed[sensor]) { // Only print first sample to avoid spam
+            std::cout << "[USB] " << names[sensor] << ": " << sample.x << ", " << sample.y << ", " << sample.z << std::endl;
+            printed[sensor] = true;
         }
-    }
+        pipeline_.push(sample, arrival);
+    });
+
+    pipeline_.release();
 }
 
 void USBSession::readPacketHeader() {
     auto self(shared_from_this());
-    // Read fixed-size header (3 bytes after sync) 
+    // Read fixed-size header (3 bytes after sync, plus the 4-byte device timestamp when present;
+    // flags and counts for a compact batch, the magic for scales)
     boost::asio::async_read(serial_port_, 
-        boost::asio::buffer(binary_buffer_.data(), 3),
+        boost::asio::buffer(binary_buffer_.data(), headerBytes()),
         [this, self](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (ec) {
-                std::cerr << "[USB] Header read error: " << ec.message() << std::endl;
-                read_state_ = ReadState::SYNC;
-                startReading();
+                portLost(ec);
                 return;
             }
             
-            // Parse header (order: mag, accel, gyro)
-            uint8_t mag_samples = binary_buffer_[0];
-            uint8_t accel_samples = binary_buffer_[1];
-            uint8_t gyro_samples = binary_buffer_[2];
-            
-            // Simple validation
-            if (gyro_samples > 7 || accel_samples > 7 || mag_samples > 7) {
-                std::cerr << "[USB] Invalid header: mag=" << (int)mag_samples 
-                          << ", accel=" << (int)accel_samples 
-                          << ", gyro=" << (int)gyro_samples << ". Resyncing..." << std::endl;
+            if (!parseHeader()) {
                 read_state_ = ReadState::SYNC;
                 startReading();
                 return;
             }
             
-            // Store header info for data reading
-            current_header_ = {
-                .mag_samples = mag_samples,
-                .accel_samples = accel_samples,
-                .gyro_samples = gyro_samples
-            };
-            
-            // Calculate data size: (gyro + accel + mag) * 3 floats each * 4 bytes per float
-            bytes_needed_ = (gyro_samples * 3 + accel_samples * 3 + mag_samples * 3) * sizeof(float);
-            
             if (bytes_needed_ > 0) {
                 read_state_ = ReadState::DATA;
                 readPacketData();
             } else {
                 // No data, process empty packet
-                processBatch(current_header_, nullptr);
+                handlePayload(nullptr);
                 read_state_ = ReadState::SYNC;
                 startReading();
             }
@@ -261,9 +485,7 @@ void USBSession::readPacketData() {
         boost::asio::buffer(binary_buffer_.data(), bytes_needed_),
         [this, self](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (ec) {
-                std::cerr << "[USB] Data read error: " << ec.message() << std::endl;
-                read_state_ = ReadState::SYNC;
-                startReading();
+                portLost(ec);
                 return;
             }
             
@@ -271,14 +493,14 @@ void USBSession::readPacketData() {
             if (bytes_transferred != bytes_needed_) {
                 std::cerr << "[USB] Data size mismatch: expected " << bytes_needed_ 
                           << ", got " << bytes_transferred << std::endl;
+                ingestStats_.countResync();
                 read_state_ = ReadState::SYNC;
                 startReading();
                 return;
             }
             
             // Process the received data
-            const float* float_data = reinterpret_cast<const float*>(binary_buffer_.data());
-            processBatch(current_header_, float_data);
+            handlePayload(binary_buffer_.data());
             
             // Return to sync state
             read_state_ = ReadState::SYNC;
@@ -1,8 +1,4 @@
 #include <iostream>
-#include <regex>
-#include <sstream>
-#include <iomanip>
-#include <cstring>
 
 #include "communication/WebSocketSession.h"
 #include "Config.h"
@@ -12,12 +8,19 @@
 WebSocketSession::WebSocketSession(net::io_context& ioc, unsigned short port, 
             GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer,
             GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer,
-            ComplementaryFilter& complementaryFilter)
+            ComplementaryFilter& complementaryFilter, Prefilter& prefilter, SensorRecorder& recorder,
+            ClockSync& clockSync, IngestStats& ingestStats, FilterCheckpointer& checkpointer,
+        const SensorRates& rates)
     : 
     acceptor_(ioc, {tcp::v4(), port}),
-    gyroDataBuffer_(gyroDataBuffer), accelDataBuffer_(accelDataBuffer), magDataBuffer_(magDataBuffer),
-    gyroTimesBuffer_(gyroTimesBuffer), accelTimesBuffer_(accelTimesBuffer), magTimesBuffer_(magTimesBuffer),
-    complementaryFilter_(complementaryFilter) {
+    complementaryFilter_(complementaryFilter),
+    clockSync_(clockSync),
+    ingestStats_(ingestStats),
+    checkpointer_(checkpointer),
+    timestamper_(clockSync, rates),
+    pipeline_(ioc, gyroDataBuffer, accelDataBuffer, magDataBuffer,
+              gyroTimesBuffer, accelTimesBuffer, magTimesBuffer, complementaryFilter, prefilter, recorder, clockSync,
+              ingestStats) {
     std::cout << "[Server] WebSocket server started on port " << port << std::endl;
     run();
 }
@@ -45,11 +48,21 @@ void WebSocketSession::handleConnection(tcp::socket socket) {
     //}
     
     std::cout << "[Server] Connection accepted" << std::endl;
+    // Devices reconnect from new ports, so the address alone identifies one for its checkpoint
+    beast::error_code addressError;
+    std::string deviceId = "ws:" + socket.remote_endpoint(addressError).address().to_string();
     ws_.emplace(std::move(socket));
-    ws_->async_accept([this](beast::error_code ec) {
+    ws_->async_accept([this, deviceId](beast::error_code ec) {
         if (!ec) {
             std::cout << "[Server] WebSocket handshake successful" << std::endl;
-            readLoop();
+            checkpointer_.attach(deviceId);          // Warm start from this device's last state
+            complementaryFilter_.startAlignment();   // New connection, re-derive the attitude from fresh samples
+            clockSync_.reset();                      // and estimate the new device's clock from scratch
+            if (readLoop_ == ReadLoop::Coroutine) {
+                net::co_spawn(acceptor_.get_executor(), readCoroutine(), net::detached);
+            } else {
+                readLoop();
+            }
         } else {
             std::cerr << "[Server] Handshake error: " << ec.message() << std::endl;
             ws_.reset();
@@ -68,79 +81,38 @@ void WebSocketSession::readLoop() {
         });
 }
 
+net::awaitable<void> WebSocketSession::readCoroutine() {
+    beast::error_code ec;
+    auto token = net::redirect_error(net::use_awaitable, ec);
+    while (ws_) {
+        size_t bytes = co_await ws_->async_read(buffer_, token);
+        if (ec) {
+            ws_.reset();
+            co_return;
+        }
+        processMessage(bytes);
+        buffer_.consume(bytes);
+    }
+}
+
 void WebSocketSession::processMessage(size_t bytes) {
     // Get raw binary data
     const uint8_t* data = static_cast<const uint8_t*>(buffer_.data().data());
-    
-    // Verify minimum message length (sync + flags)
-    if (bytes < 2) {
-        std::cerr << "[Server] Message too short" << std::endl;
-        return;
-    }
-    
-    // Check sync byte
-    if (data[0] != 0xAA) {
-        std::cerr << "[Server] Invalid sync byte: 0x" << std::hex << (int)data[0] << std::endl;
-        return;
-    }
-    
-    // Parse flags
-    uint8_t flags = data[1];
-    bool hasMag = (flags & 0x04) != 0;
-    bool hasAccel = (flags & 0x02) != 0;
-    bool hasGyro = (flags & 0x01) != 0;
-    
-    // Calculate expected payload size
-    size_t numFloats = (hasMag ? 3 : 0) + (hasAccel ? 3 : 0) + (hasGyro ? 3 : 0);
-    size_t expectedSize = 2 + (numFloats * 4); // 2 header bytes + float data
-    
-    if (bytes != expectedSize) {
-        std::cerr << "[Server] Size mismatch. Expected " << expectedSize 
-                  << " bytes, got " << bytes << std::endl;
+
+    std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+    ingestStats_.countMessage();
+
+    SensorMessage message;
+    ParseError error = parseSensorMessage(data, bytes, message);
+    if (error != ParseError::None) {
+        ingestStats_.countRejected();
+        std::cerr << "[Server] Dropped message (" << bytes << " bytes): " << describeParseError(error) << std::endl;
         return;
     }
-    
-    // Extract float values from binary data
-    std::vector<float> values;
-    size_t offset = 2; // Skip sync and flags
-    
-    for (size_t i = 0; i < numFloats; i++) {
-        float val;
-        memcpy(&val, &data[offset], 4);
-        values.push_back(val);
-        offset += 4;
-    }
-    
-    // Process sensor data in order: mag, accel, gyro
-    size_t index = 0;
-    
-    if (hasMag) {
-        // std::cout << std::setprecision(6) << "Mag: " << values[index] << ", " 
-        //          << values[index+1] << ", " << values[index+2] << std::endl;
-        complementaryFilter_.updateWithMag(values[index], values[index+1], values[index+2]);
-        magDataBuffer_.append(values[index], values[index+1], values[index+2]);
-        magTimestamp_ += magDeltaT;
-        magTimesBuffer_.append(magTimestamp_);
-        index += 3;
-    }
-    
-    if (hasAccel) {
-        // std::cout << std::setprecision(6) << "Accel: " << values[index] << ", " 
-        //          << values[index+1] << ", " << values[index+2] << std::endl;
-        complementaryFilter_.updateWithAccel(values[index], values[index+1], values[index+2]);
-        accelDataBuffer_.append(values[index], values[index+1], values[index+2]);
-        accelTimestamp_ += accelDeltaT;
-        accelTimesBuffer_.append(accelTimestamp_);
-        index += 3;
-    }
-    
-    if (hasGyro) {
-        // std::cout << std::setprecision(6) << "Gyro: " << values[index] << ", " 
-        //          << values[index+1] << ", " << values[index+2] << std::endl;
-        complementaryFilter_.updateWithGyro(values[index], values[index+1], values[index+2]);
-        gyroDataBuffer_.append(values[index], values[index+1], values[index+2]);
-        gyroTimestamp_ += gyroDeltaT;
-        gyroTimesBuffer_.append(gyroTimestamp_);
-        index += 3;
-    }
-}
\ No newline at end of file
+
+    // Queue sensor data in order: mag, accel, gyro. The pipeline releases it in timestamp order
+    timestamper_.emit(message, arrival, [this, arrival](const SensorSample& sample) {
+        pipeline_.push(sample, arrival);
+    });
+    pipeline_.release();
+}
@@ -7,7 +7,14 @@
 #include "util/Structs3D.h"
 #include "communication/WebSocketSession.h"
 #include "communication/USBSession.h"
+#include "communication/SerialPortWatcher.h"
+#include "communication/UDPSession.h"
 #include "ComplementaryFilter.h"
+#include "Prefilter.h"
+#include "storage/SensorRecorder.h"
+#include "storage/FilterCheckpoint.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
 #include "ui/RunApp.h"
 
 // Function to get the appropriate serial port name for each platform
@@ -23,6 +30,16 @@ std::string getDefaultSerialPort() {
 #endif
 }
 
+// The configured port, else the first USB serial port present (the device with serialDeviceSerial
+// if set), else the platform default. The USB session waits for the device if it is not there yet
+std::string findSerialPort() {
+    if (serialPortName[0] != '\0') return serialPortName;
+    for (const SerialPortWatcher::Port& port : SerialPortWatcher::list()) {
+        if (serialDeviceSerial[0] == '\0' || port.serial == serialDeviceSerial) return port.path;
+    }
+    return getDefaultSerialPort();
+}
+
 // Function to pre-fill the buffers with empty data
 void prefillBuffers(GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, MagBuffer& magDataBuffer, 
                     GyroTimesBuffer& gyroTimesBuffer, AccelTimesBuffer& accelTimesBuffer, MagTimesBuffer& magTimesBuffer){    
@@ -49,24 +66,24 @@ void prefillBuffers(GyroBuffer& gyroDataBuffer, AccelBuffer& accelDataBuffer, Ma
 
     // Pre-fill gyro time buffer
     timeStep = 1.0f / gyroFreq;
-    std::array<float, gyroBufferSize> gyroTimes;
-    for (int i = 0; i < gyroBufferSize; i++) {
+    std::vector<float> gyroTimes(gyroBufferSize);
+    for (std::size_t i = 0; i < gyroBufferSize; i++) {
         gyroTimes[i] = (i * timeStep) - bufferSeconds;
     }
     gyroTimesBuffer.append(gyroTimes.data(), gyroBufferSize);
 
     // Pre-fill accel time buffer
     timeStep = 1.0f / accelFreq;
-    std::array<float, accelBufferSize> accelTimes;
-    for (int i = 0; i < accelBufferSize; i++) {
+    std::vector<float> accelTimes(accelBufferSize);
+    for (std::size_t i = 0; i < accelBufferSize; i++) {
         accelTimes[i] = (i * timeStep) - bufferSeconds;
     }
     accelTimesBuffer.append(accelTimes.data(), accelBufferSize);
 
     // Pre-fill mag time buffer
     timeStep = 1.0f / magFreq;
-    std::array<float, magBufferSize> magTimes;
-    for (int i = 0; i < magBufferSize; i++) {
+    std::vector<float> magTimes(magBufferSize);
+    for (std::size_t i = 0; i < magBufferSize; i++) {
         magTimes[i] = (i * timeStep) - bufferSeconds;
     }
     magTimesBuffer.append(magTimes.data(), magBufferSize);
@@ -77,6 +94,9 @@ int main() {
     GyroBuffer gyroDataBuffer; AccelBuffer accelDataBuffer; MagBuffer magDataBuffer;
     GyroTimesBuffer gyroTimesBuffer; AccelTimesBuffer accelTimesBuffer; MagTimesBuffer magTimesBuffer;
     prefillBuffers(gyroDataBuffer, accelDataBuffer, magDataBuffer, gyroTimesBuffer, accelTimesBuffer, magTimesBuffer);
+    BufferArena::Stats bufferStats = BufferArena::global().stats();
+    std::cout << "[Buffers] " << bufferStats.usedBytes / 1024 << " KiB of sample history in " << bufferStats.chunks << " chunk(s), "
+              << pageModeName(bufferStats.pages) << (bufferStats.prefaulted ? ", prefaulted" : "") << std::endl;
 
     // Initialize the shared attitude object
     Structs3D::QuaternionF estimatedAttitude = { 1.0, 0.0, 0.0, 0.0 }; // w, x, y, z
@@ -87,32 +107,54 @@ int main() {
     // Create the complementary filter object for estimating the attitude
     ComplementaryFilter complementaryFilter(estimatedAttitude, accelVector);
 
+    // Per-sensor biquad chains applied before fusion (tuned from the UI)
+    Prefilter prefilter;
+
+    // Compressed recording of the raw streams (started from the UI)
+    SensorRecorder recorder;
+
+    // Device-to-host clock estimate for timestamped streams
+    ClockSync clockSync;
+
+    // Lock-free ingestion counters for the performance panel
+    IngestStats ingestStats;
+
     // Start the communication session on a separate thread based on the selected mode
     std::shared_ptr<void> sessionHolder;    // Create a shared_ptr to keep session alive
     boost::asio::io_context ioc;            // IO context for the communication session
+
+    // Per-device filter state saved periodically and restored when the device connects
+    FilterCheckpointer checkpointer(ioc, complementaryFilter);
     
-    if (UseWebSocket) {
+    if (communicationMode == CommunicationMode::WebSocket) {
         auto server = std::make_shared<WebSocketSession>(ioc, 8000, 
             gyroDataBuffer, accelDataBuffer, magDataBuffer,
             gyroTimesBuffer, accelTimesBuffer, magTimesBuffer, 
-            complementaryFilter);
+            complementaryFilter, prefilter, recorder, clockSync, ingestStats, checkpointer);
         server->run();
         sessionHolder = server; // Keep alive
+    } else if (communicationMode == CommunicationMode::UDP) {
+        auto udp = std::make_shared<UDPSession>(ioc, 8001,
+            gyroDataBuffer, accelDataBuffer, magDataBuffer,
+            gyroTimesBuffer, accelTimesBuffer, magTimesBuffer,
+            complementaryFilter, prefilter, recorder, clockSync, ingestStats, checkpointer);
+        udp->run();
+        sessionHolder = udp; // Keep alive
     } else {
         // USB mode - now supported on all platforms
-        std::string portName = getDefaultSerialPort();
+        std::string portName = findSerialPort();
         if (portName.empty()) {
             std::cerr << "USB mode not supported on this platform" << std::endl;
             return 1;
         }
         
         std::cout << "Using serial port: " << portName << std::endl;
-        std::cout << "Note: You may need to adjust the port name in getDefaultSerialPort() for your specific device" << std::endl;
+        std::cout << "Note: Set serialPortName or serialDeviceSerial in Config.h to choose another device" << std::endl;
         
         auto usb = std::make_shared<USBSession>(ioc, portName,
             gyroDataBuffer, accelDataBuffer, magDataBuffer,
             gyroTimesBuffer, accelTimesBuffer, magTimesBuffer,
-            complementaryFilter);
+            complementaryFilter, prefilter, recorder, clockSync, ingestStats, checkpointer);
         usb->run();
         sessionHolder = usb; // Keep alive
     }
@@ -121,11 +163,12 @@ int main() {
 
     // Run App Window
     runApp(gyroDataBuffer, accelDataBuffer, magDataBuffer, gyroTimesBuffer, accelTimesBuffer, magTimesBuffer, 
-           estimatedAttitude, accelVector, complementaryFilter);
+           estimatedAttitude, accelVector, complementaryFilter, prefilter, recorder, clockSync, ingestStats, checkpointer);
 
     // Clean up on exit
     ioc.stop();
     ioThread.join();
+    checkpointer.save();
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "storage/FilterCheckpoint.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Flush a file's (or a directory's entries') data to the disk; a no-op where POSIX fsync is missing
+bool syncToDisk(const std::string& path) {
+#if defined(__linux__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+double unixSeconds() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool sameGains(const ComplementaryFilter::Gains& a, const ComplementaryFilter::Gains& b) {
+    return a.kpRollPitch == b.kpRollPitch && a.kiRollPitch == b.kiRollPitch && a.kpYaw == b.kpYaw && a.kiYaw == b.kiYaw;
+}
+
+bool finite(const ComplementaryFilter::Gains& g) {
+    return std::isfinite(g.kpRollPitch) && std::isfinite(g.kiRollPitch) && std::isfinite(g.kpYaw) && std::isfinite(g.kiYaw);
+}
+
+} // namespace
+
+bool FilterCheckpoint::read(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    // Every line is required; an unknown version or a missing field rejects the whole file
+    int version = 0;
+    bool fields[7] = {false, false, false, false, false, false, false};
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string key;
+        stream >> key;
+        if (key == "version") {
+            stream >> version;
+        } else if (key == "device") {
+            stream >> std::ws;
+            fields[0] = static_cast<bool>(std::getline(stream, deviceId));
+        } else if (key == "saved") {
+            fields[1] = static_cast<bool>(stream >> savedAt);
+        } else if (key == "temperature") {
+            std::string value;
+            stream >> value;
+            std::istringstream number(value);
+            fields[2] = value == "nan" || static_cast<bool>(number >> temperature);
+            if (value == "nan") temperature = NAN;
+        } else if (key == "attitude") {
+            fields[3] = static_cast<bool>(stream >> attitude.w >> attitude.x >> attitude.y >> attitude.z);
+        } else if (key == "gyro_correction") {
+            fields[4] = static_cast<bool>(stream >> gyroCorrection.x >> gyroCorrection.y >> gyroCorrection.z);
+        } else if (key == "gains") {
+            fields[5] = static_cast<bool>(stream >> gains.kpRollPitch >> gains.kiRollPitch >> gains.kpYaw >> gains.kiYaw);
+        } else if (key == "defaults") {
+            fields[6] = static_cast<bool>(stream >> defaults.kpRollPitch >> defaults.kiRollPitch >> defaults.kpYaw >> defaults.kiYaw);
+        }
+    }
+    if (version != VERSION) return false;
+    for (bool field : fields) {
+        if (!field) return false;
+    }
+    return std::isfinite(savedAt) && std::isfinite(attitude.w) && std::isfinite(attitude.x) &&
+           std::isfinite(attitude.y) && std::isfinite(attitude.z) && std::isfinite(gyroCorrection.x) &&
+           std::isfinite(gyroCorrection.y) && std::isfinite(gyroCorrection.z) && finite(gains);
+}
+
+bool FilterCheckpoint::write(const std::string& path) const {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) return false;
+        file.precision(std::numeric_limits<double>::max_digits10);
+        file << "version " << VERSION << "\n"
+             << "device " << deviceId << "\n"
+             << "saved " << savedAt << "\n";
+        if (std::isfinite(temperature)) {
+            file << "temperature " << temperature << "\n";
+        } else {
+            file << "temperature nan\n";
+        }
+        file << "attitude " << attitude.w << " " << attitude.x << " " << attitude.y << " " << attitude.z << "\n"
+             << "gyro_correction " << gyroCorrection.x << " " << gyroCorrection.y << " " << gyroCorrection.z << "\n"
+             << "gains " << gains.kpRollPitch << " " << gains.kiRollPitch << " " << gains.kpYaw << " " << gains.kiYaw << "\n"
+             << "defaults " << defaults.kpRollPitch << " " << defaults.kiRollPitch << " " << defaults.kpYaw << " " << defaults.kiYaw << "\n";
+        file.close();
+        if (!file) return false;
+    }
+
+    // Readers see either the old checkpoint or the new one, never a partial file. The data must be
+    // on disk before the rename, or a power loss can keep the rename and lose the data; syncing the
+    // directory then makes the rename itself durable
+    if (!syncToDisk(temporary)) return false;
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) return false;
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    return syncToDisk(directory.empty() ? "." : directory.string());
+}
+
+FilterCheckpointer::FilterCheckpointer(boost::asio::io_context& ioc, ComplementaryFilter& filter, const std::string& directory)
+    : timer_(ioc), filter_(filter), directory_(directory) {
+    if (directory_.empty()) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "[Checkpoint] Could not create " << directory_ << ": " << ec.message() << std::endl;
+        directory_.clear();
+    }
+}
+
+std::string FilterCheckpointer::pathFor(const std::string& directory, const std::string& deviceId) {
+    std::string name = deviceId;
+    for (char& c : name) {
+        bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '-';
+        if (!keep) c = '_';
+    }
+    return (std::filesystem::path(directory) / (name + ".ckpt")).string();
+}
+
+void FilterCheckpointer::attach(const std::string& deviceId) {
+    if (directory_.empty()) return;
+    if (!deviceId_.empty()) save();   // Also on a reconnect: the live state is newer than the file
+    bool first = deviceId_.empty();
+    deviceId_ = deviceId;
+
+    filter_.discardRestoredState();
+    std::string restore;
+    float age = 0.0f;
+    FilterCheckpoint checkpoint;
+    if (!checkpoint.read(pathFor(directory_, deviceId))) {
+        restore = "No checkpoint";
+    } else {
+        age = static_cast<float>(unixSeconds() - checkpoint.savedAt);
+        if (sameGains(checkpoint.defaults, ComplementaryFilter::Gains())) {
+            filter_.setGains(checkpoint.gains);
+            restore = "Gains";
+        } else {
+            restore = "Config.h gains changed, kept them";
+        }
+
+        bool temperatureKnown = std::isfinite(checkpoint.temperature) && std::isfinite(temperature_);
+        if (age < -checkpointInterval) {
+            restore += "; saved in the future, bias not restored";
+        } else if (age > checkpointMaxAge) {
+            restore += "; too old, bias not restored";
+        } else if (temperatureKnown && std::abs(temperature_ - checkpoint.temperature) > checkpointMaxTemperatureDelta) {
+            restore += "; temperature changed, bias not restored";
+        } else {
+            filter_.restoreState(checkpoint.attitude, checkpoint.gyroCorrection);
+            restore += ", gyro bias and attitude for alignment";
+        }
+    }
+    std::cout << "[Checkpoint] " << deviceId << ": " << restore;
+    if (age != 0.0f) std::cout << " (saved " << age << " s ago)";
+    std::cout << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        status_.deviceId = deviceId;
+        status_.restore = restore;
+        status_.restoredAge = age;
+    }
+    if (first) scheduleSave();
+}
+
+void FilterCheckpointer::save() {
+    if (directory_.empty() || deviceId_.empty() || !filter_.getAlignmentStatus().aligned) return;
+
+    FilterCheckpoint checkpoint;
+    checkpoint.deviceId = deviceId_;
+    checkpoint.savedAt = unixSeconds();
+    checkpoint.temperature = temperature_;
+    checkpoint.attitude = filter_.getAttitude();
+    checkpoint.gyroCorrection = filter_.getGyroCorrection();
+    checkpoint.gains = filter_.getGains();
+    bool ok = checkpoint.write(pathFor(directory_, deviceId_));
+    if (!ok) std::cerr << "[Checkpoint] Could not write " << pathFor(directory_, deviceId_) << std::endl;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (ok) status_.saves++;
+    status_.saveFailed = !ok;
+}
+
+FilterCheckpointer::Status FilterCheckpointer::getStatus() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return status_;
+}
+
+void FilterCheckpointer::scheduleSave() {
+    timer_.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(checkpointInterval)));
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) return;
+        save();
+        scheduleSave();
+    });
+}
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "storage/SensorCodec.h"
+
+namespace {
+
+// Map float bits to unsigned integers with the same ordering, so increasing timestamps have
+// small positive deltas even across exponent boundaries
+uint32_t orderedKey(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+float fromOrderedKey(uint32_t key) {
+    uint32_t bits = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int leadingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return 31 - static_cast<int>(index);
+#else
+    return __builtin_clz(value);
+#endif
+}
+
+int trailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+// Delta-of-delta buckets: '0', '10'+7, '110'+9, '1110'+12, '1111'+32+32
+struct Bucket {
+    uint32_t prefix;
+    int prefixBits;
+    int valueBits;
+};
+constexpr Bucket DOD_BUCKETS[3] = {{0b10, 2, 7}, {0b110, 3, 9}, {0b1110, 4, 12}};
+
+uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+int bitWidth(uint32_t value) {
+    return value == 0 ? 0 : 32 - leadingZeros(value);
+}
+
+} // namespace
+
+SensorBlockEncoder::SensorBlockEncoder(SensorType type, float resolution)
+    : type_(type),
+      coding_(resolution > 0.0f ? ValueCoding::QuantizedDelta : ValueCoding::Xor),
+      resolution_(resolution > 0.0f ? resolution : 0.0f),
+      inverseResolution_(resolution > 0.0f ? 1.0f / resolution : 0.0f) {}
+
+void SensorBlockEncoder::append(float timestamp, float x, float y, float z) {
+    encodeTimestamp(orderedKey(timestamp));
+    const float values[3] = {x, y, z};
+    for (int axis = 0; axis < 3; axis++) {
+        if (coding_ == ValueCoding::Xor) {
+            encodeXor(axis, values[axis]);
+        } else {
+            encodeQuantized(axis, values[axis]);
+        }
+    }
+    count_++;
+}
+
+void SensorBlockEncoder::encodeTimestamp(uint32_t key) {
+    BitWriter& writer = columns_[0].writer;
+    if (count_ == 0) {
+        writer.write(key, 32);
+        previousKey_ = key;
+        previousDelta_ = 0;
+        return;
+    }
+
+    int64_t delta = static_cast<int64_t>(key) - static_cast<int64_t>(previousKey_);
+    int64_t dod = delta - previousDelta_;
+    previousKey_ = key;
+    previousDelta_ = delta;
+
+    if (dod == 0) {
+        writer.write(0, 1);
+        return;
+    }
+    for (const Bucket& bucket : DOD_BUCKETS) {
+        int64_t low = -(int64_t(1) << (bucket.valueBits - 1)) + 1;
+        int64_t high = int64_t(1) << (bucket.valueBits - 1);
+        if (dod >= low && dod <= high) {
+            writer.write(bucket.prefix, bucket.prefixBits);
+            writer.write(static_cast<uint32_t>(dod - low), bucket.valueBits);
+            return;
+        }
+    }
+    uint64_t raw = static_cast<uint64_t>(dod);
+    writer.write(0b1111, 4);
+    writer.write(static_cast<uint32_t>(raw >> 32), 32);
+    writer.write(static_cast<uint32_t>(raw), 32);
+}
+
+void SensorBlockEncoder::encodeXor(int axis, float value) {
+    BitWriter& writer = columns_[axis + 1].writer;
+    AxisState& state = axes_[axis];
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (count_ == 0) {
+        writer.write(bits, 32);
+        state.previous = bits;
+        return;
+    }
+
+    uint32_t xorValue = bits ^ state.previous;
+    state.previous = bits;
+    if (xorValue == 0) {
+        writer.write(0, 1);
+        return;
+    }
+
+    int leading = leadingZeros(xorValue);
+    int trailing = trailingZeros(xorValue);
+    if (state.leading >= 0 && leading >= state.leading && trailing >= state.trailing) {
+        // Fits in the previous meaningful-bit window
+        writer.write(0b10, 2);
+        writer.write(xorValue >> state.trailing, 32 - state.leading - state.trailing);
+        return;
+    }
+
+    int length = 32 - leading - trailing;
+    writer.write(0b11, 2);
+    writer.write(static_cast<uint32_t>(leading), 5);
+    writer.write(static_cast<uint32_t>(length - 1), 5);
+    writer.write(xorValue >> trailing, length);
+    state.leading = leading;
+    state.trailing = trailing;
+}
+
+void SensorBlockEncoder::encodeQuantized(int axis, float value) {
+    AxisState& state = axes_[axis];
+    float scaled = value * inverseResolution_;
+    // Clamp keeps differences within 32 bits; NaN fails both comparisons and becomes 0
+    int32_t quantized = 0;
+    if (scaled >= -1.0e9f && scaled <= 1.0e9f) {
+        quantized = static_cast<int32_t>(std::floor(scaled + 0.5f));
+    }
+    if (count_ == 0) {
+        columns_[axis + 1].writer.write(static_cast<uint32_t>(quantized), 32);
+    } else {
+        state.group[state.grouped++] = zigzag(quantized - static_cast<int32_t>(state.previous));
+        if (state.grouped == GROUP) packGroup(axis);
+    }
+    state.previous = static_cast<uint32_t>(quantized);
+}
+
+// [6-bit width][width bits per difference]
+void SensorBlockEncoder::packGroup(int axis) {
+    AxisState& state = axes_[axis];
+    BitWriter& writer = columns_[axis + 1].writer;
+    uint32_t combined = 0;
+    for (std::size_t i = 0; i < state.grouped; i++) {
+        combined |= state.group[i];
+    }
+    int width = bitWidth(combined);
+    writer.write(static_cast<uint32_t>(width), 6);
+    if (width > 0) {
+        for (std::size_t i = 0; i < state.grouped; i++) {
+            writer.write(state.group[i], width);
+        }
+    }
+    state.grouped = 0;
+}
+
+void SensorBlockEncoder::finish(std::vector<uint8_t>& out) {
+    if (count_ == 0) return;
+
+    uint32_t columnBytes[4];
+    for (int c = 0; c < 4; c++) {
+        if (c > 0 && axes_[c - 1].grouped > 0) packGroup(c - 1);
+        columns_[c].writer.flush();
+        columnBytes[c] = static_cast<uint32_t>(columns_[c].bytes.size());
+    }
+
+    uint8_t header[HEADER_BYTES];
+    header[0] = static_cast<uint8_t>(type_);
+    header[1] = static_cast<uint8_t>(coding_);
+    uint16_t count = static_cast<uint16_t>(count_);
+    std::memcpy(header + 2, &count, sizeof(count));
+    std::memcpy(header + 4, &resolution_, sizeof(resolution_));
+    std::memcpy(header + 8, columnBytes, sizeof(columnBytes));
+    out.insert(out.end(), header, header + HEADER_BYTES);
+    for (const Column& column : columns_) {
+        out.insert(out.end(), column.bytes.begin(), column.bytes.end());
+    }
+    reset();
+}
+
+void SensorBlockEncoder::reset() {
+    count_ = 0;
+    for (Column& column : columns_) {
+        column.bytes.clear();
+        column.writer.rewind();
+    }
+    for (AxisState& state : axes_) {
+        state.leading = -1;
+        state.trailing = 0;
+        state.grouped = 0;
+    }
+}
+
+namespace {
+
+bool decodeTimestamps(const uint8_t* data, std::size_t size, std::size_t count, float* out) {
+    BitReader reader(data, size);
+    uint32_t key = reader.read(32);
+    int64_t delta = 0;
+    out[0] = fromOrderedKey(key);
+
+    std::size_t i = 1;
+    while (i < count) {
+        // Evenly spaced stretches are runs of single '0' bits; take them a window at a time
+        int run = reader.skipZeros(static_cast<int>(std::min<std::size_t>(56, count - i)));
+        for (int r = 0; r < run; r++) {
+            key = static_cast<uint32_t>(static_cast<int64_t>(key) + delta);
+            out[i++] = fromOrderedKey(key);
+        }
+        if (i == count || run == 56) continue;
+
+        reader.readBit();   // The '1' that ended the run starts a bucket prefix
+        int bucket = 0;
+        while (bucket < 3 && reader.readBit()) bucket++;
+        int64_t dod;
+        if (bucket < 3) {
+            int valueBits = DOD_BUCKETS[bucket].valueBits;
+            int64_t low = -(int64_t(1) << (valueBits - 1)) + 1;
+            dod = static_cast<int64_t>(reader.read(valueBits)) + low;
+        } else {
+            uint64_t high = reader.read(32);
+            dod = static_cast<int64_t>((high << 32) | reader.read(32));
+        }
+        delta += dod;
+        key = static_cast<uint32_t>(static_cast<int64_t>(key) + delta);
+        out[i++] = fromOrderedKey(key);
+    }
+    return !reader.overrun();
+}
+
+bool decodeXor(const uint8_t* data, std::size_t size, std::size_t count, float* out) {
+    BitReader reader(data, size);
+    uint32_t bits = reader.read(32);
+    std::memcpy(&out[0], &bits, sizeof(float));
+    int leading = 0, trailing = 0;
+
+    for (std::size_t i = 1; i < count; i++) {
+        if (reader.readBit()) {
+            if (reader.readBit()) {
+                leading = static_cast<int>(reader.read(5));
+                int length = static_cast<int>(reader.read(5)) + 1;
+                trailing = 32 - leading - length;
+                if (trailing < 0) return false;
+            }
+            bits ^= reader.read(32 - leading - trailing) << trailing;
+        }
+        std::memcpy(&out[i], &bits, sizeof(float));
+    }
+    return !reader.overrun();
+}
+
+bool decodeQuantized(const uint8_t* data, std::size_t size, std::size_t count, float resolution, float* out) {
+    BitReader reader(data, size);
+    int32_t value = static_cast<int32_t>(reader.read(32));
+    out[0] = static_cast<float>(value) * resolution;
+
+    for (std::size_t i = 1; i < count; i += SensorBlockEncoder::GROUP) {
+        std::size_t end = std::min(count, i + SensorBlockEncoder::GROUP);
+        int width = static_cast<int>(reader.read(6));
+        if (width > 32) return false;
+        if (width == 0) {
+            std::fill(out + i, out + end, static_cast<float>(value) * resolution);
+            continue;
+        }
+        for (std::size_t j = i; j < end; j++) {
+            value += unzigzag(reader.read(width));
+            out[j] = static_cast<float>(value) * resolution;
+        }
+    }
+    return !reader.overrun();
+}
+
+} // namespace
+
+std::size_t SensorBlockDecoder::decode(const uint8_t* data, std::size_t size, SensorBlock& block) {
+    constexpr std::size_t headerBytes = SensorBlockEncoder::HEADER_BYTES;
+    if (size < headerBytes || data[0] > static_cast<uint8_t>(SensorType::Gyro) ||
+        data[1] > static_cast<uint8_t>(ValueCoding::QuantizedDelta)) {
+        return 0;
+    }
+
+    uint16_t count;
+    float resolution;
+    uint32_t columnBytes[4];
+    std::memcpy(&count, data + 2, sizeof(count));
+    std::memcpy(&resolution, data + 4, sizeof(resolution));
+    std::memcpy(columnBytes, data + 8, sizeof(columnBytes));
+    ValueCoding coding = static_cast<ValueCoding>(data[1]);
+
+    std::size_t total = headerBytes;
+    for (uint32_t bytes : columnBytes) {
+        if (bytes > maxColumnBytes(count)) return 0;
+        total += bytes;
+    }
+    if (count == 0 || total > size) return 0;
+
+    block.type = static_cast<SensorType>(data[0]);
+    block.count = count;
+    block.timestamps.resize(count);
+    block.x.resize(count);
+    block.y.resize(count);
+    block.z.resize(count);
+
+    const uint8_t* column = data + headerBytes;
+    float* axes[3] = {block.x.data(), block.y.data(), block.z.data()};
+    bool ok = decodeTimestamps(column, columnBytes[0], count, block.timestamps.data());
+    column += columnBytes[0];
+    for (int axis = 0; axis < 3 && ok; axis++) {
+        ok = (coding == ValueCoding::Xor)
+            ? decodeXor(column, columnBytes[axis + 1], count, axes[axis])
+            : decodeQuantized(column, columnBytes[axis + 1], count, resolution, axes[axis]);
+        column += columnBytes[axis + 1];
+    }
+    return ok ? total : 0;
+}
@@ -0,0 +1,138 @@
+#include <cstring>
+#include <iostream>
+
+#include "storage/SensorRecorder.h"
+
+namespace {
+
+float resolutionFor(SensorType type) {
+    switch (type) {
+        case SensorType::Mag: return recordMagResolution;
+        case SensorType::Accel: return recordAccelResolution;
+        case SensorType::Gyro: return recordGyroResolution;
+    }
+    return 0.0f;
+}
+
+} // namespace
+
+SensorRecorder::~SensorRecorder() {
+    stop();
+}
+
+bool SensorRecorder::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (recording_) return false;
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        std::cerr << "[Recorder] Could not open " << path << std::endl;
+        return false;
+    }
+    uint8_t header[RecordingFormat::HEADER_BYTES];
+    std::memcpy(header, RecordingFormat::MAGIC, 4);
+    std::memcpy(header + 4, &RecordingFormat::VERSION, 4);
+    file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (int i = 0; i < 3; i++) {
+        SensorType type = static_cast<SensorType>(i);
+        encoders_[i] = std::make_unique<SensorBlockEncoder>(type, resolutionFor(type));
+    }
+    stats_ = Stats();
+    stats_.recording = true;
+    stats_.path = path;
+    stats_.encodedBytes = sizeof(header);
+    recording_ = true;
+
+    std::cout << "[Recorder] Recording to " << path << std::endl;
+    return true;
+}
+
+void SensorRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!recording_) return;
+    recording_ = false;
+
+    // Partial blocks are written out so nothing recorded is lost
+    for (std::unique_ptr<SensorBlockEncoder>& encoder : encoders_) {
+        writeBlock(*encoder);
+    }
+    file_.close();
+    stats_.recording = false;
+
+    std::cout << "[Recorder] Stopped: " << stats_.samples << " samples, " << stats_.encodedBytes << " bytes ("
+              << (stats_.encodedBytes > 0 ? static_cast<double>(stats_.rawBytes) / stats_.encodedBytes : 0.0)
+              << "x)" << std::endl;
+}
+
+void SensorRecorder::record(const SensorSample& sample) {
+    if (!isRecording()) return;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!recording_) return;
+    SensorBlockEncoder& encoder = *encoders_[static_cast<int>(sample.type)];
+    encoder.append(static_cast<float>(sample.timestamp), sample.x, sample.y, sample.z);
+    stats_.samples++;
+    stats_.rawBytes += 4 * sizeof(float);
+    if (encoder.count() >= recordBlockSamples) {
+        writeBlock(encoder);
+    }
+}
+
+SensorRecorder::Stats SensorRecorder::getStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+void SensorRecorder::writeBlock(SensorBlockEncoder& encoder) {
+    block_.clear();
+    encoder.finish(block_);
+    if (block_.empty()) return;
+    file_.write(reinterpret_cast<const char*>(block_.data()), block_.size());
+    stats_.encodedBytes += block_.size();
+}
+
+bool RecordingReader::open(const std::string& path) {
+    file_.open(path, std::ios::binary);
+    if (!file_) {
+        std::cerr << "[Recorder] Could not open " << path << std::endl;
+        return false;
+    }
+
+    uint8_t header[RecordingFormat::HEADER_BYTES];
+    uint32_t version = 0;
+    file_.read(reinterpret_cast<char*>(header), sizeof(header));
+    std::memcpy(&version, header + 4, 4);
+    if (!file_ || std::memcmp(header, RecordingFormat::MAGIC, 4) != 0 || version != RecordingFormat::VERSION) {
+        std::cerr << "[Recorder] " << path << " is not a version " << RecordingFormat::VERSION << " recording" << std::endl;
+        return false;
+    }
+    fileBytes_ = sizeof(header);
+    return true;
+}
+
+bool RecordingReader::next(SensorBlock& block) {
+    constexpr std::size_t headerBytes = SensorBlockEncoder::HEADER_BYTES;
+    buffer_.resize(headerBytes);
+    if (!file_.read(reinterpret_cast<char*>(buffer_.data()), headerBytes)) return false;
+
+    // The block header holds the sample count and ends with the four column sizes. A damaged
+    // header must not size the read buffer beyond what the count allows
+    uint16_t count;
+    uint32_t columnBytes[4];
+    std::memcpy(&count, buffer_.data() + 2, sizeof(count));
+    std::memcpy(columnBytes, buffer_.data() + headerBytes - sizeof(columnBytes), sizeof(columnBytes));
+    std::size_t total = headerBytes;
+    for (uint32_t bytes : columnBytes) {
+        if (bytes > SensorBlockDecoder::maxColumnBytes(count)) {
+            std::cerr << "[Recorder] Damaged block at byte " << fileBytes_ << std::endl;
+            return false;
+        }
+        total += bytes;
+    }
+    buffer_.resize(total);
+    if (!file_.read(reinterpret_cast<char*>(buffer_.data() + headerBytes), total - headerBytes)) return false;
+
+    fileBytes_ += total;
+    return SensorBlockDecoder::decode(buffer_.data(), total, block) == total;
+}
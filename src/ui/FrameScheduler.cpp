@@ -0,0 +1,79 @@
+#include "ui/FrameScheduler.h"
+#include "raylib.h"
+
+#include <cmath>
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer,
+                               const Structs3D::QuaternionF& attitude)
+    : m_gyroBuffer(gyroBuffer), m_accelBuffer(accelBuffer), m_magBuffer(magBuffer), m_attitude(attitude) {}
+
+// Member function BeginFrame: call once per loop iteration before drawing
+void FrameScheduler::BeginFrame() {
+    double now = GetTime();
+
+    // Any new sample, input event or attitude change keeps the loop at full rate for a short hold time
+    bool newSamples = HasNewSamples();
+    if (newSamples || HasInput() || IsSceneDirty()) {
+        m_lastActivityTime = now;
+    }
+    bool idle = (now - m_lastActivityTime) > activeHoldSeconds;
+
+    // Only touch the raylib frame limiter when the mode changes
+    if (idle != m_idle) {
+        SetTargetFPS(idle ? idleFPS : targetFPS);
+        m_idle = idle;
+    }
+
+    if (m_idle) {
+        m_stats.idleFrames++;
+        m_stats.skippedFrames += std::max(0, targetFPS / idleFPS - 1);
+    } else {
+        m_stats.activeFrames++;
+    }
+}
+
+bool FrameScheduler::IsSceneDirty() const {
+    return !m_sceneRendered || AttitudeChangeDeg() > attitudeRedrawThresholdDeg;
+}
+
+void FrameScheduler::MarkSceneRendered() {
+    m_renderedAttitude = m_attitude;
+    m_sceneRendered = true;
+    m_stats.sceneRenders++;
+}
+
+void FrameScheduler::MarkSceneReused() {
+    m_stats.sceneRendersSkipped++;
+}
+
+bool FrameScheduler::HasNewSamples() {
+    std::size_t gyroWrites = m_gyroBuffer.getWriteCount();
+    std::size_t accelWrites = m_accelBuffer.getWriteCount();
+    std::size_t magWrites = m_magBuffer.getWriteCount();
+
+    bool changed = gyroWrites != m_gyroWrites || accelWrites != m_accelWrites || magWrites != m_magWrites;
+
+    m_gyroWrites = gyroWrites;
+    m_accelWrites = accelWrites;
+    m_magWrites = magWrites;
+    return changed;
+}
+
+bool FrameScheduler::HasInput() const {
+    Vector2 mouseDelta = GetMouseDelta();
+    if (mouseDelta.x != 0.0f || mouseDelta.y != 0.0f) return true;
+    if (GetMouseWheelMove() != 0.0f) return true;
+    if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) || IsMouseButtonDown(MOUSE_BUTTON_RIGHT) || IsMouseButtonDown(MOUSE_BUTTON_MIDDLE)) return true;
+    if (GetKeyPressed() != 0) return true;
+    if (IsWindowResized()) return true;
+    return false;
+}
+
+float FrameScheduler::AttitudeChangeDeg() const {
+    // Angle between the rendered and current attitude, ignoring the q/-q sign ambiguity
+    float dot = m_renderedAttitude.w * m_attitude.w + m_renderedAttitude.x * m_attitude.x +
+                m_renderedAttitude.y * m_attitude.y + m_renderedAttitude.z * m_attitude.z;
+    dot = std::min(1.0f, std::abs(dot));
+    return 2.0f * std::acos(dot) * (180.0f / PI);
+}
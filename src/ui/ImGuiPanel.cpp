@@ -1,11 +1,27 @@
 #include "ui/ImGuiPanel.h"
 #include "ComplementaryFilter.h"
+#include "implot.h"
 
 ImGuiPanel::ImGuiPanel(int posX, int posY, int width, int height, 
                        Structs3D::QuaternionF& attitude, 
-                       ComplementaryFilter& complementaryFilter)
+                       ComplementaryFilter& complementaryFilter,
+                       const FrameScheduler& scheduler,
+                       AttitudePredictor& predictor,
+                       AllanCapture& allanCapture,
+                       TriggerCapture& triggerCapture,
+                       Prefilter& prefilter,
+                       SensorRecorder& recorder,
+                       const ClockSync& clockSync,
+                       const PerformanceMonitor& perfMonitor,
+                       const FilterCheckpointer& checkpointer)
     : m_posX(posX), m_posY(posY), m_width(width), m_height(height), 
-      attitude_(attitude), filter_(complementaryFilter) {}
+      attitude_(attitude), filter_(complementaryFilter), scheduler_(scheduler), predictor_(predictor),
+      allanCapture_(allanCapture), triggerCapture_(triggerCapture), prefilter_(prefilter), recorder_(recorder), clockSync_(clockSync),
+      perfMonitor_(perfMonitor), checkpointer_(checkpointer) {
+    for (int i = 0; i < 3; i++) {
+        prefilterChains_[i] = prefilter_.getChain(static_cast<SensorType>(i));
+    }
+}
 
 void ImGuiPanel::Draw() {
     ImGui::SetNextWindowPos(ImVec2(m_posX, m_posY), ImGuiCond_Always);
@@ -20,6 +36,19 @@ void ImGuiPanel::Draw() {
     if (ImGui::CollapsingHeader("Quaternion Values", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::Indent();
         ImGui::Text("W: %.3f X: %.3f Y: %.3f Z: %.3f", attitude_.w, attitude_.x, attitude_.y, attitude_.z);
+        const ComplementaryFilter::AlignmentStatus& alignment = filter_.getAlignmentStatus();
+        if (alignment.aligned) {
+            ImGui::Text("Aligned in %.2f s (wall %.2f s), gyro bias %s, attitude %s", alignment.timeToAlign, alignment.hostTimeToAlign,
+                        alignment.gyroBiasRestored ? "from checkpoint" : alignment.gyroBiasEstimated ? "estimated" : "not estimated",
+                        alignment.attitudeRestored ? "from checkpoint" : "measured");
+        } else {
+            ImGui::Text("Aligning... hold the device still");
+        }
+        const FilterCheckpointer::Status checkpoint = checkpointer_.getStatus();
+        if (!checkpoint.deviceId.empty()) {
+            ImGui::Text("Checkpoint %s: %s", checkpoint.deviceId.c_str(), checkpoint.restore.c_str());
+            ImGui::Text("Saves: %llu%s", static_cast<unsigned long long>(checkpoint.saves), checkpoint.saveFailed ? " (last save failed)" : "");
+        }
         ImGui::Unindent();
     }
             
@@ -61,6 +90,241 @@ void ImGuiPanel::Draw() {
         
         ImGui::Unindent();
     }
+
+    // Attitude Prediction Section
+    if (ImGui::CollapsingHeader("Attitude Prediction")) {
+        ImGui::Indent();
+        ImGui::Checkbox("Extrapolate to display time", &predictor_.enabled_);
+        ImGui::SliderFloat("Look-ahead (s)", &predictor_.lookahead_, 0.0f, maxPredictionHorizon, "%.3f");
+        ImGui::Text("Attitude age: %.1f ms  Extrapolated: %.1f ms", predictor_.getAttitudeAge() * 1000.0f,
+                    predictor_.getPredictionHorizon() * 1000.0f);
+        ImGui::Text("Ingestion-to-photon estimate: %.1f ms", (predictor_.getAttitudeAge() + 1.0f / targetFPS) * 1000.0f);
+        ImGui::Unindent();
+    }
+
+    // Device Clock Section
+    if (ImGui::CollapsingHeader("Device Clock")) {
+        ImGui::Indent();
+        const ClockSync::Stats clock = clockSync_.getStats();
+        if (!clock.active) {
+            ImGui::Text("No device timestamps (timestamps from configured rates)");
+        } else {
+            ImGui::Text("Status: %s (%llu messages, %llu restarts, %llu steps)", clock.locked ? "Locked" : "Estimating offset",
+                        static_cast<unsigned long long>(clock.messages), static_cast<unsigned long long>(clock.resets),
+                        static_cast<unsigned long long>(clock.steps));
+            ImGui::Text("Offset: %.4f s  Skew: %+.1f ppm", clock.offset, clock.skewPpm);
+            ImGui::Text("Error bound: %.2f ms  Steering: %.2f ms", clock.errorBound * 1000.0, clock.steering * 1000.0);
+            ImGui::Text("Transport latency: %.1f ms", clock.transportLatency * 1000.0f);
+            ImGui::Text("End-to-end latency: %.1f ms (max %.1f ms)", clock.endToEndLatency * 1000.0f, clock.endToEndMax * 1000.0f);
+            ImGui::TextDisabled("Latencies exclude the fixed minimum path delay");
+        }
+        ImGui::Unindent();
+    }
+
+    // Magnetometer Calibration Section
+    if (ImGui::CollapsingHeader("Magnetometer Calibration")) {
+        ImGui::Indent();
+        const MagCalibrator::Status cal = filter_.magCalibrator_.getStatus();
+        ImGui::Text("Status: %s (%zu samples)", cal.valid ? "Converged" : "Collecting", cal.samples);
+        ImGui::Text("Coverage: %.0f%%  Residual: %.2f%%", cal.coverage * 100.0f, cal.residual * 100.0f);
+        ImGui::Text("Field: %.1f uT", cal.fieldStrength);
+        ImGui::Text("Offset: %.1f, %.1f, %.1f uT", cal.offset.x, cal.offset.y, cal.offset.z);
+        bool applyCorrection = filter_.magCalibrationEnabled_.load(std::memory_order_relaxed);
+        if (ImGui::Checkbox("Apply correction", &applyCorrection)) {
+            filter_.magCalibrationEnabled_.store(applyCorrection, std::memory_order_relaxed);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset Calibration")) {
+            filter_.magCalibrator_.requestReset();
+        }
+        ImGui::Unindent();
+    }
+
+    // Prefilter Section
+    if (ImGui::CollapsingHeader("Prefilter")) {
+        ImGui::Indent();
+        const char* sensors[3] = {"Mag", "Accel", "Gyro"};
+        const char* types[3] = {"Off", "Low-pass", "Notch"};
+        for (int i = 0; i < 3; i++) {
+            if (!ImGui::TreeNode(sensors[i])) continue;
+            SensorType sensor = static_cast<SensorType>(i);
+            float nyquist = prefilter_.sampleRate(sensor) / 2.0f;
+            bool changed = false;
+            for (int s = 0; s < prefilterSections; s++) {
+                Prefilter::Section& section = prefilterChains_[i][s];
+                ImGui::PushID(s);
+                int type = static_cast<int>(section.type);
+                ImGui::SetNextItemWidth(90);
+                if (ImGui::Combo("##Type", &type, types, 3)) {
+                    section.type = static_cast<Prefilter::SectionType>(type);
+                    changed = true;
+                }
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(140);
+                changed |= ImGui::SliderFloat("Hz", &section.frequency, 0.5f, nyquist * 0.98f, "%.1f");
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(100);
+                changed |= ImGui::SliderFloat("Q", &section.q, 0.1f, 20.0f, "%.2f");
+                ImGui::PopID();
+            }
+            if (changed) {
+                prefilter_.setChain(sensor, prefilterChains_[i]);
+            }
+            ImGui::TreePop();
+        }
+        ImGui::Unindent();
+    }
+
+    // Recording Section
+    if (ImGui::CollapsingHeader("Recording")) {
+        ImGui::Indent();
+        const SensorRecorder::Stats stats = recorder_.getStats();
+        if (stats.recording) {
+            if (ImGui::Button("Stop Recording")) {
+                recorder_.stop();
+            }
+            ImGui::Text("Writing %s", stats.path.c_str());
+        } else {
+            ImGui::InputText("File", recordingPath_, sizeof(recordingPath_));
+            if (ImGui::Button("Start Recording")) {
+                recorder_.start(recordingPath_);
+            }
+        }
+        double ratio = stats.encodedBytes > 0 ? static_cast<double>(stats.rawBytes) / stats.encodedBytes : 0.0;
+        ImGui::Text("Samples: %llu  Size: %.2f MB (%.1fx smaller than raw)",
+                    static_cast<unsigned long long>(stats.samples), stats.encodedBytes / 1.0e6, ratio);
+        ImGui::Unindent();
+    }
+
+    // Noise Characterization Section
+    if (ImGui::CollapsingHeader("Noise Characterization")) {
+        ImGui::Indent();
+        if (allanCapture_.isRunning()) {
+            if (ImGui::Button("Stop Capture")) {
+                allanCapture_.stop();
+            }
+        } else if (ImGui::Button("Start Capture (keep device still)")) {
+            allanCapture_.start();
+        }
+        const AllanCapture::Result result = allanCapture_.getResult();
+        ImGui::Text("Captured: %.0f s  Missed samples: %llu", result.seconds,
+                    static_cast<unsigned long long>(result.missedSamples));
+        const char* axes[3] = {"X", "Y", "Z"};
+        if (ImGui::BeginTable("AllanGyro", 4, ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Gyro");
+            ImGui::TableSetupColumn("ARW (rad/s/rtHz)");
+            ImGui::TableSetupColumn("BI (rad/s)");
+            ImGui::TableSetupColumn("RRW (rad/s2/rtHz)");
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < 3; i++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", axes[i]);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.gyro[i].randomWalk);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.gyro[i].biasInstability);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.gyro[i].rateRandomWalk);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::BeginTable("AllanAccel", 4, ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Accel");
+            ImGui::TableSetupColumn("VRW (g/rtHz)");
+            ImGui::TableSetupColumn("BI (g)");
+            ImGui::TableSetupColumn("RRW (g/s/rtHz)");
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < 3; i++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", axes[i]);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.accel[i].randomWalk);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.accel[i].biasInstability);
+                ImGui::TableNextColumn(); ImGui::Text("%.2e", result.accel[i].rateRandomWalk);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::Unindent();
+    }
+
+    // Trigger Capture Section
+    if (ImGui::CollapsingHeader("Trigger Capture")) {
+        ImGui::Indent();
+        if (triggerCapture_.isRunning()) {
+            if (ImGui::Button("Disarm")) {
+                triggerCapture_.stop();
+            }
+        } else if (ImGui::Button("Arm")) {
+            triggerCapture_.start();
+        }
+        const TriggerCapture::Stats stats = triggerCapture_.getStats();
+        const std::vector<TriggerScanner::Rule>& rules = triggerCapture_.getRules();
+        if (stats.gravity > 0.0f) {
+            ImGui::Text("Gravity at alignment: %.3f", stats.gravity);
+        } else {
+            ImGui::Text("Accel rules wait for the filter to align");
+        }
+        for (std::size_t i = 0; i < rules.size(); i++) {
+            ImGui::Text("%s (%s %.2f%s): %llu", rules[i].name.c_str(), rules[i].above ? ">" : "<", rules[i].threshold,
+                        rules[i].perGravity ? " x gravity" : "", static_cast<unsigned long long>(stats.triggers[i]));
+        }
+        ImGui::Text("Captures: %llu%s", static_cast<unsigned long long>(stats.captures), stats.capturing ? " (capturing)" : "");
+        if (!stats.lastCapture.empty()) {
+            ImGui::Text("Last: %s", stats.lastCapture.c_str());
+        }
+        double scanCost = stats.scannedSamples > 0 ? stats.scanNanos / stats.scannedSamples : 0.0;
+        ImGui::Text("Scan: %.1f ns/sample  Missed samples: %llu", scanCost,
+                    static_cast<unsigned long long>(stats.missedSamples));
+        ImGui::Unindent();
+    }
+
+    // Frame Scheduler Section
+    if (ImGui::CollapsingHeader("Rendering")) {
+        ImGui::Indent();
+        const FrameScheduler::Stats& stats = scheduler_.GetStats();
+        ImGui::Text("Mode: %s (%d FPS)", scheduler_.IsIdle() ? "Idle" : "Active", scheduler_.IsIdle() ? idleFPS : targetFPS);
+        ImGui::Text("Frames active: %zu  idle: %zu  skipped: %zu", stats.activeFrames, stats.idleFrames, stats.skippedFrames);
+        ImGui::Text("Scene renders: %zu  reused: %zu", stats.sceneRenders, stats.sceneRendersSkipped);
+        ImGui::Unindent();
+    }
+
+    // Performance Section
+    if (ImGui::CollapsingHeader("Performance")) {
+        ImGui::Indent();
+        const PerformanceMonitor::Window& perf = perfMonitor_.GetWindow();
+        const SensorRates& rates = filter_.getRates();
+        ImGui::Text("Gyro: %.0f / %.0f Hz  Accel: %.0f / %.0f Hz  Mag: %.0f / %.0f Hz",
+                    perf.sampleRate[static_cast<int>(SensorType::Gyro)], rates.gyro,
+                    perf.sampleRate[static_cast<int>(SensorType::Accel)], rates.accel,
+                    perf.sampleRate[static_cast<int>(SensorType::Mag)], rates.mag);
+        ImGui::Text("Messages: %.0f /s  Resyncs: %llu  Rejected: %llu  Late samples: %llu", perf.messageRate,
+                    static_cast<unsigned long long>(perf.resyncs), static_cast<unsigned long long>(perf.rejected),
+                    static_cast<unsigned long long>(perf.lateDrops));
+        if (perf.reconnects > 0) {
+            ImGui::Text("Reconnects: %llu  Last gap: %.0f ms  Longest: %.0f ms", static_cast<unsigned long long>(perf.reconnects),
+                        perf.lastGap * 1000.0f, perf.longestGap * 1000.0f);
+        }
+        ImGui::Text("Samples missed by buffer readers  gyro: %zu  accel: %zu  mag: %zu", perf.missed[static_cast<int>(SensorType::Gyro)],
+                    perf.missed[static_cast<int>(SensorType::Accel)], perf.missed[static_cast<int>(SensorType::Mag)]);
+        BufferArena::Stats buffers = BufferArena::global().stats();
+        ImGui::Text("Buffer memory: %.1f of %.1f MiB, %s%s", buffers.usedBytes / 1048576.0, buffers.mappedBytes / 1048576.0,
+                    pageModeName(buffers.pages), buffers.prefaulted ? ", prefaulted" : "");
+        if (perf.latencySamples > 0) {
+            ImGui::Text("IO-to-attitude latency  p50: %.2f  p90: %.2f  p99: %.2f  max: %.2f ms",
+                        perf.latencyP50 * 1000.0f, perf.latencyP90 * 1000.0f, perf.latencyP99 * 1000.0f, perf.latencyMax * 1000.0f);
+        } else {
+            ImGui::Text("IO-to-attitude latency: no samples");
+        }
+
+        // Frame costs stacked scene / ImPlot / ImGui, with the full frame interval for reference
+        if (ImPlot::BeginPlot("Frame Time", ImVec2(-1, 160), ImPlotFlags_NoTitle | ImPlotFlags_NoMouseText)) {
+            ImPlot::SetupAxes(nullptr, "ms", ImPlotAxisFlags_NoTickLabels, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetupAxisLimits(ImAxis_X1, 0, perfFrameHistory, ImGuiCond_Always);
+            int offset = perfMonitor_.GetHistoryOffset();
+            ImPlot::PlotShaded("ImGui", perfMonitor_.GetGuiHistory(), perfFrameHistory, 0.0, 1.0, 0.0, 0, offset);
+            ImPlot::PlotShaded("ImPlot", perfMonitor_.GetPlotsHistory(), perfFrameHistory, 0.0, 1.0, 0.0, 0, offset);
+            ImPlot::PlotShaded("Scene", perfMonitor_.GetSceneHistory(), perfFrameHistory, 0.0, 1.0, 0.0, 0, offset);
+            ImPlot::PlotLine("Frame interval", perfMonitor_.GetIntervalHistory(), perfFrameHistory, 1.0, 0.0, 0, offset);
+            ImPlot::EndPlot();
+        }
+        ImGui::Unindent();
+    }
         
     ImGui::PopStyleVar();
     }
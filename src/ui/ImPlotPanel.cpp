@@ -7,14 +7,16 @@ ImPlotPanel::ImPlotPanel(
   const MagBuffer& magDataBuffer,
   const GyroTimesBuffer& gyroTimeBuffer,
   const AccelTimesBuffer& accelTimeBuffer,
-  const MagTimesBuffer& magTimeBuffer
+  const MagTimesBuffer& magTimeBuffer,
+  SpectrumAnalyzer& spectrumAnalyzer
                         )
                         :
   m_posX(posX), m_posY(posY), m_width(width), m_height(height),
   m_vertical_zoom(1.0f), m_horizontal_zoom(1.0f),
   m_gyroPlot("Gyro", gyroDataBuffer, gyroTimeBuffer, -5.1f, 5.1f),
   m_accelPlot("Accel", accelDataBuffer, accelTimeBuffer, -2.1f, 1.1f),
-  m_magPlot("Mag", magDataBuffer, magTimeBuffer, -90.0f, 90.0f) 
+  m_magPlot("Mag", magDataBuffer, magTimeBuffer, -90.0f, 90.0f),
+  m_spectrumAnalyzer(spectrumAnalyzer), m_show_spectrum(false)
 {}
 
 void ImPlotPanel::Draw() {
@@ -50,6 +52,15 @@ void ImPlotPanel::Draw() {
     if (ImGui::Button("Reset Time Zoom")) {
         m_horizontal_zoom = 1.0f;
     }
+
+    // Spectrum toggle
+    if (ImGui::Checkbox("Vibration Spectrum", &m_show_spectrum)) {
+        if (m_show_spectrum) {
+            m_spectrumAnalyzer.start();
+        } else {
+            m_spectrumAnalyzer.stop();
+        }
+    }
     
     ImGui::EndGroup();
     ImGui::Separator();
@@ -60,12 +71,36 @@ void ImPlotPanel::Draw() {
     const float total_plots_height = content_height * m_vertical_zoom;
     const float plot_height = total_plots_height / 3.0f;
 
-    // Draw plots
-    m_gyroPlot.Draw(plot_height, m_horizontal_zoom);
-    ImGui::Dummy(ImVec2(0, ImGui::GetStyle().ItemSpacing.y));
-    m_accelPlot.Draw(plot_height, m_horizontal_zoom);
-    ImGui::Dummy(ImVec2(0, ImGui::GetStyle().ItemSpacing.y));
-    m_magPlot.Draw(plot_height, m_horizontal_zoom);
+    if (m_show_spectrum) {
+        m_spectrumAnalyzer.getGyroSpectrum(m_gyroSpectrum);
+        m_spectrumAnalyzer.getAccelSpectrum(m_accelSpectrum);
+        const float spectrum_height = total_plots_height / 2.0f;
+        DrawSpectrum("Gyro Spectrum", m_gyroSpectrum, spectrum_height);
+        ImGui::Dummy(ImVec2(0, ImGui::GetStyle().ItemSpacing.y));
+        DrawSpectrum("Accel Spectrum", m_accelSpectrum, spectrum_height);
+    } else {
+        // Draw plots
+        m_gyroPlot.Draw(plot_height, m_horizontal_zoom);
+        ImGui::Dummy(ImVec2(0, ImGui::GetStyle().ItemSpacing.y));
+        m_accelPlot.Draw(plot_height, m_horizontal_zoom);
+        ImGui::Dummy(ImVec2(0, ImGui::GetStyle().ItemSpacing.y));
+        m_magPlot.Draw(plot_height, m_horizontal_zoom);
+    }
 
     ImGui::End();
-}
\ No newline at end of file
+}
+
+void ImPlotPanel::DrawSpectrum(const char* name, const SpectrumAnalyzer::Spectrum& spectrum, float height) const {
+    if (ImPlot::BeginPlot(name, ImVec2(-1, height))) {
+        ImPlot::SetupAxes("Frequency (Hz)", "Density (/rtHz)");
+        ImPlot::SetupAxisScale(ImAxis_Y1, ImPlotScale_Log10);
+        if (!spectrum.frequencies.empty()) {
+            ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, spectrum.frequencies.back(), ImGuiCond_Once);
+            const int bins = static_cast<int>(spectrum.frequencies.size());
+            ImPlot::PlotLine("X", spectrum.frequencies.data(), spectrum.density[0].data(), bins);
+            ImPlot::PlotLine("Y", spectrum.frequencies.data(), spectrum.density[1].data(), bins);
+            ImPlot::PlotLine("Z", spectrum.frequencies.data(), spectrum.density[2].data(), bins);
+        }
+        ImPlot::EndPlot();
+    }
+}
@@ -0,0 +1,68 @@
+#include "ui/PerformanceMonitor.h"
+#include "raylib.h"
+
+PerformanceMonitor::PerformanceMonitor(const IngestStats& ingestStats,
+                                       const GyroBuffer& gyroBuffer, const AccelBuffer& accelBuffer, const MagBuffer& magBuffer)
+    : m_ingestStats(ingestStats), m_gyroBuffer(gyroBuffer), m_accelBuffer(accelBuffer), m_magBuffer(magBuffer),
+      m_previous(ingestStats.snapshot()) {}
+
+void PerformanceMonitor::BeginFrame() {
+    double now = GetTime();
+    if (m_frameStart > 0.0) {
+        m_interval[m_historyIndex] = static_cast<float>((now - m_frameStart) * 1000.0);
+        m_historyIndex = (m_historyIndex + 1) % perfFrameHistory;
+    }
+    m_frameStart = now;
+    UpdateWindow(now);
+}
+
+void PerformanceMonitor::MarkScene() {
+    m_sceneTop[m_historyIndex] = static_cast<float>((GetTime() - m_frameStart) * 1000.0);
+}
+
+void PerformanceMonitor::MarkPlots() {
+    m_plotsTop[m_historyIndex] = static_cast<float>((GetTime() - m_frameStart) * 1000.0);
+}
+
+void PerformanceMonitor::MarkGui() {
+    m_guiTop[m_historyIndex] = static_cast<float>((GetTime() - m_frameStart) * 1000.0);
+}
+
+// Rates and latency percentiles over the last window, from the difference of two snapshots
+void PerformanceMonitor::UpdateWindow(double now) {
+    if (m_windowStart == 0.0) m_windowStart = now;
+    double elapsed = now - m_windowStart;
+    if (elapsed < perfWindowSeconds) return;
+
+    IngestStats::Snapshot current = m_ingestStats.snapshot();
+    for (int s = 0; s < 3; s++) {
+        m_window.sampleRate[s] = static_cast<float>((current.samples[s] - m_previous.samples[s]) / elapsed);
+    }
+    m_window.messageRate = static_cast<float>((current.messages - m_previous.messages) / elapsed);
+    m_window.resyncs = current.resyncs;
+    m_window.rejected = current.rejected;
+    m_window.lateDrops = current.lateDrops;
+    m_window.reconnects = current.reconnects;
+    m_window.lastGap = current.lastGapMicros / 1e6f;
+    m_window.longestGap = current.longestGapMicros / 1e6f;
+    m_window.missed[static_cast<int>(SensorType::Mag)] = m_magBuffer.getMissedCount();
+    m_window.missed[static_cast<int>(SensorType::Accel)] = m_accelBuffer.getMissedCount();
+    m_window.missed[static_cast<int>(SensorType::Gyro)] = m_gyroBuffer.getMissedCount();
+
+    uint64_t latency[IngestStats::LATENCY_BUCKETS];
+    uint64_t total = 0;
+    int highest = -1;
+    for (int b = 0; b < IngestStats::LATENCY_BUCKETS; b++) {
+        latency[b] = current.latency[b] - m_previous.latency[b];
+        total += latency[b];
+        if (latency[b] > 0) highest = b;
+    }
+    m_window.latencySamples = total;
+    m_window.latencyP50 = static_cast<float>(IngestStats::percentile(latency, 0.5));
+    m_window.latencyP90 = static_cast<float>(IngestStats::percentile(latency, 0.9));
+    m_window.latencyP99 = static_cast<float>(IngestStats::percentile(latency, 0.99));
+    m_window.latencyMax = highest >= 0 ? static_cast<float>(IngestStats::bucketUpperSeconds(highest)) : 0.0f;
+
+    m_previous = current;
+    m_windowStart = now;
+}
@@ -1,7 +1,88 @@
 #include "ui/RayLibScene.h"
 #include "raylib.h"
 #include "raymath.h"
-#include "rlgl.h"
+
+namespace {
+    // Axis-aligned box used to build line-like geometry (grid lines, cube edges) as solid triangles
+    struct Box {
+        Vector3 min;
+        Vector3 max;
+    };
+
+    // Build a single mesh out of many boxes and upload it once. Triangles are wound CCW when seen from outside
+    Mesh GenMeshBoxes(const std::vector<Box>& boxes) {
+        static const unsigned short faceIndices[36] = {
+            0, 4, 6, 0, 6, 2,   // -X
+            1, 3, 7, 1, 7, 5,   // +X
+            0, 1, 5, 0, 5, 4,   // -Y
+            2, 6, 7, 2, 7, 3,   // +Y
+            0, 2, 3, 0, 3, 1,   // -Z
+            4, 5, 7, 4, 7, 6    // +Z
+        };
+
+        Mesh mesh = {};
+        mesh.vertexCount = (int)boxes.size() * 8;
+        mesh.triangleCount = (int)boxes.size() * 12;
+        mesh.vertices = (float*)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+        mesh.indices = (unsigned short*)MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+
+        for (size_t b = 0; b < boxes.size(); b++) {
+            const Box& box = boxes[b];
+            // Corner i takes max on X/Y/Z where bit 0/1/2 of i is set
+            for (int i = 0; i < 8; i++) {
+                float* v = mesh.vertices + (b * 8 + i) * 3;
+                v[0] = (i & 1) ? box.max.x : box.min.x;
+                v[1] = (i & 2) ? box.max.y : box.min.y;
+                v[2] = (i & 4) ? box.max.z : box.min.z;
+            }
+            for (int i = 0; i < 36; i++) {
+                mesh.indices[b * 36 + i] = (unsigned short)(b * 8 + faceIndices[i]);
+            }
+        }
+
+        UploadMesh(&mesh, false);
+        return mesh;
+    }
+
+    // Same layout as raylib's DrawGrid(slices, spacing), but in the X-Y plane
+    std::vector<Box> GridBoxes(int slices, float spacing, float thickness, bool centerLines) {
+        std::vector<Box> boxes;
+        int halfSlices = slices / 2;
+        float extent = halfSlices * spacing;
+        float t = thickness * 0.5f;
+
+        for (int i = -halfSlices; i <= halfSlices; i++) {
+            if ((i == 0) != centerLines) continue;
+            float p = i * spacing;
+            boxes.push_back({ Vector3{ -extent, p - t, -t }, Vector3{ extent, p + t, t } });   // Parallel to X
+            boxes.push_back({ Vector3{ p - t, -extent, -t }, Vector3{ p + t, extent, t } });   // Parallel to Y
+        }
+        return boxes;
+    }
+
+    // The 12 edges of a centered width x height x depth cuboid
+    std::vector<Box> CuboidEdgeBoxes(float width, float height, float depth, float thickness) {
+        std::vector<Box> boxes;
+        float hx = width * 0.5f, hy = height * 0.5f, hz = depth * 0.5f, t = thickness * 0.5f;
+
+        for (float sy : { -hy, hy }) {
+            for (float sz : { -hz, hz }) {
+                boxes.push_back({ Vector3{ -hx - t, sy - t, sz - t }, Vector3{ hx + t, sy + t, sz + t } });   // Along X
+            }
+        }
+        for (float sx : { -hx, hx }) {
+            for (float sz : { -hz, hz }) {
+                boxes.push_back({ Vector3{ sx - t, -hy - t, sz - t }, Vector3{ sx + t, hy + t, sz + t } });   // Along Y
+            }
+        }
+        for (float sx : { -hx, hx }) {
+            for (float sy : { -hy, hy }) {
+                boxes.push_back({ Vector3{ sx - t, sy - t, -hz - t }, Vector3{ sx + t, sy + t, hz + t } });   // Along Z
+            }
+        }
+        return boxes;
+    }
+}
 
 // Constructor
 RaylibScene::RaylibScene(int originX, int originY, int width, int height, const Structs3D::QuaternionF& attitude, const Structs3D::Vector3F& accelVector)
@@ -9,8 +90,15 @@ RaylibScene::RaylibScene(int originX, int originY, int width, int height, const
 
 // Destructor
 RaylibScene::~RaylibScene() {
-    // Unload render texture when the scene is destroyed
+    // Unload render texture and GPU meshes when the scene is destroyed
     UnloadRenderTexture(m_renderTarget);
+    UnloadMesh(m_cylinderMesh);
+    UnloadMesh(m_sphereMesh);
+    UnloadMesh(m_deviceMesh);
+    UnloadMesh(m_deviceEdgesMesh);
+    UnloadMesh(m_gridMesh);
+    UnloadMesh(m_gridCenterMesh);
+    UnloadMaterial(m_material);
 }
 
 // Member function Init
@@ -24,73 +112,75 @@ void RaylibScene::Init() {
     
     // Create render texture with the dimensions of the 3D scene area
     m_renderTarget = LoadRenderTexture(m_sceneWidth, m_sceneHeight);
+
+    // Generate and upload all geometry once. GenMesh* functions upload to the GPU themselves
+    m_cylinderMesh = GenMeshCylinder(1.0f, 1.0f, 16);   // Unit cylinder along +Y, scaled per arrow
+    m_sphereMesh = GenMeshSphere(1.0f, 8, 12);          // Unit sphere, scaled per arrow tip
+    m_material = LoadMaterialDefault();
+
+    // Device dimensions (in world units)
+    float width = 3.0f;   // X dimension
+    float height = 6.0f;  // Y dimension  
+    float depth = 0.4f;   // Z dimension (thickness)
+    m_deviceMesh = GenMeshCube(width, height, depth);
+    m_deviceEdgesMesh = GenMeshBoxes(CuboidEdgeBoxes(width, height, depth, 0.03f));
+
+    // Grid on X-Y plane
+    m_gridMesh = GenMeshBoxes(GridBoxes(25, 1.0f, 0.02f, false));
+    m_gridCenterMesh = GenMeshBoxes(GridBoxes(25, 1.0f, 0.02f, true));
+
+    // World items: grid and coordinate axes
+    m_worldItems.push_back({ &m_gridMesh, MatrixIdentity(), LIGHTGRAY });
+    m_worldItems.push_back({ &m_gridCenterMesh, MatrixIdentity(), GRAY });
+
+    float axisRadius = 0.15f;    // Thickness of the axes
+    float axisLength = 10.0f;
+    AddArrow(m_worldItems, Vector3{ 1.0f, 0.0f, 0.0f }, axisLength, axisRadius, 0.0f, RED);     // X-axis
+    AddArrow(m_worldItems, Vector3{ 0.0f, 1.0f, 0.0f }, axisLength, axisRadius, 0.0f, GREEN);   // Y-axis
+    AddArrow(m_worldItems, Vector3{ 0.0f, 0.0f, 1.0f }, axisLength, axisRadius, 0.0f, BLUE);    // Z-axis
+
+    // Body items: device and body-fixed vectors (these rotate with the device)
+    m_bodyItems.push_back({ &m_deviceMesh, MatrixIdentity(), DARKGRAY });
+    m_bodyItems.push_back({ &m_deviceEdgesMesh, MatrixIdentity(), BLACK });
+
+    float vectorLength = 7.0f;
+    float vectorRadius = 0.10f;
+    AddArrow(m_bodyItems, Vector3{ 0.0f, 1.0f, 0.0f }, vectorLength, vectorRadius, vectorRadius * 2.0f, ORANGE);    // Forward (+Y)
+    AddArrow(m_bodyItems, Vector3{ 1.0f, 0.0f, 0.0f }, vectorLength, vectorRadius, vectorRadius * 2.0f, MAGENTA);   // Right (+X)
+    AddArrow(m_bodyItems, Vector3{ 0.0f, 0.0f, 1.0f }, vectorLength, vectorRadius, vectorRadius * 2.0f, YELLOW);    // Up (+Z)
 }
 
-// Member function Draw
-void RaylibScene::Draw() {
-    // First, render the 3D scene to the render texture
-    BeginTextureMode(m_renderTarget);
-        ClearBackground(WHITE);
-        BeginMode3D(m_camera);
-            // Draw Grid on X-Y plane
-            rlPushMatrix();
-                rlRotatef(90.0f, 1.0f, 0.0f, 0.0f); // Rotate grid to X-Y plane
-                DrawGrid(25, 1.0f);
-            rlPopMatrix();
-            
-            // Draw Coordinate Axes
-            float axisRadius = 0.15f;    // Thickness of the axes
-            int axisSlices = 16;         // More slices = smoother cylinder
-
-            Vector3 origin = {0.0f, 0.0f, 0.0f};
-
-            DrawCylinderEx(origin, Vector3{10.0f, 0.0f, 0.0f}, axisRadius, axisRadius, axisSlices, RED);    // X-axis
-            DrawCylinderEx(origin, Vector3{0.0f, 10.0f, 0.0f}, axisRadius, axisRadius, axisSlices, GREEN);  // Y-axis
-            DrawCylinderEx(origin, Vector3{0.0f, 0.0f, 10.0f}, axisRadius, axisRadius, axisSlices, BLUE);   // Z-axis
-
-            // Draw model with the current attitude
-            rlPushMatrix();
-                const ::Quaternion q = { attitude_.x, attitude_.y, attitude_.z, attitude_.w };
-                Matrix rotMatrix = QuaternionToMatrix(q);
-                
-                rlMultMatrixf(MatrixToFloatV(rotMatrix).v);
-
-                // Device dimensions (in world units)
-                float width = 3.0f;   // X dimension
-                float height = 6.0f;  // Y dimension  
-                float depth = 0.4f;   // Z dimension (thickness)
-
-                // Draw the main body of the device
-                DrawCube(Vector3{0.0f, 0.0f, 0.0f}, width, height, depth, DARKGRAY);
-                DrawCubeWires(Vector3{0.0f, 0.0f, 0.0f}, width, height, depth, BLACK);
-
-                // Draw body-fixed vectors (these rotate with the device)
-                float vectorLength = 7.0f;
-                float vectorRadius = 0.10f;
-                int vectorSlices = 12;
-                
-                Vector3 deviceOrigin = {0.0f, 0.0f, 0.0f};
-                
-                // Forward vector (positive Y in device coordinates - pointing up from the device)
-                Vector3 forwardEnd = {0.0f, vectorLength, 0.0f};
-                DrawCylinderEx(deviceOrigin, forwardEnd, vectorRadius, vectorRadius, vectorSlices, ORANGE);
-                DrawSphere(forwardEnd, vectorRadius * 2.0f, ORANGE);
-                
-                // Right vector (positive X in device coordinates - pointing to the right of the device)
-                Vector3 rightEnd = {vectorLength, 0.0f, 0.0f};
-                DrawCylinderEx(deviceOrigin, rightEnd, vectorRadius, vectorRadius, vectorSlices, MAGENTA);
-                DrawSphere(rightEnd, vectorRadius * 2.0f, MAGENTA);
-                
-                // Up vector (positive Z in device coordinates - pointing out of the screen)
-                Vector3 upEnd = {0.0f, 0.0f, vectorLength};
-                DrawCylinderEx(deviceOrigin, upEnd, vectorRadius, vectorRadius, vectorSlices, YELLOW);
-                DrawSphere(upEnd, vectorRadius * 2.0f, YELLOW);
-
-            rlPopMatrix();
+// Member function AddArrow: a shared unit cylinder (and optional sphere tip) placed along a coordinate axis
+void RaylibScene::AddArrow(std::vector<SceneItem>& items, Vector3 direction, float length, float radius, float tipRadius, Color color) {
+    // The unit cylinder points along +Y, rotate it onto the requested axis
+    Matrix rotation = MatrixIdentity();
+    if (direction.x != 0.0f) rotation = MatrixRotateZ(-90.0f * DEG2RAD);
+    if (direction.z != 0.0f) rotation = MatrixRotateX(90.0f * DEG2RAD);
+
+    Matrix shaft = MatrixMultiply(MatrixScale(radius, length, radius), rotation);
+    items.push_back({ &m_cylinderMesh, shaft, color });
+
+    if (tipRadius > 0.0f) {
+        Vector3 tip = { direction.x * length, direction.y * length, direction.z * length };
+        Matrix tipTransform = MatrixMultiply(MatrixScale(tipRadius, tipRadius, tipRadius), MatrixTranslate(tip.x, tip.y, tip.z));
+        items.push_back({ &m_sphereMesh, tipTransform, color });
+    }
+}
+
+// Member function DrawItems: each item is drawn with its cached local transform in the given frame
+void RaylibScene::DrawItems(const std::vector<SceneItem>& items, Matrix frame) {
+    for (const SceneItem& item : items) {
+        m_material.maps[MATERIAL_MAP_DIFFUSE].color = item.color;
+        DrawMesh(*item.mesh, m_material, MatrixMultiply(item.transform, frame));
+    }
+}
+
+// Member function Draw: re-renders the 3D scene only when requested, then draws the cached texture
+void RaylibScene::Draw(bool renderScene) {
+    if (renderScene) {
+        RenderScene();
+    }
 
-        EndMode3D();
-    EndTextureMode();
-    
     // Now draw the render texture to the screen at the desired position
     // Note: Render textures in raylib are y-flipped, so we need to adjust the source rectangle
     DrawTextureRec(
@@ -100,3 +190,19 @@ void RaylibScene::Draw() {
         WHITE
     );
 }
+
+// Member function RenderScene
+void RaylibScene::RenderScene() {
+    // Render the 3D scene to the render texture
+    BeginTextureMode(m_renderTarget);
+        ClearBackground(WHITE);
+        BeginMode3D(m_camera);
+            // Grid and coordinate axes
+            DrawItems(m_worldItems, MatrixIdentity());
+
+            // Device and body vectors share a single attitude transform per frame
+            const ::Quaternion q = { attitude_.x, attitude_.y, attitude_.z, attitude_.w };
+            DrawItems(m_bodyItems, QuaternionToMatrix(q));
+        EndMode3D();
+    EndTextureMode();
+}
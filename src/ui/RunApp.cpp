@@ -6,8 +6,14 @@
 #include "ui/RayLibScene.h"
 #include "ui/ImPlotPanel.h"
 #include "ui/ImGuiPanel.h"
+#include "ui/FrameScheduler.h"
+#include "ui/PerformanceMonitor.h"
 #include "util/ThreadSafeRingBuffer3D.h"
 #include "ComplementaryFilter.h"
+#include "AttitudePredictor.h"
+#include "AllanCapture.h"
+#include "TriggerCapture.h"
+#include "SpectrumAnalyzer.h"
 
 #include "rlImGui.h"
 #include "imgui.h"
@@ -21,14 +27,23 @@ void runApp(const GyroBuffer &gyroDataBuffer,
             const MagTimesBuffer &magTimeBuffer,
             Structs3D::QuaternionF &estimatedAttitude,
             Structs3D::Vector3F &accelVector,
-            ComplementaryFilter &complementaryFilter) 
+            ComplementaryFilter &complementaryFilter,
+            Prefilter &prefilter,
+            SensorRecorder &recorder,
+            ClockSync &clockSync,
+            const IngestStats &ingestStats,
+            const FilterCheckpointer &checkpointer) 
 { 
   // Initialize window with config values
   InitWindow(screenWidth, screenHeight, "IMU + Attitude Estimation");
   SetTargetFPS(targetFPS);
 
+  // Attitude shown on screen: the estimate extrapolated to the expected display time
+  AttitudePredictor predictor(estimatedAttitude, gyroDataBuffer, gyroTimeBuffer, complementaryFilter);
+  Structs3D::QuaternionF displayedAttitude = estimatedAttitude;
+
   // Initialize Raylib Scene
-  RaylibScene raylibScene(screenWidth/2, screenHeight/2, screenWidth/2, screenHeight/2, estimatedAttitude, accelVector);
+  RaylibScene raylibScene(screenWidth/2, screenHeight/2, screenWidth/2, screenHeight/2, displayedAttitude, accelVector);
   raylibScene.Init();
   
   // Initialize Plots Context
@@ -38,24 +53,56 @@ void runApp(const GyroBuffer &gyroDataBuffer,
   ImGuiIO& io = ImGui::GetIO();
   io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
   // Initialize Plots
+  // Analysis runs at the rates the filter was built with
+  const SensorRates& rates = complementaryFilter.getRates();
+  SpectrumAnalyzer spectrumAnalyzer(gyroDataBuffer, accelDataBuffer, rates);
   ImPlotPanel plotPanel(0, 0, screenWidth/2, screenHeight, 
-                        gyroDataBuffer, accelDataBuffer, magDataBuffer, gyroTimeBuffer, accelTimeBuffer, magTimeBuffer);
+                        gyroDataBuffer, accelDataBuffer, magDataBuffer, gyroTimeBuffer, accelTimeBuffer, magTimeBuffer,
+                        spectrumAnalyzer);
+
+  // Initialize frame scheduler (drops to idleFPS when nothing changes)
+  FrameScheduler scheduler(gyroDataBuffer, accelDataBuffer, magDataBuffer, displayedAttitude);
+
+  // Ingestion and frame-time figures for the performance panel
+  PerformanceMonitor perfMonitor(ingestStats, gyroDataBuffer, accelDataBuffer, magDataBuffer);
+
+  // Static noise characterization, started from the GUI
+  AllanCapture allanCapture(gyroDataBuffer, accelDataBuffer, rates);
+
+  // Shock, free-fall and saturation captures, armed from the start
+  TriggerCapture triggerCapture(gyroDataBuffer, accelDataBuffer, magDataBuffer, gyroTimeBuffer, accelTimeBuffer, magTimeBuffer, complementaryFilter);
+  triggerCapture.start();
 
   // Initialize GUI
-  ImGuiPanel guiPanel(screenWidth/2, 0, screenWidth/2, screenHeight/2, estimatedAttitude, complementaryFilter);
+  ImGuiPanel guiPanel(screenWidth/2, 0, screenWidth/2, screenHeight/2, displayedAttitude, complementaryFilter, scheduler, predictor,
+                      allanCapture, triggerCapture, prefilter, recorder, clockSync, perfMonitor, checkpointer);
   
   // Run Main Loop     
   while (!WindowShouldClose()) {
+    displayedAttitude = predictor.predict();
+    scheduler.BeginFrame();
+    perfMonitor.BeginFrame();
+
     // Draw frame
     BeginDrawing();
     ClearBackground(RAYWHITE);
     
-    raylibScene.Draw();
+    // Only re-render the 3D scene when the attitude moved
+    bool renderScene = scheduler.IsSceneDirty();
+    raylibScene.Draw(renderScene);
+    if (renderScene) {
+      scheduler.MarkSceneRendered();
+    } else {
+      scheduler.MarkSceneReused();
+    }
+    perfMonitor.MarkScene();
       
     rlImGuiBegin();
     plotPanel.Draw();
+    perfMonitor.MarkPlots();
     guiPanel.Draw();
     rlImGuiEnd();
+    perfMonitor.MarkGui();
     
     EndDrawing();
   }
@@ -0,0 +1,153 @@
+#include "util/BufferArena.h"
+
+#include <cstdint>
+#include <iostream>
+
+#include "Config.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define BUFFER_ARENA_MMAP
+#endif
+
+namespace {
+
+std::size_t roundUp(std::size_t value, std::size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+std::size_t pageSize() {
+#ifdef BUFFER_ARENA_MMAP
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 4096;
+#endif
+}
+
+} // namespace
+
+BufferArena::BufferArena(PageMode pages, bool prefault, std::size_t chunkBytes)
+    : pages_(pages), prefault_(prefault), chunkBytes_(roundUp(std::max<std::size_t>(chunkBytes, 1), CHUNK_ALIGNMENT)) {}
+
+BufferArena::~BufferArena() {
+    for (const Chunk& chunk : chunks_) unmapChunk(chunk);
+}
+
+BufferArena& BufferArena::global() {
+    // Never destroyed, so buffers with static storage duration can still release into it at exit
+    static BufferArena* arena = new BufferArena(bufferPageMode, bufferPrefault);
+    return *arena;
+}
+
+void* BufferArena::allocate(std::size_t bytes) {
+    bytes = roundUp(std::max<std::size_t>(bytes, 1), ALLOCATION_ALIGNMENT);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (chunks_.empty() || chunks_.back().offset + bytes > chunks_.back().size) {
+        chunks_.push_back(mapChunk(bytes));
+    }
+    Chunk& chunk = chunks_.back();
+    void* pointer = chunk.base + chunk.offset;
+    chunk.offset += bytes;
+    chunk.live++;
+    return pointer;
+}
+
+void BufferArena::deallocate(void* pointer) {
+    char* address = static_cast<char*>(pointer);
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (std::size_t i = 0; i < chunks_.size(); i++) {
+        Chunk& chunk = chunks_[i];
+        if (address < chunk.base || address >= chunk.base + chunk.size) continue;
+        if (--chunk.live > 0) return;
+
+        // Empty: rewind the current chunk for the next buffers, release older ones
+        if (i + 1 == chunks_.size()) {
+            chunk.offset = 0;
+        } else {
+            unmapChunk(chunk);
+            chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        return;
+    }
+}
+
+BufferArena::Stats BufferArena::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats stats;
+    for (const Chunk& chunk : chunks_) {
+        stats.mappedBytes += chunk.size;
+        stats.usedBytes += chunk.offset;
+    }
+    stats.chunks = chunks_.size();
+    stats.pages = pages_;
+    stats.prefaulted = prefault_;
+    return stats;
+}
+
+// Caller holds the lock
+BufferArena::Chunk BufferArena::mapChunk(std::size_t bytes) {
+    Chunk chunk;
+    chunk.size = roundUp(std::max(bytes, chunkBytes_), CHUNK_ALIGNMENT);
+
+#ifdef BUFFER_ARENA_MMAP
+#ifdef MAP_HUGETLB
+    if (pages_ == PageMode::Explicit) {
+        void* mapping = mmap(nullptr, chunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mapping != MAP_FAILED) {
+            chunk.base = static_cast<char*>(mapping);
+        } else {
+            std::cerr << "[Buffers] No reserved hugepages available (vm.nr_hugepages), using transparent hugepages" << std::endl;
+            pages_ = PageMode::Transparent;
+        }
+    }
+#else
+    if (pages_ == PageMode::Explicit) pages_ = PageMode::Transparent;
+#endif
+
+    if (chunk.base == nullptr) {
+        // Over-reserve and trim so the chunk starts on a hugepage boundary, which transparent
+        // hugepages need to back it with large pages
+        std::size_t reserved = chunk.size + CHUNK_ALIGNMENT;
+        void* mapping = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) throw std::bad_alloc();
+        char* start = static_cast<char*>(mapping);
+        char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<std::uintptr_t>(start), CHUNK_ALIGNMENT));
+        if (aligned > start) munmap(start, static_cast<std::size_t>(aligned - start));
+        std::size_t tail = static_cast<std::size_t>(start + reserved - (aligned + chunk.size));
+        if (tail > 0) munmap(aligned + chunk.size, tail);
+        chunk.base = aligned;
+
+        if (pages_ == PageMode::Transparent) {
+#ifdef MADV_HUGEPAGE
+            if (madvise(chunk.base, chunk.size, MADV_HUGEPAGE) != 0) {
+                std::cerr << "[Buffers] Transparent hugepages unavailable, using regular pages" << std::endl;
+                pages_ = PageMode::Normal;
+            }
+#else
+            pages_ = PageMode::Normal;
+#endif
+        }
+    }
+#else
+    chunk.base = static_cast<char*>(::operator new(chunk.size, std::align_val_t(CHUNK_ALIGNMENT)));
+    pages_ = PageMode::Normal;
+#endif
+
+    if (prefault_) {
+        // One write per page maps it now (a single write covers a whole hugepage)
+        std::size_t step = pageSize();
+        for (std::size_t offset = 0; offset < chunk.size; offset += step) {
+            chunk.base[offset] = 0;
+        }
+    }
+    return chunk;
+}
+
+void BufferArena::unmapChunk(const Chunk& chunk) {
+#ifdef BUFFER_ARENA_MMAP
+    munmap(chunk.base, chunk.size);
+#else
+    ::operator delete(chunk.base, std::align_val_t(CHUNK_ALIGNMENT));
+#endif
+}
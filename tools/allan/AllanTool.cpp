@@ -0,0 +1,165 @@
+// Offline Allan deviation analysis
+//
+// Reads a whitespace or comma separated text log with one sample per line (e.g. "gx gy gz" or
+// "gx gy gz ax ay az", '#' lines ignored), streams it through AllanVariance in blocks, and prints
+// the deviation curve and noise parameters for every column. See README "Noise Characterization".
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AllanVariance.h"
+
+namespace {
+
+constexpr std::size_t BLOCK_SAMPLES = 1 << 16;
+
+struct Options {
+    std::string path;
+    double rate = 0.0;     // Hz
+    int octaves = 20;
+    unsigned int threads = std::thread::hardware_concurrency();
+};
+
+void printUsage() {
+    std::cout << "Usage: IMUAllan <log.txt> --rate HZ [options]\n"
+              << "  --octaves N     Largest cluster size is 2^(N-1) samples (default 20)\n"
+              << "  --threads N     Worker threads (default: hardware concurrency)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            options.path = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "[Allan] Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--rate") options.rate = std::stod(value);
+        else if (arg == "--octaves") options.octaves = std::stoi(value);
+        else if (arg == "--threads") options.threads = static_cast<unsigned int>(std::stoul(value));
+        else {
+            std::cerr << "[Allan] Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.path.empty() || options.rate <= 0.0) {
+        printUsage();
+        return false;
+    }
+    if (options.octaves < 1 || options.octaves > 30) {
+        std::cerr << "[Allan] Octaves must be between 1 and 30" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Parse the numbers on one line; commas count as whitespace
+std::size_t parseRow(std::string& line, std::vector<float>& row) {
+    for (char& c : line) {
+        if (c == ',') c = ' ';
+    }
+    row.clear();
+    std::istringstream stream(line);
+    float value;
+    while (stream >> value) {
+        row.push_back(value);
+    }
+    return row.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::ifstream file(options.path);
+    if (!file) {
+        std::cerr << "[Allan] Could not open " << options.path << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    std::unique_ptr<AllanVariance> allan;
+    std::vector<std::vector<float>> columns;
+    std::vector<const float*> pointers;
+    std::vector<float> row;
+    std::size_t buffered = 0, skipped = 0;
+
+    auto flush = [&]() {
+        allan->addBlock(pointers.data(), buffered);
+        buffered = 0;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t n = parseRow(line, row);
+        if (n == 0) continue;
+
+        // The first data line fixes the column count
+        if (!allan) {
+            allan = std::make_unique<AllanVariance>(n, options.rate, options.octaves, pool);
+            columns.assign(n, std::vector<float>(BLOCK_SAMPLES));
+            for (std::vector<float>& column : columns) {
+                pointers.push_back(column.data());
+            }
+        }
+        if (n != columns.size()) {
+            skipped++;
+            continue;
+        }
+
+        for (std::size_t c = 0; c < n; c++) {
+            columns[c][buffered] = row[c];
+        }
+        if (++buffered == BLOCK_SAMPLES) {
+            flush();
+        }
+    }
+    if (!allan) {
+        std::cerr << "[Allan] No samples in " << options.path << std::endl;
+        return 1;
+    }
+    flush();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[Allan] " << allan->samples() << " samples x " << allan->channels() << " columns ("
+              << allan->samples() / options.rate << " s) in " << elapsed << " s";
+    if (skipped > 0) {
+        std::cout << ", skipped " << skipped << " malformed lines";
+    }
+    std::cout << std::endl;
+
+    for (std::size_t c = 0; c < allan->channels(); c++) {
+        std::vector<AllanVariance::Point> curve = allan->deviation(c);
+        std::printf("\nColumn %zu\n%12s %14s %12s\n", c, "tau (s)", "deviation", "terms");
+        for (const AllanVariance::Point& point : curve) {
+            std::printf("%12.4g %14.6g %12llu\n", point.tau, point.deviation,
+                        static_cast<unsigned long long>(point.terms));
+        }
+        AllanVariance::NoiseParameters params = AllanVariance::noiseParameters(curve);
+        std::printf("Random walk: %.4g /rtHz  Bias instability: %.4g  Rate random walk: %.4g /s/rtHz\n",
+                    params.randomWalk, params.biasInstability, params.rateRandomWalk);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Compressed recording converter and benchmark
+//
+//   IMUArchive encode <in.txt> <out.imur>   Text recording ("G|A|M t x y z" lines) to compressed
+//   IMUArchive decode <in.imur>             Compressed to time-ordered text on stdout
+//   IMUArchive bench <in.imur>              Compression ratio and decode throughput
+//
+// See README "Recording".
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "storage/SensorRecorder.h"
+
+namespace {
+
+void printUsage() {
+    std::cout << "Usage: IMUArchive encode <in.txt> <out.imur>\n"
+              << "       IMUArchive decode <in.imur>\n"
+              << "       IMUArchive bench <in.imur>\n";
+}
+
+char sensorLetter(SensorType type) {
+    switch (type) {
+        case SensorType::Mag: return 'M';
+        case SensorType::Accel: return 'A';
+        case SensorType::Gyro: return 'G';
+    }
+    return '?';
+}
+
+int encode(const std::string& input, const std::string& output) {
+    std::ifstream file(input);
+    if (!file) {
+        std::cerr << "[Archive] Could not open " << input << std::endl;
+        return 1;
+    }
+    SensorRecorder recorder;
+    if (!recorder.start(output)) return 1;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        char letter;
+        SensorSample sample;
+        if (!(stream >> letter >> sample.timestamp >> sample.x >> sample.y >> sample.z)) continue;
+        if (letter == 'G') sample.type = SensorType::Gyro;
+        else if (letter == 'A') sample.type = SensorType::Accel;
+        else if (letter == 'M') sample.type = SensorType::Mag;
+        else continue;   // Reference attitudes and comments are not archived
+        recorder.record(sample);
+    }
+    recorder.stop();
+    return 0;
+}
+
+// Blocks of different sensors overlap in time, so decode everything and merge by timestamp
+int decode(const std::string& input) {
+    RecordingReader reader;
+    if (!reader.open(input)) return 1;
+
+    std::vector<SensorSample> streams[3];
+    SensorBlock block;
+    while (reader.next(block)) {
+        std::vector<SensorSample>& stream = streams[static_cast<int>(block.type)];
+        for (std::size_t i = 0; i < block.count; i++) {
+            stream.push_back({block.type, block.x[i], block.y[i], block.z[i], block.timestamps[i]});
+        }
+    }
+
+    std::size_t next[3] = {0, 0, 0};
+    while (true) {
+        int earliest = -1;
+        for (int s = 0; s < 3; s++) {
+            if (next[s] < streams[s].size() &&
+                (earliest < 0 || streams[s][next[s]].timestamp < streams[earliest][next[earliest]].timestamp)) {
+                earliest = s;
+            }
+        }
+        if (earliest < 0) break;
+        const SensorSample& sample = streams[earliest][next[earliest]++];
+        std::printf("%c %.9g %.9g %.9g %.9g\n", sensorLetter(sample.type), sample.timestamp, sample.x, sample.y, sample.z);
+    }
+    return 0;
+}
+
+int bench(const std::string& input) {
+    std::vector<std::vector<uint8_t>> blocks;
+    std::size_t samples = 0, encodedBytes = 0;
+    {
+        // Load the raw blocks once so the timing covers decoding only
+        std::ifstream file(input, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < RecordingFormat::HEADER_BYTES) {
+            std::cerr << "[Archive] Could not read " << input << std::endl;
+            return 1;
+        }
+        SensorBlock block;
+        std::size_t position = RecordingFormat::HEADER_BYTES;
+        while (position < data.size()) {
+            std::size_t used = SensorBlockDecoder::decode(data.data() + position, data.size() - position, block);
+            if (used == 0) break;
+            blocks.emplace_back(data.begin() + position, data.begin() + position + used);
+            samples += block.count;
+            position += used;
+        }
+        encodedBytes = data.size();
+    }
+    if (samples == 0) {
+        std::cerr << "[Archive] No blocks in " << input << std::endl;
+        return 1;
+    }
+
+    constexpr int REPEATS = 20;
+    SensorBlock block;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPEATS; r++) {
+        for (const std::vector<uint8_t>& data : blocks) {
+            SensorBlockDecoder::decode(data.data(), data.size(), block);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+    double rawBytes = static_cast<double>(samples) * 4 * sizeof(float);
+    std::printf("[Archive] %zu samples in %zu blocks, %zu bytes (%.2f bits/sample, %.2fx smaller than raw)\n",
+                samples, blocks.size(), encodedBytes, encodedBytes * 8.0 / samples, rawBytes / encodedBytes);
+    std::printf("[Archive] Decode: %.1f Msamples/s, %.2f GB/s of decoded floats\n",
+                samples / seconds / 1e6, rawBytes / seconds / 1e9);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "encode" && argc == 4) return encode(argv[2], argv[3]);
+    if (command == "decode" && argc == 3) return decode(argv[2]);
+    if (command == "bench" && argc == 3) return bench(argv[2]);
+    printUsage();
+    return 1;
+}
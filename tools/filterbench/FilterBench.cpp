@@ -0,0 +1,348 @@
+// Complementary filter vs error-state Kalman filter
+//
+// Replays a recording (the IMUTuner format, e.g. from IMULoadGen --mode record) through
+// ComplementaryFilter and ErrorStateKalmanFilter and prints, for each:
+//   - the cost of one gyro, accel and mag update, timed over repeated passes of that sensor's
+//     samples on an aligned filter
+//   - the CPU time per second of data at the recording's rates, i.e. the load of one device
+//   - the RMS attitude error against the reference ("Q" lines) once past the settle time
+// so the accuracy gained can be weighed against the CPU spent for a given device class.
+// It then compares the complementary filter's per-sample calls with updateBatch on blocks of
+// --block consecutive samples (the pipeline's reorder releases), in ns per sample and in the
+// largest attitude difference between the two at block ends.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ComplementaryFilter.h"
+#include "ErrorStateKalmanFilter.h"
+#include "SensorRates.h"
+
+namespace {
+
+constexpr float MIN_TIMED_SECONDS = 0.2f;   // Per sensor and filter
+constexpr float DEGREES = 57.29578f;
+
+struct Options {
+    std::string path;
+    float settle = 5.0f;   // Seconds of recording excluded from the error
+    std::size_t block = 16;   // Samples per updateBatch call
+    SensorRates rates;
+};
+
+struct Event {
+    char type;   // G, A, M or Q
+    float t;
+    float v[4];
+};
+
+// ComplementaryFilter publishes its attitude through references; keep them next to it
+struct ComplementaryRunner {
+    static constexpr const char* name = "Complementary";
+    QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+    Vector3F magVector = {0.0f, 0.0f, 0.0f};
+    ComplementaryFilter filter;
+
+    explicit ComplementaryRunner(const SensorRates& rates) : filter(attitude, magVector, rates) {}
+    bool aligned() const { return filter.getAlignmentStatus().aligned; }
+};
+
+struct KalmanRunner {
+    static constexpr const char* name = "Error-state EKF";
+    ErrorStateKalmanFilter filter;
+
+    explicit KalmanRunner(const SensorRates& rates) : filter(rates) {}
+    bool aligned() const { return filter.isAligned(); }
+};
+
+void printUsage() {
+    std::cout << "Usage: IMUFilterBench <recording.txt> [options]\n"
+              << "  --settle S        Seconds excluded from the attitude error at the start (default 5)\n"
+              << "  --block N         Samples per batch in the per-call vs batch comparison (default 16)\n"
+              << "  --gyro-rate HZ    Gyro sample rate of the recording (default gyroFreq)\n"
+              << "  --accel-rate HZ   Accel sample rate of the recording (default accelFreq)\n"
+              << "  --mag-rate HZ     Mag sample rate of the recording (default magFreq)\n"
+              << "Recording lines: 'G|A|M t x y z' samples, optional 'Q t w x y z' reference attitude.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            options.path = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "[FilterBench] Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--settle") options.settle = std::stof(value);
+        else if (arg == "--block") options.block = static_cast<std::size_t>(std::stoul(value));
+        else if (arg == "--gyro-rate") options.rates.gyro = std::stof(value);
+        else if (arg == "--accel-rate") options.rates.accel = std::stof(value);
+        else if (arg == "--mag-rate") options.rates.mag = std::stof(value);
+        else {
+            std::cerr << "[FilterBench] Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.path.empty() || options.block == 0 || options.rates.gyro <= 0.0f || options.rates.accel <= 0.0f || options.rates.mag <= 0.0f) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+bool loadRecording(const std::string& path, std::vector<Event>& events) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "[FilterBench] Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream stream(line);
+        Event event = {};
+        stream >> event.type >> event.t >> event.v[0] >> event.v[1] >> event.v[2];
+        if (event.type == 'Q') stream >> event.v[3];
+        if (!stream || (event.type != 'G' && event.type != 'A' && event.type != 'M' && event.type != 'Q')) continue;
+        events.push_back(event);
+    }
+    return !events.empty();
+}
+
+// Rotation angle of a^-1 b; atan2 keeps small angles exact where acos of the dot product would not
+float angleBetween(const QuaternionF& a, const QuaternionF& b) {
+    QuaternionF d = Math3D::multiplyQuaternions(Math3D::conjugateQuaternion(a), b);
+    float vector = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    return 2.0f * std::atan2(vector, std::abs(d.w));
+}
+
+template <typename Runner>
+void feed(Runner& runner, const Event& event) {
+    switch (event.type) {
+        case 'G': runner.filter.updateWithGyro(event.v[0], event.v[1], event.v[2], event.t); break;
+        case 'A': runner.filter.updateWithAccel(event.v[0], event.v[1], event.v[2]); break;
+        case 'M': runner.filter.updateWithMag(event.v[0], event.v[1], event.v[2]); break;
+        default: break;
+    }
+}
+
+// RMS attitude error in degrees over the reference attitudes after the settle time; -1 without any
+template <typename Runner>
+float attitudeError(const std::vector<Event>& events, const Options& options) {
+    Runner runner(options.rates);
+    double sumSquares = 0.0;
+    std::size_t terms = 0;
+    float start = events.front().t;
+    for (const Event& event : events) {
+        if (event.type == 'Q') {
+            if (event.t - start >= options.settle && runner.aligned()) {
+                float error = angleBetween(runner.filter.getAttitude(), QuaternionF{event.v[0], event.v[1], event.v[2], event.v[3]});
+                sumSquares += error * error;
+                terms++;
+            }
+            continue;
+        }
+        feed(runner, event);
+    }
+    return terms > 0 ? static_cast<float>(std::sqrt(sumSquares / terms)) * DEGREES : -1.0f;
+}
+
+// Nanoseconds per update of one sensor type, on a filter aligned by a full pass of the recording
+template <typename Runner>
+double updateCost(const std::vector<Event>& events, const Options& options, char type) {
+    Runner runner(options.rates);
+    for (const Event& event : events) feed(runner, event);
+
+    std::vector<Event> samples;
+    for (const Event& event : events) {
+        if (event.type == type) samples.push_back(event);
+    }
+    if (samples.empty()) return 0.0;
+
+    std::size_t updates = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    do {
+        for (const Event& event : samples) feed(runner, event);
+        updates += samples.size();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < MIN_TIMED_SECONDS);
+    return seconds / updates * 1e9;
+}
+
+template <typename Runner>
+void run(const std::vector<Event>& events, const Options& options) {
+    double gyro = updateCost<Runner>(events, options, 'G');
+    double accel = updateCost<Runner>(events, options, 'A');
+    double mag = updateCost<Runner>(events, options, 'M');
+    double perSecond = gyro * options.rates.gyro + accel * options.rates.accel + mag * options.rates.mag;   // ns
+    float error = attitudeError<Runner>(events, options);
+
+    std::printf("%-16s %8.1f %8.1f %8.1f   %9.1f us/s (%.3f%% of a core)", Runner::name,
+                gyro, accel, mag, perSecond / 1e3, perSecond / 1e7);
+    if (error >= 0.0f) {
+        std::printf("   %8.4f deg\n", error);
+    } else {
+        std::printf("   %8s\n", "-");
+    }
+}
+
+// The recording's samples split by sensor, and cut into blocks of consecutive samples
+struct Batches {
+    struct Columns {
+        std::vector<float> x, y, z, t;
+    };
+    struct Block {
+        std::size_t start[3];   // Indexed by SensorType
+        std::size_t count[3];
+    };
+    Columns columns[3];
+    std::vector<Block> blocks;
+    std::size_t samples = 0;
+
+    SampleBlock view(const Block& block, SensorType sensor) const {
+        int s = static_cast<int>(sensor);
+        std::size_t start = block.start[s];
+        return {columns[s].x.data() + start, columns[s].y.data() + start, columns[s].z.data() + start,
+                columns[s].t.data() + start, block.count[s]};
+    }
+};
+
+Batches makeBatches(const std::vector<Event>& events, std::size_t blockSize) {
+    Batches batches;
+    Batches::Block block = {};
+    std::size_t inBlock = 0;
+    for (const Event& event : events) {
+        SensorType sensor;
+        switch (event.type) {
+            case 'G': sensor = SensorType::Gyro; break;
+            case 'A': sensor = SensorType::Accel; break;
+            case 'M': sensor = SensorType::Mag; break;
+            default: continue;
+        }
+        Batches::Columns& columns = batches.columns[static_cast<int>(sensor)];
+        columns.x.push_back(event.v[0]);
+        columns.y.push_back(event.v[1]);
+        columns.z.push_back(event.v[2]);
+        columns.t.push_back(event.t);
+        block.count[static_cast<int>(sensor)]++;
+        batches.samples++;
+
+        if (++inBlock == blockSize) {
+            batches.blocks.push_back(block);
+            for (int s = 0; s < 3; s++) {
+                block.start[s] += block.count[s];
+                block.count[s] = 0;
+            }
+            inBlock = 0;
+        }
+    }
+    if (inBlock > 0) batches.blocks.push_back(block);
+    return batches;
+}
+
+void feedBatch(ComplementaryRunner& runner, const Batches& batches, const Batches::Block& block) {
+    runner.filter.updateBatch(batches.view(block, SensorType::Gyro), batches.view(block, SensorType::Accel),
+                              batches.view(block, SensorType::Mag));
+}
+
+// ComplementaryFilter per-sample calls vs updateBatch over the same blocks
+void compareBatch(const std::vector<Event>& events, const Options& options) {
+    Batches batches = makeBatches(events, options.block);
+    if (batches.samples == 0) return;
+
+    // Largest attitude difference at the block ends, both replayed from the start
+    ComplementaryRunner perCall(options.rates);
+    ComplementaryRunner batched(options.rates);
+    float maxDifference = 0.0f;
+    std::size_t next = 0;
+    for (const Batches::Block& block : batches.blocks) {
+        std::size_t samples = block.count[0] + block.count[1] + block.count[2];
+        while (samples > 0) {
+            if (events[next].type != 'Q') {
+                feed(perCall, events[next]);
+                samples--;
+            }
+            next++;
+        }
+        feedBatch(batched, batches, block);
+        maxDifference = std::max(maxDifference, angleBetween(perCall.filter.getAttitude(), batched.filter.getAttitude()));
+    }
+
+    // Both timed on aligned filters over repeated passes of the recording
+    auto time = [&](auto&& pass) {
+        std::size_t samples = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        do {
+            pass();
+            samples += batches.samples;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < MIN_TIMED_SECONDS);
+        return seconds / samples * 1e9;
+    };
+    double perCallCost = time([&] {
+        for (const Event& event : events) feed(perCall, event);
+    });
+    double batchCost = time([&] {
+        for (const Batches::Block& block : batches.blocks) feedBatch(batched, batches, block);
+    });
+
+    std::printf("Complementary per-call vs batch (%zu-sample blocks): %.1f vs %.1f ns/sample (%.2fx), max difference %.2e deg\n",
+                options.block, perCallCost, batchCost, perCallCost / batchCost, maxDifference * DEGREES);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Event> events;
+    if (!loadRecording(options.path, events)) {
+        std::cerr << "[FilterBench] No samples in " << options.path << std::endl;
+        return 1;
+    }
+
+    // The complementary filter logs alignment and rejected samples
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    std::printf("[FilterBench] %zu events, %.1f s, gyro/accel/mag %.0f/%.0f/%.0f Hz\n", events.size(),
+                events.back().t - events.front().t, options.rates.gyro, options.rates.accel, options.rates.mag);
+    std::printf("%-16s %8s %8s %8s   %-30s   %s\n", "Filter", "gyro ns", "accel ns", "mag ns", "CPU per device", "RMS error");
+    run<ComplementaryRunner>(events, options);
+    run<KalmanRunner>(events, options);
+
+    // Covariance-derived uncertainty at the end of the recording
+    KalmanRunner kalman(options.rates);
+    for (const Event& event : events) feed(kalman, event);
+    Vector3F attitudeSigma = kalman.filter.getAttitudeSigma();
+    Vector3F biasSigma = kalman.filter.getBiasSigma();
+    std::printf("EKF 1-sigma at the end: attitude %.3f/%.3f/%.3f deg, gyro bias %.5f/%.5f/%.5f rad/s\n",
+                attitudeSigma.x * DEGREES, attitudeSigma.y * DEGREES, attitudeSigma.z * DEGREES,
+                biasSigma.x, biasSigma.y, biasSigma.z);
+
+    compareBatch(events, options);
+
+    std::cout.rdbuf(coutBuffer);
+    return 0;
+}
@@ -0,0 +1,685 @@
+// Synthetic IMU load generator
+//
+// Simulates N devices moving along scripted motion profiles and streams their samples
+// to IMUTool as WebSocket clients or UDP senders (0xAA/flags message format), or through
+// pseudo-terminal pairs (USB batch format, or its compact int16 form on request). Record mode instead writes one device's samples
+// and true attitude to a text file for IMUTuner. See README "Load Generator" for usage.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+#include "util/Math3D.h"
+#include "util/Structs3D.h"
+
+namespace beast = boost::beast;
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+using namespace Math3D;
+using namespace Structs3D;
+
+namespace {
+
+constexpr uint8_t SYNC_BYTE = 0xAA;
+constexpr uint8_t SYNC_BYTE_TIMESTAMPED = 0xAB;   // USB batch with a device timestamp after the counts
+constexpr uint8_t TIMESTAMP_FLAG = 0x08;          // Flags bit for a device timestamp after the flags (and sequence)
+constexpr uint8_t SEQUENCE_FLAG = 0x10;           // Flags bit for a uint16 sequence number after the flags
+constexpr uint8_t BATCH_FLAG = 0x20;              // Flags bit for mag/accel/gyro sample counts before the data
+constexpr int MAX_BATCH_SAMPLES = 7;    // USBSession rejects headers with more samples per sensor
+
+// USB compact encoding (see USBSession.h), sent once IMUTool asks for it with COMPACT_REQUEST
+constexpr uint8_t SYNC_BYTE_SCALES = 0xAC;
+constexpr uint8_t SYNC_BYTE_COMPACT = 0xAD;
+constexpr uint8_t COMPACT_REQUEST = 0xC1;
+constexpr uint8_t COMPACT_SCALES_MAGIC[4] = {'I', 'M', 'U', 'S'};
+constexpr uint8_t COMPACT_TIMESTAMP = 0x08;
+constexpr uint8_t COMPACT_DELTA[3] = {0x04, 0x02, 0x01};   // Mag, accel, gyro
+// Full-scale ranges of a typical 16-bit IMU: +-4912 uT, +-16 g, +-2000 deg/s
+constexpr float COMPACT_SCALES[3] = {4912.0f / 32768.0f, 16.0f / 32768.0f, 2000.0f / 32768.0f * 3.14159265f / 180.0f};
+
+enum class Mode { WebSocket, Udp, Pty, Record };
+enum class Compact { Off, Absolute, Delta };
+enum class Profile { Static, Spin, Wobble, Shake };
+
+struct Options {
+    Mode mode = Mode::WebSocket;
+    std::string host = "127.0.0.1";
+    std::string output;              // Record mode file
+    unsigned short port = 0;         // 0: 8000 for WebSocket, 8001 for UDP
+    int devices = 1;
+    int gyroRate = 100;
+    int accelRate = 100;
+    int magRate = 50;
+    int batchSize = 4;               // Gyro samples per USB batch or UDP datagram
+    Profile profile = Profile::Wobble;
+    float noiseScale = 1.0f;         // Multiplier on the default sensor noise levels
+    float gyroBiasStd = 0.01f;       // rad/s, drawn once per device
+    float corruptProbability = 0.0f; // Per message/batch
+    float lossProbability = 0.0f;    // UDP datagrams not sent
+    float reorderProbability = 0.0f; // UDP datagrams held back and sent after the next one
+    float duration = 0.0f;           // Seconds, 0 runs until killed
+    bool deviceClock = false;        // Send device timestamps
+    Compact compact = Compact::Off;  // Pty devices answer compact encoding requests
+    float clockSkewPpm = 0.0f;       // Device clock rate error, positive runs slow
+    unsigned int seed = 1;
+};
+
+struct Counters {
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> corrupted{0};
+    std::atomic<uint64_t> dropped{0};      // Bytes not accepted by a full pty, or UDP datagrams lost on purpose
+    std::atomic<uint64_t> connectErrors{0};
+};
+
+std::atomic<bool> running{true};
+Counters counters;
+
+void printUsage() {
+    std::cout <<
+        "Usage: IMULoadGen [options]\n"
+        "  --mode ws|udp|pty|record Transport, or record to a file (default ws)\n"
+        "  --output FILE        Recording written in record mode\n"
+        "  --host HOST          WebSocket server host (default 127.0.0.1)\n"
+        "  --port PORT          Server port (default 8000 for ws, 8001 for udp)\n"
+        "  --devices N          Number of simulated devices (default 1)\n"
+        "  --gyro-rate HZ       Gyro sample rate (default 100)\n"
+        "  --accel-rate HZ      Accel sample rate (default 100)\n"
+        "  --mag-rate HZ        Mag sample rate, 0 disables (default 50)\n"
+        "  --batch N            Gyro samples per USB batch or UDP datagram, 1-7 (default 4)\n"
+        "  --profile P          static|spin|wobble|shake (default wobble)\n"
+        "  --noise SCALE        Sensor noise multiplier (default 1)\n"
+        "  --bias STD           Per-device gyro bias std dev in rad/s (default 0.01)\n"
+        "  --corrupt P          Probability of corrupting a message/batch (default 0)\n"
+        "  --loss P             Probability of not sending a UDP datagram (default 0)\n"
+        "  --reorder P          Probability of sending a UDP datagram after the next one (default 0)\n"
+        "  --duration S         Stop after S seconds, 0 = forever (default 0)\n"
+        "  --device-clock PPM   Send device timestamps from a clock running PPM slow (negative: fast)\n"
+        "  --compact abs|delta  pty: switch to int16 batches when IMUTool asks, with int8 deltas\n"
+        "                       where they fit (delta) or without (abs). Default: float batches only\n"
+        "  --seed N             Random seed (default 1)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "[LoadGen] Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--mode") {
+            if (value == "ws") options.mode = Mode::WebSocket;
+            else if (value == "udp") options.mode = Mode::Udp;
+            else if (value == "pty") options.mode = Mode::Pty;
+            else if (value == "record") options.mode = Mode::Record;
+            else { std::cerr << "[LoadGen] Unknown mode: " << value << std::endl; return false; }
+        } else if (arg == "--profile") {
+            if (value == "static") options.profile = Profile::Static;
+            else if (value == "spin") options.profile = Profile::Spin;
+            else if (value == "wobble") options.profile = Profile::Wobble;
+            else if (value == "shake") options.profile = Profile::Shake;
+            else { std::cerr << "[LoadGen] Unknown profile: " << value << std::endl; return false; }
+        }
+        else if (arg == "--host") options.host = value;
+        else if (arg == "--output") options.output = value;
+        else if (arg == "--port") options.port = static_cast<unsigned short>(std::stoi(value));
+        else if (arg == "--devices") options.devices = std::stoi(value);
+        else if (arg == "--gyro-rate") options.gyroRate = std::stoi(value);
+        else if (arg == "--accel-rate") options.accelRate = std::stoi(value);
+        else if (arg == "--mag-rate") options.magRate = std::stoi(value);
+        else if (arg == "--batch") options.batchSize = std::stoi(value);
+        else if (arg == "--noise") options.noiseScale = std::stof(value);
+        else if (arg == "--bias") options.gyroBiasStd = std::stof(value);
+        else if (arg == "--corrupt") options.corruptProbability = std::stof(value);
+        else if (arg == "--loss") options.lossProbability = std::stof(value);
+        else if (arg == "--reorder") options.reorderProbability = std::stof(value);
+        else if (arg == "--duration") options.duration = std::stof(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--compact") {
+            if (value == "abs") options.compact = Compact::Absolute;
+            else if (value == "delta") options.compact = Compact::Delta;
+            else { std::cerr << "[LoadGen] Unknown compact mode: " << value << std::endl; return false; }
+        }
+        else if (arg == "--device-clock") {
+            options.deviceClock = true;
+            options.clockSkewPpm = std::stof(value);
+        }
+        else {
+            std::cerr << "[LoadGen] Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.port == 0) options.port = options.mode == Mode::Udp ? 8001 : 8000;
+    if (options.devices < 1 || options.gyroRate < 1 || options.accelRate < 0 || options.magRate < 0) {
+        std::cerr << "[LoadGen] Device count and rates must be positive" << std::endl;
+        return false;
+    }
+    if (options.accelRate > options.gyroRate || options.magRate > options.gyroRate) {
+        std::cerr << "[LoadGen] Accel and mag rates cannot exceed the gyro rate" << std::endl;
+        return false;
+    }
+    if (options.mode == Mode::Record && (options.output.empty() || options.duration <= 0.0f || options.devices != 1)) {
+        std::cerr << "[LoadGen] Record mode needs --output, a --duration and a single device" << std::endl;
+        return false;
+    }
+    if (options.batchSize < 1 || options.batchSize > MAX_BATCH_SAMPLES) {
+        std::cerr << "[LoadGen] Batch size must be between 1 and " << MAX_BATCH_SAMPLES << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct Sample {
+    float x, y, z;
+};
+
+// One simulated device: integrates its motion profile at the gyro rate and emits
+// accel/mag samples whenever their (slower) schedule comes due
+class DeviceSimulator {
+public:
+    DeviceSimulator(const Options& options, int index)
+        : options_(options), rng_(options.seed * 7919u + index), phase_(0.7f * index) {
+        std::normal_distribution<float> biasDist(0.0f, options.gyroBiasStd);
+        gyroBias_ = {biasDist(rng_), biasDist(rng_), biasDist(rng_)};
+    }
+
+    // Advance one gyro period and report which sensors produced a sample this tick
+    void step(bool& hasGyro, bool& hasAccel, bool& hasMag) {
+        float dt = 1.0f / options_.gyroRate;
+        Sample rate = angularRate(time_);
+
+        attitude_ = normalizeQuaternion(updateQuaternionWithAngularVelocity(attitude_, rate.x, rate.y, rate.z, dt));
+        time_ += dt;
+
+        gyro_ = {rate.x + gyroBias_.x + noise(gyroNoise), rate.y + gyroBias_.y + noise(gyroNoise), rate.z + gyroBias_.z + noise(gyroNoise)};
+        hasGyro = true;
+
+        // Accel and mag use the filter's conventions: gravity (0,0,-1) g and a field along world +X
+        QuaternionF inverse = conjugateQuaternion(attitude_);
+        hasAccel = due(accelPhase_, options_.accelRate);
+        if (hasAccel) {
+            Vector3F g = rotateVectorByQuaternion(Vector3F(0.0f, 0.0f, -1.0f), inverse);
+            accel_ = {g.x + noise(accelNoise), g.y + noise(accelNoise), g.z + noise(accelNoise)};
+        }
+        hasMag = due(magPhase_, options_.magRate);
+        if (hasMag) {
+            Vector3F m = rotateVectorByQuaternion(Vector3F(22.0f, 0.0f, -42.0f), inverse);
+            mag_ = {m.x + noise(magNoise), m.y + noise(magNoise), m.z + noise(magNoise)};
+        }
+    }
+
+    const Sample& gyro() const { return gyro_; }
+    const Sample& accel() const { return accel_; }
+    const Sample& mag() const { return mag_; }
+    const QuaternionF& attitude() const { return attitude_; }
+    float time() const { return time_; }
+
+    // Free-running microsecond counter of the simulated device at the current sample. It starts
+    // shortly before wrapping so receivers exercise the wrap
+    uint32_t deviceMicros() const {
+        double seconds = static_cast<double>(time_) / (1.0 + options_.clockSkewPpm * 1e-6);
+        return clockBase_ + static_cast<uint32_t>(seconds * 1e6);
+    }
+
+    bool chance(float probability) {
+        return probability > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(rng_) < probability;
+    }
+
+    // Damage a message the way a noisy link would: flipped bits, truncation or a bad sync byte
+    void corrupt(std::vector<uint8_t>& message) {
+        if (message.empty()) return;
+        switch (std::uniform_int_distribution<int>(0, 2)(rng_)) {
+            case 0:
+                message[std::uniform_int_distribution<size_t>(0, message.size() - 1)(rng_)] ^= 0x5A;
+                break;
+            case 1:
+                message.resize(std::uniform_int_distribution<size_t>(1, message.size())(rng_) - 1);
+                break;
+            case 2:
+                message[0] = 0x55;
+                break;
+        }
+        counters.corrupted++;
+    }
+
+private:
+    static constexpr float gyroNoise = 0.005f;   // rad/s
+    static constexpr float accelNoise = 0.01f;   // g
+    static constexpr float magNoise = 0.5f;      // uT
+
+    Sample angularRate(float t) const {
+        constexpr float twoPi = 6.2831853f;
+        float p = phase_;
+        switch (options_.profile) {
+            case Profile::Static:
+                return {0.0f, 0.0f, 0.0f};
+            case Profile::Spin:
+                return {0.0f, 0.0f, 1.0f};
+            case Profile::Wobble:
+                return {0.8f * std::sin(twoPi * 0.5f * t + p), 0.6f * std::sin(twoPi * 0.3f * t + 1.0f + p), 0.4f * std::sin(twoPi * 0.2f * t + p)};
+            case Profile::Shake:
+                return {3.0f * std::sin(twoPi * 5.0f * t + p), 2.0f * std::sin(twoPi * 7.0f * t + p), 1.0f * std::sin(twoPi * 3.0f * t + p)};
+        }
+        return {0.0f, 0.0f, 0.0f};
+    }
+
+    float noise(float std) {
+        return std::normal_distribution<float>(0.0f, std * options_.noiseScale)(rng_);
+    }
+
+    // Bresenham-style scheduler so slower sensors stay evenly spaced on the gyro grid
+    bool due(int& phase, int rate) {
+        if (rate <= 0) return false;
+        phase += rate;
+        if (phase >= options_.gyroRate) {
+            phase -= options_.gyroRate;
+            return true;
+        }
+        return false;
+    }
+
+    const Options& options_;
+    std::mt19937 rng_;
+    float phase_;
+    float time_ = 0.0f;
+    QuaternionF attitude_ = {1.0f, 0.0f, 0.0f, 0.0f};
+    Sample gyroBias_ = {0.0f, 0.0f, 0.0f};
+    Sample gyro_ = {0.0f, 0.0f, 0.0f};
+    Sample accel_ = {0.0f, 0.0f, 0.0f};
+    Sample mag_ = {0.0f, 0.0f, 0.0f};
+    int accelPhase_ = 0;
+    int magPhase_ = 0;
+    uint32_t clockBase_ = 0xFFFF0000u;
+};
+
+void appendTimestamp(std::vector<uint8_t>& message, uint32_t micros) {
+    size_t offset = message.size();
+    message.resize(offset + sizeof(micros));
+    std::memcpy(message.data() + offset, &micros, sizeof(micros));
+}
+
+void appendSample(std::vector<uint8_t>& message, const Sample& sample) {
+    size_t offset = message.size();
+    message.resize(offset + 3 * sizeof(float));
+    std::memcpy(message.data() + offset, &sample, 3 * sizeof(float));
+}
+
+using Counts = std::array<int16_t, 3>;
+
+std::vector<Counts> quantize(const std::vector<Sample>& samples, float scale) {
+    auto count = [scale](float v) {
+        return static_cast<int16_t>(std::clamp(std::lround(v / scale), -32768L, 32767L));
+    };
+    std::vector<Counts> counts;
+    for (const Sample& s : samples) counts.push_back({count(s.x), count(s.y), count(s.z)});
+    return counts;
+}
+
+bool deltasFit(const std::vector<Counts>& counts) {
+    for (size_t i = 1; i < counts.size(); i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            int delta = counts[i][axis] - counts[i - 1][axis];
+            if (delta < -128 || delta > 127) return false;
+        }
+    }
+    return true;
+}
+
+void appendCounts(std::vector<uint8_t>& message, const std::vector<Counts>& counts, bool delta) {
+    for (size_t i = 0; i < counts.size(); i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (i == 0 || !delta) {
+                size_t offset = message.size();
+                message.resize(offset + sizeof(int16_t));
+                std::memcpy(message.data() + offset, &counts[i][axis], sizeof(int16_t));
+            } else {
+                message.push_back(static_cast<uint8_t>(static_cast<int8_t>(counts[i][axis] - counts[i - 1][axis])));
+            }
+        }
+    }
+}
+
+// [0xAC]["IMUS"][scale, offset x,y,z] for mag, accel and gyro; offsets are zero
+std::vector<uint8_t> compactScales() {
+    std::vector<uint8_t> message = {SYNC_BYTE_SCALES};
+    message.insert(message.end(), std::begin(COMPACT_SCALES_MAGIC), std::end(COMPACT_SCALES_MAGIC));
+    for (float scale : COMPACT_SCALES) {
+        float values[4] = {scale, 0.0f, 0.0f, 0.0f};
+        size_t offset = message.size();
+        message.resize(offset + sizeof(values));
+        std::memcpy(message.data() + offset, values, sizeof(values));
+    }
+    return message;
+}
+
+bool stillRunning(std::chrono::steady_clock::time_point start, const Options& options) {
+    if (!running) return false;
+    if (options.duration <= 0.0f) return true;
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() < options.duration;
+}
+
+// One WebSocket client per device, one message per gyro tick (same layout WebSocketSession parses)
+void runWebSocketDevice(const Options& options, int index) {
+    DeviceSimulator device(options, index);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.gyroRate));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> message;
+
+    while (stillRunning(start, options)) {
+        try {
+            net::io_context ioc;
+            tcp::resolver resolver(ioc);
+            beast::websocket::stream<tcp::socket> ws(ioc);
+            net::connect(ws.next_layer(), resolver.resolve(options.host, std::to_string(options.port)));
+            ws.handshake(options.host, "/");
+            ws.binary(true);
+
+            auto next = std::chrono::steady_clock::now();
+            while (stillRunning(start, options)) {
+                bool hasGyro, hasAccel, hasMag;
+                device.step(hasGyro, hasAccel, hasMag);
+
+                // [0xAA][flags][device time, with --device-clock][mag][accel][gyro]
+                message.clear();
+                message.push_back(SYNC_BYTE);
+                message.push_back(static_cast<uint8_t>((options.deviceClock ? TIMESTAMP_FLAG : 0) |
+                    (hasMag ? 0x04 : 0) | (hasAccel ? 0x02 : 0) | (hasGyro ? 0x01 : 0)));
+                if (options.deviceClock) appendTimestamp(message, device.deviceMicros());
+                if (hasMag) appendSample(message, device.mag());
+                if (hasAccel) appendSample(message, device.accel());
+                if (hasGyro) appendSample(message, device.gyro());
+                if (device.chance(options.corruptProbability)) device.corrupt(message);
+
+                ws.write(net::buffer(message));
+                counters.messages++;
+                counters.bytes += message.size();
+
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+            beast::error_code ec;
+            ws.close(beast::websocket::close_code::normal, ec);
+        } catch (const std::exception& e) {
+            counters.connectErrors++;
+            std::cerr << "[LoadGen] Device " << index << ": " << e.what() << ", reconnecting" << std::endl;
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+}
+
+// One UDP socket (so one source address) per device. Each datagram carries a sequence number and
+// either one gyro tick ([0xAA][flags][seq][mag][accel][gyro], with --batch 1) or a batch of
+// --batch gyro ticks ([0xAA][flags][seq][counts][data]); device time follows seq with --device-clock
+void runUdpDevice(const Options& options, int index) {
+    net::io_context ioc;
+    net::ip::udp::socket socket(ioc);
+    net::ip::udp::endpoint target;
+    try {
+        target = *net::ip::udp::resolver(ioc).resolve(net::ip::udp::v4(), options.host, std::to_string(options.port)).begin();
+        socket.open(net::ip::udp::v4());
+    } catch (const std::exception& e) {
+        std::cerr << "[LoadGen] Device " << index << ": " << e.what() << std::endl;
+        counters.connectErrors++;
+        return;
+    }
+
+    DeviceSimulator device(options, index);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.gyroRate));
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+
+    bool batched = options.batchSize > 1;
+    uint16_t sequence = 0;
+    std::vector<Sample> gyro, accel, mag;
+    std::vector<uint8_t> datagram, heldBack;
+
+    while (stillRunning(start, options)) {
+        bool hasGyro, hasAccel, hasMag;
+        device.step(hasGyro, hasAccel, hasMag);
+        if (hasGyro) gyro.push_back(device.gyro());
+        if (hasAccel) accel.push_back(device.accel());
+        if (hasMag) mag.push_back(device.mag());
+
+        if ((int)gyro.size() >= options.batchSize) {
+            uint8_t flags = SEQUENCE_FLAG | (options.deviceClock ? TIMESTAMP_FLAG : 0);
+            if (batched) flags |= BATCH_FLAG;
+            else flags |= (mag.empty() ? 0 : 0x04) | (accel.empty() ? 0 : 0x02) | 0x01;
+
+            datagram.clear();
+            datagram.push_back(SYNC_BYTE);
+            datagram.push_back(flags);
+            datagram.push_back(static_cast<uint8_t>(sequence & 0xFF));
+            datagram.push_back(static_cast<uint8_t>(sequence >> 8));
+            sequence++;
+            if (options.deviceClock) appendTimestamp(datagram, device.deviceMicros());
+            if (batched) {
+                datagram.push_back(static_cast<uint8_t>(mag.size()));
+                datagram.push_back(static_cast<uint8_t>(accel.size()));
+                datagram.push_back(static_cast<uint8_t>(gyro.size()));
+            }
+            for (const Sample& s : mag) appendSample(datagram, s);
+            for (const Sample& s : accel) appendSample(datagram, s);
+            for (const Sample& s : gyro) appendSample(datagram, s);
+            gyro.clear();
+            accel.clear();
+            mag.clear();
+            if (device.chance(options.corruptProbability)) device.corrupt(datagram);
+
+            if (device.chance(options.lossProbability)) {
+                counters.dropped += datagram.size();
+            } else if (heldBack.empty() && device.chance(options.reorderProbability)) {
+                heldBack = datagram;
+            } else {
+                boost::system::error_code ec;
+                socket.send_to(net::buffer(datagram), target, 0, ec);
+                counters.messages++;
+                counters.bytes += datagram.size();
+                if (!heldBack.empty()) {
+                    socket.send_to(net::buffer(heldBack), target, 0, ec);
+                    counters.messages++;
+                    counters.bytes += heldBack.size();
+                    heldBack.clear();
+                }
+            }
+        }
+
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// One pty pair per device. IMUTool opens the printed slave path as its serial port
+void runPtyDevice(const Options& options, int index) {
+    int master = -1, slave = -1;
+    char slaveName[256] = {0};
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) != 0) {
+        std::cerr << "[LoadGen] Device " << index << ": openpty failed: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    // Raw mode so the line discipline passes binary batches through untouched
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    std::cout << "[LoadGen] Device " << index << " serial port: " << slaveName << std::endl;
+
+    DeviceSimulator device(options, index);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.gyroRate));
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+
+    std::vector<Sample> gyro, accel, mag;
+    std::vector<uint8_t> batch;
+    bool compact = false;   // IMUTool asked for the compact encoding (with --compact)
+
+    while (stillRunning(start, options)) {
+        bool hasGyro, hasAccel, hasMag;
+        device.step(hasGyro, hasAccel, hasMag);
+        if (hasGyro) gyro.push_back(device.gyro());
+        if (hasAccel) accel.push_back(device.accel());
+        if (hasMag) mag.push_back(device.mag());
+
+        // IMUTool sends a request each time it opens the port; answer with the scales, which must
+        // reach it before the first compact batch. Without --compact the request is ignored
+        uint8_t received[64];
+        for (ssize_t n; (n = read(master, received, sizeof(received))) > 0;) {
+            if (options.compact == Compact::Off || !std::count(received, received + n, COMPACT_REQUEST)) continue;
+            std::vector<uint8_t> scales = compactScales();
+            if (write(master, scales.data(), scales.size()) == (ssize_t)scales.size()) {
+                if (!compact) std::cout << "[LoadGen] Device " << index << ": compact encoding on" << std::endl;
+                compact = true;
+            }
+        }
+
+        // [0xAA][mag_count][accel_count][gyro_count][mag data][accel data][gyro data], or with
+        // --device-clock [0xAB][counts][device time of the newest samples][data]. Compact:
+        // [0xAD][flags][counts][device time][int16 counts, or int8 deltas after each sensor's first]
+        if ((int)gyro.size() >= options.batchSize) {
+            batch.clear();
+            if (compact) {
+                std::vector<Counts> counts[3] = {quantize(mag, COMPACT_SCALES[0]), quantize(accel, COMPACT_SCALES[1]),
+                                                 quantize(gyro, COMPACT_SCALES[2])};
+                uint8_t flags = options.deviceClock ? COMPACT_TIMESTAMP : 0;
+                for (int sensor = 0; sensor < 3; sensor++) {
+                    if (options.compact == Compact::Delta && deltasFit(counts[sensor])) flags |= COMPACT_DELTA[sensor];
+                }
+                batch.push_back(SYNC_BYTE_COMPACT);
+                batch.push_back(flags);
+                batch.push_back(static_cast<uint8_t>(mag.size()));
+                batch.push_back(static_cast<uint8_t>(accel.size()));
+                batch.push_back(static_cast<uint8_t>(gyro.size()));
+                if (options.deviceClock) appendTimestamp(batch, device.deviceMicros());
+                for (int sensor = 0; sensor < 3; sensor++) appendCounts(batch, counts[sensor], flags & COMPACT_DELTA[sensor]);
+            } else {
+                batch.push_back(options.deviceClock ? SYNC_BYTE_TIMESTAMPED : SYNC_BYTE);
+                batch.push_back(static_cast<uint8_t>(mag.size()));
+                batch.push_back(static_cast<uint8_t>(accel.size()));
+                batch.push_back(static_cast<uint8_t>(gyro.size()));
+                if (options.deviceClock) appendTimestamp(batch, device.deviceMicros());
+                for (const Sample& s : mag) appendSample(batch, s);
+                for (const Sample& s : accel) appendSample(batch, s);
+                for (const Sample& s : gyro) appendSample(batch, s);
+            }
+            gyro.clear();
+            accel.clear();
+            mag.clear();
+            if (device.chance(options.corruptProbability)) device.corrupt(batch);
+
+            ssize_t written = write(master, batch.data(), batch.size());
+            if (written < 0) written = 0;
+            counters.messages++;
+            counters.bytes += written;
+            counters.dropped += batch.size() - written;
+        }
+
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+
+    close(slave);
+    close(master);
+}
+
+// Generate duration seconds of one device as fast as possible. One line per sample:
+// "G|A|M t x y z" for sensors and "Q t w x y z" for the true body-to-world attitude
+bool runRecord(const Options& options) {
+    std::ofstream file(options.output);
+    if (!file) {
+        std::cerr << "[LoadGen] Could not open " << options.output << std::endl;
+        return false;
+    }
+    file << "# IMULoadGen recording, gyro/accel/mag " << options.gyroRate << "/" << options.accelRate << "/"
+         << options.magRate << " Hz\n";
+
+    DeviceSimulator device(options, 0);
+    long steps = static_cast<long>(options.duration * options.gyroRate);
+    for (long i = 0; i < steps; i++) {
+        bool hasGyro, hasAccel, hasMag;
+        device.step(hasGyro, hasAccel, hasMag);
+        float t = device.time();
+        if (hasMag) file << "M " << t << " " << device.mag().x << " " << device.mag().y << " " << device.mag().z << "\n";
+        if (hasAccel) file << "A " << t << " " << device.accel().x << " " << device.accel().y << " " << device.accel().z << "\n";
+        if (hasGyro) file << "G " << t << " " << device.gyro().x << " " << device.gyro().y << " " << device.gyro().z << "\n";
+        const QuaternionF& q = device.attitude();
+        file << "Q " << t << " " << q.w << " " << q.x << " " << q.y << " " << q.z << "\n";
+    }
+    std::cout << "[LoadGen] Recorded " << steps << " gyro ticks to " << options.output << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (options.mode == Mode::Record) {
+        return runRecord(options) ? 0 : 1;
+    }
+
+    std::cout << "[LoadGen] " << options.devices << " device(s), gyro/accel/mag "
+              << options.gyroRate << "/" << options.accelRate << "/" << options.magRate << " Hz over "
+              << (options.mode == Mode::WebSocket ? "WebSocket" : options.mode == Mode::Udp ? "UDP" : "pty") << std::endl;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.devices; i++) {
+        if (options.mode == Mode::WebSocket) {
+            threads.emplace_back(runWebSocketDevice, std::cref(options), i);
+        } else if (options.mode == Mode::Udp) {
+            threads.emplace_back(runUdpDevice, std::cref(options), i);
+        } else {
+            threads.emplace_back(runPtyDevice, std::cref(options), i);
+        }
+    }
+
+    // Report throughput once per second until every device thread finishes
+    auto start = std::chrono::steady_clock::now();
+    uint64_t lastMessages = 0, lastBytes = 0;
+    while (stillRunning(start, options)) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t messages = counters.messages, bytes = counters.bytes;
+        std::cout << "[LoadGen] " << (messages - lastMessages) << " msg/s, " << (bytes - lastBytes) << " B/s"
+                  << " (corrupted " << counters.corrupted << ", dropped bytes " << counters.dropped
+                  << ", connect errors " << counters.connectErrors << ")" << std::endl;
+        lastMessages = messages;
+        lastBytes = bytes;
+    }
+    running = false;
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    std::cout << "[LoadGen] Sent " << counters.messages << " messages, " << counters.bytes << " bytes" << std::endl;
+    return 0;
+}
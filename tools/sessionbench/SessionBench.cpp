@@ -0,0 +1,215 @@
+// Session read loop benchmark
+//
+// Feeds a USBSession through a pty and a WebSocketSession over loopback as fast as they take
+// data, once with the callback read loops and once with the coroutine ones, and prints the
+// packets per second each sustains and the heap allocations per packet made on the io thread.
+// Packets are small (one mag, accel and gyro sample) so per-read overhead is visible; everything
+// behind the read loop (reorder stage, buffers, filter) runs as in the app.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+#include "ComplementaryFilter.h"
+#include "Prefilter.h"
+#include "communication/ClockSync.h"
+#include "communication/IngestStats.h"
+#include "communication/USBSession.h"
+#include "communication/WebSocketSession.h"
+#include "storage/FilterCheckpoint.h"
+#include "storage/SensorRecorder.h"
+
+// Heap allocations made by threads that opted in (the io thread)
+namespace {
+std::atomic<uint64_t> allocations{0};
+thread_local bool countAllocations = false;
+}
+
+void* operator new(std::size_t size) {
+    if (countAllocations) allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr float WARMUP_SECONDS = 0.5f;
+constexpr unsigned short WS_PORT = 8031;
+
+// Everything a session feeds, as set up in main.cpp
+struct Sinks {
+    GyroBuffer gyro; AccelBuffer accel; MagBuffer mag;
+    GyroTimesBuffer gyroTimes; AccelTimesBuffer accelTimes; MagTimesBuffer magTimes;
+    Structs3D::QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+    Structs3D::Vector3F accelVector = {0.0f, 0.0f, 0.0f};
+    ComplementaryFilter filter{attitude, accelVector};
+    Prefilter prefilter;
+    SensorRecorder recorder;
+    ClockSync clockSync;
+    IngestStats ingestStats;
+};
+
+void appendSample(std::vector<uint8_t>& packet, float x, float y, float z) {
+    for (float v : {x, y, z}) {
+        uint8_t bytes[sizeof(float)];
+        std::memcpy(bytes, &v, sizeof(float));
+        packet.insert(packet.end(), bytes, bytes + sizeof(float));
+    }
+}
+
+void appendSamples(std::vector<uint8_t>& packet) {
+    appendSample(packet, 30.0f, 0.0f, -20.0f);   // mag
+    appendSample(packet, 0.0f, 0.0f, 1.0f);      // accel
+    appendSample(packet, 0.001f, -0.002f, 0.0f); // gyro
+}
+
+const char* loopName(ReadLoop loop) {
+    return loop == ReadLoop::Coroutine ? "coroutine" : "callback";
+}
+
+// Run the io thread while 'feed' produces data, and measure once warmed up
+template <typename Feed>
+void measure(const char* transport, ReadLoop loop, float seconds, boost::asio::io_context& ioc, Sinks& sinks, Feed&& feed) {
+    std::atomic<bool> stop{false};
+    std::thread io([&ioc]() {
+        countAllocations = true;
+        ioc.run();
+    });
+    std::thread feeder([&]() { feed(stop); });
+
+    std::this_thread::sleep_for(std::chrono::duration<float>(WARMUP_SECONDS));
+    uint64_t messages = sinks.ingestStats.snapshot().messages;
+    uint64_t allocs = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::duration<float>(seconds));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    messages = sinks.ingestStats.snapshot().messages - messages;
+    allocs = allocations.load() - allocs;
+
+    // Stop the feeder first so it never blocks on a reader that is gone
+    stop = true;
+    feeder.join();
+    ioc.stop();
+    io.join();
+
+    std::printf("%-10s %-10s %10.0f packets/s  %6.2f allocations/packet\n", transport, loopName(loop),
+                messages / elapsed, messages > 0 ? static_cast<double>(allocs) / messages : 0.0);
+}
+
+void benchUSB(ReadLoop loop, float seconds) {
+    int master = -1, slave = -1;
+    char slaveName[256] = {0};
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) != 0) {
+        std::fprintf(stderr, "[SessionBench] openpty failed: %s\n", std::strerror(errno));
+        return;
+    }
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    // [0xAA][mag][accel][gyro counts][data], repeated so each write carries many packets
+    std::vector<uint8_t> chunk;
+    for (int i = 0; i < 64; i++) {
+        chunk.insert(chunk.end(), {SYNC_BYTE, 1, 1, 1});
+        appendSamples(chunk);
+    }
+
+    Sinks sinks;
+    boost::asio::io_context ioc;
+    FilterCheckpointer checkpointer(ioc, sinks.filter, "");   // No checkpoint files from the benchmark
+    auto session = std::make_shared<USBSession>(ioc, slaveName, sinks.gyro, sinks.accel, sinks.mag,
+        sinks.gyroTimes, sinks.accelTimes, sinks.magTimes, sinks.filter, sinks.prefilter, sinks.recorder,
+        sinks.clockSync, sinks.ingestStats, checkpointer);
+    session->setReadLoop(loop);
+    session->run();
+
+    measure("USB", loop, seconds, ioc, sinks, [&](std::atomic<bool>& stop) {
+        std::size_t offset = 0;
+        while (!stop) {
+            ssize_t written = write(master, chunk.data() + offset, chunk.size() - offset);
+            if (written <= 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                continue;
+            }
+            offset = (offset + written) % chunk.size();
+        }
+    });
+
+    session.reset();
+    close(master);
+    close(slave);
+}
+
+void benchWebSocket(ReadLoop loop, float seconds) {
+    std::vector<uint8_t> message = {MessageFormat::SYNC, MessageFormat::MAG | MessageFormat::ACCEL | MessageFormat::GYRO};
+    appendSamples(message);
+
+    Sinks sinks;
+    boost::asio::io_context ioc;
+    FilterCheckpointer checkpointer(ioc, sinks.filter, "");
+    WebSocketSession session(ioc, WS_PORT, sinks.gyro, sinks.accel, sinks.mag,
+        sinks.gyroTimes, sinks.accelTimes, sinks.magTimes, sinks.filter, sinks.prefilter, sinks.recorder,
+        sinks.clockSync, sinks.ingestStats, checkpointer);
+    session.setReadLoop(loop);
+
+    measure("WebSocket", loop, seconds, ioc, sinks, [&](std::atomic<bool>& stop) {
+        try {
+            boost::asio::io_context clientIoc;
+            boost::beast::websocket::stream<boost::asio::ip::tcp::socket> ws(clientIoc);
+            ws.next_layer().connect({boost::asio::ip::make_address("127.0.0.1"), WS_PORT});
+            ws.handshake("127.0.0.1", "/");
+            ws.binary(true);
+            while (!stop) {
+                ws.write(boost::asio::buffer(message));
+            }
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "[SessionBench] WebSocket client: %s\n", e.what());
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    float seconds = argc > 1 ? std::stof(argv[1]) : 3.0f;
+
+    // Sessions log connections and batches; keep the output to the results
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    std::printf("%.1f s per run, one mag/accel/gyro sample per packet\n", seconds);
+    for (ReadLoop loop : {ReadLoop::Callback, ReadLoop::Coroutine}) {
+        benchUSB(loop, seconds);
+    }
+    for (ReadLoop loop : {ReadLoop::Callback, ReadLoop::Coroutine}) {
+        benchWebSocket(loop, seconds);
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    return 0;
+}
@@ -0,0 +1,291 @@
+// Offline complementary filter gain tuner
+//
+// Replays a recording through many ComplementaryFilter instances with different
+// KpRollPitch/KiRollPitch/KpYaw/KiYaw sets: a log-spaced grid first, then a coordinate-descent
+// refinement around the best grid point. Runs are spread over a work-stealing ThreadPool.
+// With reference attitudes ("Q" lines, e.g. from IMULoadGen --mode record) a run is scored by
+// its RMS attitude error; without them by the RMS a-priori gravity innovation (angle between
+// measured and predicted gravity before each accel update free of linear acceleration, i.e.
+// with a magnitude close to 1 g). See README "Gain Tuner".
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ComplementaryFilter.h"
+#include "SensorRates.h"
+#include "util/ThreadPool.h"
+
+using namespace Math3D;
+
+namespace {
+
+struct Options {
+    std::string path;
+    int grid = 6;               // Values per gain in the grid search
+    int refineIterations = 30;
+    float settle = 5.0f;        // Seconds of recording excluded from the score (alignment, convergence)
+    unsigned int threads = std::thread::hardware_concurrency();
+    SensorRates rates;          // Sample rates of the recording
+};
+
+struct Event {
+    char type;      // G, A, M or Q
+    float t;
+    float v[4];
+};
+
+struct Range {
+    float min, max;
+};
+
+// Search ranges for Kp roll/pitch, Ki roll/pitch, Kp yaw, Ki yaw (log-spaced)
+constexpr Range ranges[4] = {{0.1f, 30.0f}, {0.001f, 2.0f}, {0.1f, 30.0f}, {0.001f, 2.0f}};
+
+constexpr float GRAVITY_ONLY_TOLERANCE = 0.05f;   // Of the gravity magnitude measured at alignment (g or m/s^2 recordings)
+
+void printUsage() {
+    std::cout << "Usage: IMUTuner <recording.txt> [options]\n"
+              << "  --grid N          Values per gain in the grid search (default 6, N^4 runs)\n"
+              << "  --refine N        Coordinate-descent iterations (default 30)\n"
+              << "  --settle S        Seconds excluded from the score at the start (default 5)\n"
+              << "  --threads N       Worker threads (default: hardware concurrency)\n"
+              << "  --gyro-rate HZ    Gyro sample rate of the recording (default gyroFreq)\n"
+              << "  --accel-rate HZ   Accel sample rate of the recording (default accelFreq)\n"
+              << "Recording lines: 'G|A|M t x y z' samples, optional 'Q t w x y z' reference attitude.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            options.path = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "[Tuner] Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--grid") options.grid = std::stoi(value);
+        else if (arg == "--refine") options.refineIterations = std::stoi(value);
+        else if (arg == "--settle") options.settle = std::stof(value);
+        else if (arg == "--threads") options.threads = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--gyro-rate") options.rates.gyro = std::stof(value);
+        else if (arg == "--accel-rate") options.rates.accel = std::stof(value);
+        else {
+            std::cerr << "[Tuner] Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.path.empty() || options.grid < 2 || options.rates.gyro <= 0.0f || options.rates.accel <= 0.0f) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+bool loadRecording(const std::string& path, std::vector<Event>& events, bool& hasReference) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "[Tuner] Could not open " << path << std::endl;
+        return false;
+    }
+    hasReference = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream stream(line);
+        Event event = {};
+        stream >> event.type >> event.t >> event.v[0] >> event.v[1] >> event.v[2];
+        if (event.type == 'Q') stream >> event.v[3];
+        if (!stream || (event.type != 'G' && event.type != 'A' && event.type != 'M' && event.type != 'Q')) continue;
+        hasReference |= event.type == 'Q';
+        events.push_back(event);
+    }
+    return !events.empty();
+}
+
+float angleBetween(const QuaternionF& a, const QuaternionF& b) {
+    float dot = std::abs(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
+    return 2.0f * std::acos(std::min(dot, 1.0f));
+}
+
+// Replay the whole recording with one gain set; lower is better
+float score(const std::vector<Event>& events, bool hasReference, const ComplementaryFilter::Gains& gains,
+            const Options& options) {
+    QuaternionF attitude = {1.0f, 0.0f, 0.0f, 0.0f};
+    Vector3F magVector = {0.0f, 0.0f, 0.0f};
+    ComplementaryFilter filter(attitude, magVector, options.rates);
+    filter.setGains(gains);
+
+    double sumSquares = 0.0;
+    std::size_t terms = 0;
+    float start = events.front().t;
+
+    for (const Event& event : events) {
+        bool scored = event.t - start >= options.settle && filter.getAlignmentStatus().aligned;
+        switch (event.type) {
+            case 'G':
+                filter.updateWithGyro(event.v[0], event.v[1], event.v[2], event.t);
+                break;
+
+            case 'A':
+                if (scored && !hasReference) {
+                    Vector3F accel(event.v[0], event.v[1], event.v[2]);
+                    float norm = std::sqrt(dotProduct(accel, accel));
+                    if (std::abs(norm / filter.getGravityMagnitude() - 1.0f) < GRAVITY_ONLY_TOLERANCE) {
+                        Vector3F predicted = rotateVectorByQuaternion(Vector3F(0.0f, 0.0f, -1.0f), conjugateQuaternion(attitude));
+                        float cosine = std::clamp(dotProduct(accel, predicted) / norm, -1.0f, 1.0f);
+                        float error = std::acos(cosine);
+                        sumSquares += error * error;
+                        terms++;
+                    }
+                }
+                filter.updateWithAccel(event.v[0], event.v[1], event.v[2]);
+                break;
+
+            case 'M':
+                filter.updateWithMag(event.v[0], event.v[1], event.v[2]);
+                break;
+
+            case 'Q':
+                if (scored) {
+                    float error = angleBetween(attitude, QuaternionF(event.v[0], event.v[1], event.v[2], event.v[3]));
+                    sumSquares += error * error;
+                    terms++;
+                }
+                break;
+        }
+    }
+
+    if (terms == 0 || !std::isfinite(sumSquares)) return std::numeric_limits<float>::infinity();
+    return static_cast<float>(std::sqrt(sumSquares / terms)) * 57.29578f;   // Degrees
+}
+
+float& gain(ComplementaryFilter::Gains& gains, int index) {
+    switch (index) {
+        case 0: return gains.kpRollPitch;
+        case 1: return gains.kiRollPitch;
+        case 2: return gains.kpYaw;
+        default: return gains.kiYaw;
+    }
+}
+
+struct Candidate {
+    ComplementaryFilter::Gains gains;
+    float score;
+};
+
+// Score every candidate in parallel
+void evaluate(ThreadPool& pool, const std::vector<Event>& events, bool hasReference, const Options& options,
+              std::vector<Candidate>& candidates, std::size_t& runs) {
+    pool.parallelFor(candidates.size(), [&](std::size_t i) {
+        candidates[i].score = score(events, hasReference, candidates[i].gains, options);
+    });
+    runs += candidates.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Event> events;
+    bool hasReference = false;
+    if (!loadRecording(options.path, events, hasReference)) {
+        std::cerr << "[Tuner] No samples in " << options.path << std::endl;
+        return 1;
+    }
+    std::printf("[Tuner] %zu events, %.1f s, scoring by %s\n", events.size(), events.back().t - events.front().t,
+                hasReference ? "RMS attitude error vs reference" : "RMS a-priori gravity innovation");
+
+    // The filter logs alignment and rejected samples; thousands of runs would flood the console
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    ThreadPool pool(options.threads);
+    std::size_t runs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // Grid search over log-spaced values of all four gains
+    float currentScore = score(events, hasReference, ComplementaryFilter::Gains(), options);
+    runs++;
+
+    std::vector<Candidate> candidates;
+    std::size_t total = 1;
+    for (int g = 0; g < 4; g++) total *= options.grid;
+    candidates.resize(total);
+    for (std::size_t c = 0; c < total; c++) {
+        std::size_t rest = c;
+        for (int g = 0; g < 4; g++) {
+            int step = static_cast<int>(rest % options.grid);
+            rest /= options.grid;
+            float fraction = static_cast<float>(step) / (options.grid - 1);
+            gain(candidates[c].gains, g) = ranges[g].min * std::pow(ranges[g].max / ranges[g].min, fraction);
+        }
+    }
+    evaluate(pool, events, hasReference, options, candidates, runs);
+    Candidate best = *std::min_element(candidates.begin(), candidates.end(),
+                                       [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+    float gridScore = best.score;
+    if (!std::isfinite(gridScore)) {
+        std::cout.rdbuf(coutBuffer);
+        std::cerr << "[Tuner] No gain set could be scored: the filter never aligned, or no "
+                  << (hasReference ? "reference attitude" : "gravity-only accel sample") << " came after --settle" << std::endl;
+        return 1;
+    }
+
+    // Coordinate descent: try scaling each gain up and down (all in parallel), keep the best move,
+    // and shrink the step once no move improves the score
+    float factor = std::pow(ranges[0].max / ranges[0].min, 1.0f / (options.grid - 1));
+    for (int iteration = 0; iteration < options.refineIterations && factor > 1.01f; iteration++) {
+        candidates.clear();
+        for (int g = 0; g < 4; g++) {
+            for (float scale : {factor, 1.0f / factor, std::sqrt(factor), 1.0f / std::sqrt(factor)}) {
+                Candidate candidate = best;
+                float& value = gain(candidate.gains, g);
+                value = std::clamp(value * scale, ranges[g].min * 0.1f, ranges[g].max * 10.0f);
+                candidates.push_back(candidate);
+            }
+        }
+        evaluate(pool, events, hasReference, options, candidates, runs);
+        const Candidate& move = *std::min_element(candidates.begin(), candidates.end(),
+                                                  [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+        if (move.score < best.score) {
+            best = move;
+        } else {
+            factor = std::sqrt(factor);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout.rdbuf(coutBuffer);
+
+    std::printf("[Tuner] %zu filter runs in %.2f s on %zu threads: %.1f runs/s\n",
+                runs, seconds, pool.size() + 1, runs / seconds);
+    std::printf("[Tuner] Config.h gains %.4f deg, grid best %.4f deg, refined %.4f deg\n",
+                currentScore, gridScore, best.score);
+    std::printf("\n// Config.h\n");
+    std::printf("const float KpRollPitch = %.4gf;\n", best.gains.kpRollPitch);
+    std::printf("const float KiRollPitch = %.4gf;\n", best.gains.kiRollPitch);
+    std::printf("const float KpYaw = %.4gf;\n", best.gains.kpYaw);
+    std::printf("const float KiYaw = %.4gf;\n", best.gains.kiYaw);
+    return 0;
+}